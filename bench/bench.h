@@ -0,0 +1,138 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "common.h"
+#include "vfs.h"
+
+#include <time.h>
+
+// Every benchmark works in its own vfs root under the current directory,
+// which is wiped and made again on each run
+
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline FS_Archive bench_open_sdmc(const char * root)
+{
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf '%s' && mkdir -p '%s/sdmc'", root, root);
+    if(system(command) != 0)
+        return 0;
+
+    setenv("ANEMONE_VFS_ROOT", root, 1);
+    FS_Archive archive = 0;
+    if(R_FAILED(vfs_open_archive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""))))
+        return 0;
+    return archive;
+}
+
+static inline bool bench_write_file(FS_Archive archive, const char * path, const void * buf, u32 size)
+{
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_WRITE | FS_OPEN_CREATE)))
+        return false;
+
+    Result res = vfs_set_size(handle, size);
+    if(R_SUCCEEDED(res))
+        res = vfs_write(handle, NULL, 0, buf, size, FS_WRITE_FLUSH);
+    vfs_close(handle);
+    return R_SUCCEEDED(res);
+}
+
+// Reads a file from the host filesystem, outside of the vfs root
+static inline u8 * bench_load_host_file(const char * path, u32 * size)
+{
+    FILE * file = fopen(path, "rb");
+    if(file == NULL)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    const long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8 * buf = len > 0 ? malloc(len) : NULL;
+    if(buf != NULL && fread(buf, 1, len, file) != (size_t)len)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(file);
+
+    *size = buf != NULL ? len : 0;
+    return buf;
+}
+
+static inline u32 bench_random(u32 * state)
+{
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+// Something shaped like a body: runs of solid colour, gradients, noisy
+// texture data and pieces repeated from further back than the window
+static inline u8 * bench_generate_body(u32 size, u32 seed)
+{
+    u8 * body = malloc(size);
+    u32 state = seed;
+    u32 pos = 0;
+    while(pos < size)
+    {
+        const u32 len = min(size - pos, 0x200 + bench_random(&state) % 0x2000);
+        switch(bench_random(&state) % 4)
+        {
+            case 0:
+                memset(body + pos, bench_random(&state), len);
+                break;
+            case 1:
+                for(u32 i = 0; i < len; i++)
+                    body[pos + i] = (i >> 3) + (i & 1 ? 0x40 : 0);
+                break;
+            case 2:
+                for(u32 i = 0; i < len; i++)
+                    body[pos + i] = 0x80 + bench_random(&state) % 8;
+                break;
+            default:
+            {
+                const u32 from = pos > len ? bench_random(&state) % (pos - len) : 0;
+                for(u32 i = 0; i < len; i++)
+                    body[pos + i] = pos > len ? body[from + i] : (u8)i;
+                break;
+            }
+        }
+        pos += len;
+    }
+
+    return body;
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef BENCH_THEME_H
+#define BENCH_THEME_H
+
+#include "bench.h"
+#include "bench_zip.h"
+#include "loading.h"
+#include "lz.h"
+
+// Themes like the ones users put in /Themes: an info.smdh, an LZ11
+// body_LZ.bin and a bgm.bcstm, zipped or in a folder. Theme index is
+// named "Theme <index>" and its files are generated from index, so they
+// can be made again to check what was loaded or installed
+
+typedef struct {
+    Icon_s smdh;
+    u8 * body; // LZ11, as in body_LZ.bin
+    u32 body_size;
+    u8 * bgm;
+    u32 bgm_size;
+} Bench_Theme_s;
+
+static inline void bench_ascii_to_utf16(u16 * out, size_t out_len, const char * in)
+{
+    size_t i = 0;
+    for(; i + 1 < out_len && in[i]; i++)
+        out[i] = (u8)in[i];
+    out[i] = 0;
+}
+
+static inline void bench_fill_smdh(Icon_s * smdh, int index)
+{
+    memset(smdh, 0, sizeof(Icon_s));
+    memcpy(smdh->_padding1, "SMDH", 4);
+
+    char text[0x80];
+    snprintf(text, sizeof(text), "Theme %04i", index);
+    bench_ascii_to_utf16(smdh->name, 0x40, text);
+    snprintf(text, sizeof(text), "Generated theme number %i, for the host benchmarks", index);
+    bench_ascii_to_utf16(smdh->desc, 0x80, text);
+    snprintf(text, sizeof(text), "Author %i", index % 37);
+    bench_ascii_to_utf16(smdh->author, 0x40, text);
+
+    // icons look like pictures: smooth areas with some noise
+    u32 state = index + 1;
+    for(int i = 0; i < 24 * 24; i++)
+        smdh->small_icon[i] = (i / 24 * 0x841) + (bench_random(&state) & 0x3);
+    for(int i = 0; i < 48 * 48; i++)
+        smdh->big_icon[i] = (i / 48 * 0x420) + ((i % 48) << 5) + (bench_random(&state) & 0x7);
+}
+
+// body_size and bgm_size are the uncompressed sizes, a bgm_size of 0 leaves the bgm out
+static inline bool bench_make_theme(Bench_Theme_s * theme, int index, u32 body_size, u32 bgm_size)
+{
+    memset(theme, 0, sizeof(Bench_Theme_s));
+    bench_fill_smdh(&theme->smdh, index);
+
+    u8 * body = bench_generate_body(body_size, index + 1);
+    theme->body = malloc(lz11_compress_bound(body_size));
+    if(body != NULL && theme->body != NULL)
+    {
+        // the BGM flag is left for the installs with a bgm to set
+        body[5] = 0;
+        theme->body_size = lz11_compress(body, body_size, theme->body, LZ11_LEVEL_FASTEST);
+    }
+    free(body);
+
+    if(bgm_size != 0)
+    {
+        theme->bgm = bench_generate_body(bgm_size, ~index);
+        theme->bgm_size = theme->bgm != NULL ? bgm_size : 0;
+        // stereo, so installing it doesn't warn
+        if(theme->bgm != NULL)
+            theme->bgm[0x62] = 0;
+    }
+
+    return theme->body_size != 0 && theme->bgm_size == bgm_size;
+}
+
+static inline void bench_free_theme(Bench_Theme_s * theme)
+{
+    free(theme->body);
+    free(theme->bgm);
+}
+
+// Writes the theme as dir/name.zip, with the smdh deflated like most zip tools would, or as the folder dir/name
+static inline bool bench_write_theme(FS_Archive archive, const char * dir, const char * name, const Bench_Theme_s * theme, bool zipped)
+{
+    char path[0x100];
+    if(!zipped)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, name);
+        if(R_FAILED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, path))))
+            return false;
+
+        snprintf(path, sizeof(path), "%s/%s/info.smdh", dir, name);
+        bool ok = bench_write_file(archive, path, &theme->smdh, sizeof(Icon_s));
+        snprintf(path, sizeof(path), "%s/%s/body_LZ.bin", dir, name);
+        ok = ok && bench_write_file(archive, path, theme->body, theme->body_size);
+        snprintf(path, sizeof(path), "%s/%s/bgm.bcstm", dir, name);
+        return ok && (theme->bgm_size == 0 || bench_write_file(archive, path, theme->bgm, theme->bgm_size));
+    }
+
+    u8 deflated[sizeof(Icon_s) + 0x100];
+    const u32 deflated_size = bench_deflate_raw((const u8 *)&theme->smdh, sizeof(Icon_s), deflated, sizeof(deflated));
+    Bench_Zip_Member_s members[] = {
+        {"info.smdh", 8, deflated, deflated_size, sizeof(Icon_s), crc32(0, (const u8 *)&theme->smdh, sizeof(Icon_s))},
+        {"body_LZ.bin", 0, theme->body, theme->body_size, theme->body_size, crc32(0, theme->body, theme->body_size)},
+        {"bgm.bcstm", 0, theme->bgm, theme->bgm_size, theme->bgm_size, theme->bgm_size != 0 ? crc32(0, theme->bgm, theme->bgm_size) : 0},
+    };
+
+    u32 zip_size = 0;
+    u8 * zip = bench_build_zip(members, theme->bgm_size != 0 ? 3 : 2, &zip_size);
+    snprintf(path, sizeof(path), "%s/%s.zip", dir, name);
+    const bool ok = deflated_size != 0 && zip != NULL && bench_write_file(archive, path, zip, zip_size);
+    free(zip);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef BENCH_ZIP_H
+#define BENCH_ZIP_H
+
+#include "common.h"
+
+#include <zlib.h>
+
+// Writes zips in memory for the benchmarks to read back: no comment, no extra fields, no zip64
+
+static inline void put16(u8 * p, u16 v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void put32(u8 * p, u32 v)
+{
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+typedef struct {
+    const char * name;
+    u16 method;
+    const u8 * data; // as stored
+    u32 compressed_size;
+    u32 size;
+    u32 crc;
+    u32 offset;
+} Bench_Zip_Member_s;
+
+// A zip with the members in order, then the central directory
+static inline u8 * bench_build_zip(Bench_Zip_Member_s * members, int count, u32 * zip_size)
+{
+    u32 size = 22;
+    for(int i = 0; i < count; i++)
+        size += (30 + 46) + 2 * strlen(members[i].name) + members[i].compressed_size;
+
+    u8 * zip = calloc(1, size);
+    u32 pos = 0;
+    for(int i = 0; i < count; i++)
+    {
+        const u32 name_length = strlen(members[i].name);
+        members[i].offset = pos;
+        put32(zip + pos, 0x04034B50);
+        put16(zip + pos + 4, 20);
+        put16(zip + pos + 8, members[i].method);
+        put32(zip + pos + 14, members[i].crc);
+        put32(zip + pos + 18, members[i].compressed_size);
+        put32(zip + pos + 22, members[i].size);
+        put16(zip + pos + 26, name_length);
+        memcpy(zip + pos + 30, members[i].name, name_length);
+        pos += 30 + name_length;
+        memcpy(zip + pos, members[i].data, members[i].compressed_size);
+        pos += members[i].compressed_size;
+    }
+
+    const u32 cd_offset = pos;
+    for(int i = 0; i < count; i++)
+    {
+        const u32 name_length = strlen(members[i].name);
+        put32(zip + pos, 0x02014B50);
+        put16(zip + pos + 4, 20);
+        put16(zip + pos + 6, 20);
+        put16(zip + pos + 10, members[i].method);
+        put32(zip + pos + 16, members[i].crc);
+        put32(zip + pos + 20, members[i].compressed_size);
+        put32(zip + pos + 24, members[i].size);
+        put16(zip + pos + 28, name_length);
+        put32(zip + pos + 42, members[i].offset);
+        memcpy(zip + pos + 46, members[i].name, name_length);
+        pos += 46 + name_length;
+    }
+
+    put32(zip + pos, 0x06054B50);
+    put16(zip + pos + 8, count);
+    put16(zip + pos + 10, count);
+    put32(zip + pos + 12, pos - cd_offset);
+    put32(zip + pos + 16, cd_offset);
+    pos += 22;
+
+    *zip_size = pos;
+    return zip;
+}
+
+static inline u32 bench_deflate_raw(const u8 * in, u32 size, u8 * out, u32 out_size)
+{
+    z_stream stream = {0};
+    if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return 0;
+
+    stream.next_in = (u8 *)in;
+    stream.avail_in = size;
+    stream.next_out = out;
+    stream.avail_out = out_size;
+    const bool ok = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+    deflateEnd(&stream);
+    return ok ? stream.total_out : 0;
+}
+
+#endif
@@ -0,0 +1,353 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Stand-in for the parts of libctru the app's file, list and install code
+// uses, so it can be built for the host. vfs.c provides fsMakePath and does
+// its I/O with POSIX calls, ctru.c has the rest: threads and locks on
+// pthreads, the text conversions, and the system services answering like a
+// USA console with one account. What the benchmarks never get to just fails.
+
+#ifndef BENCH_HOST_3DS_H
+#define BENCH_HOST_3DS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef volatile u32 vu32;
+
+typedef s32 Result;
+typedef u32 Handle;
+
+#define BIT(n) (1U << (n))
+#define U64_MAX UINT64_MAX
+
+#define SYSCLOCK_ARM11 268111856
+
+//---------------------------------------------------------------------------------
+// Results
+//---------------------------------------------------------------------------------
+
+#define R_FAILED(res) ((res) < 0)
+#define R_SUCCEEDED(res) ((res) >= 0)
+#define R_SUMMARY(res) (((res) >> 21) & 0x3F)
+#define MAKERESULT(level, summary, module, description) \
+    (((u32)((level) & 0x1F) << 27) | (((summary) & 0x3F) << 21) | (((module) & 0xFF) << 10) | ((description) & 0x3FF))
+
+enum {
+    RL_USAGE = 28,
+    RL_PERMANENT = 27,
+    RL_FATAL = 31,
+};
+
+enum {
+    RS_OUTOFRESOURCE = 3,
+    RS_NOTFOUND = 4,
+    RS_INVALIDSTATE = 5,
+    RS_NOTSUPPORTED = 6,
+    RS_INVALIDARG = 7,
+    RS_CANCELED = 9,
+    RS_INTERNAL = 11,
+};
+
+enum {
+    RM_COMMON = 0,
+    RM_UTIL = 2,
+    RM_FS = 17,
+    RM_APPLICATION = 254,
+};
+
+enum {
+    RD_INVALID_SELECTION = 1000,
+    RD_TOO_LARGE = 1001,
+    RD_INVALID_SIZE = 1004,
+    RD_OUT_OF_MEMORY = 1011,
+    RD_NOT_IMPLEMENTED = 1012,
+    RD_INVALID_HANDLE = 1015,
+    RD_NOT_FOUND = 1018,
+    RD_CANCEL_REQUESTED = 1019,
+    RD_INVALID_RESULT_VALUE = 1023,
+};
+
+//---------------------------------------------------------------------------------
+// Threads and synchronization
+//---------------------------------------------------------------------------------
+
+#define CUR_THREAD_HANDLE 0xFFFF8000
+
+typedef struct Thread_tag * Thread;
+typedef void (*ThreadFunc)(void * arg);
+
+typedef pthread_mutex_t LightLock;
+typedef pthread_cond_t CondVar;
+
+typedef struct {
+    s32 state;
+    LightLock lock;
+    CondVar signaled;
+} LightEvent;
+
+// Fails for a core_id past the host's processors, like it does on the cores the app can't use
+Thread threadCreate(ThreadFunc entrypoint, void * arg, size_t stack_size, int prio, int core_id, bool detached);
+Result threadJoin(Thread thread, u64 timeout_ns);
+void threadFree(Thread thread);
+
+void LightLock_Init(LightLock * lock);
+void LightLock_Lock(LightLock * lock);
+void LightLock_Unlock(LightLock * lock);
+
+void CondVar_Init(CondVar * cv);
+void CondVar_Wait(CondVar * cv, LightLock * lock);
+void CondVar_Signal(CondVar * cv);
+void CondVar_Broadcast(CondVar * cv);
+
+Result svcGetThreadPriority(s32 * out, Handle handle);
+u64 svcGetSystemTick(void);
+Result svcSendSyncRequest(Handle session);
+u32 * getThreadCommandBuffer(void);
+
+//---------------------------------------------------------------------------------
+// Filesystem
+//---------------------------------------------------------------------------------
+
+typedef u64 FS_Archive;
+
+typedef enum {
+    ARCHIVE_EXTDATA = 0x00000006,
+    ARCHIVE_SDMC = 0x00000009,
+    ARCHIVE_SAVEDATA_AND_CONTENT = 0x2345678A,
+} FS_ArchiveID;
+
+typedef enum {
+    MEDIATYPE_NAND = 0,
+    MEDIATYPE_SD = 1,
+    MEDIATYPE_GAME_CARD = 2,
+} FS_MediaType;
+
+typedef enum {
+    PATH_INVALID = 0,
+    PATH_EMPTY = 1,
+    PATH_BINARY = 2,
+    PATH_ASCII = 3,
+    PATH_UTF16 = 4,
+} FS_PathType;
+
+typedef struct {
+    FS_PathType type;
+    u32 size;
+    const void * data;
+} FS_Path;
+
+enum {
+    FS_OPEN_READ = 1 << 0,
+    FS_OPEN_WRITE = 1 << 1,
+    FS_OPEN_CREATE = 1 << 2,
+};
+
+enum {
+    FS_WRITE_FLUSH = 1 << 0,
+    FS_WRITE_UPDATE_TIME = 1 << 8,
+};
+
+enum {
+    FS_ATTRIBUTE_DIRECTORY = 1 << 0,
+    FS_ATTRIBUTE_HIDDEN = 1 << 8,
+    FS_ATTRIBUTE_ARCHIVE = 1 << 16,
+    FS_ATTRIBUTE_READ_ONLY = 1 << 24,
+};
+
+typedef struct {
+    u16 name[0x106];
+    char shortName[0x0A];
+    char shortExt[0x04];
+    u8 valid;
+    u8 reserved;
+    u32 attributes;
+    u64 fileSize;
+} FS_DirectoryEntry;
+
+FS_Path fsMakePath(FS_PathType type, const void * path);
+Handle * fsGetSessionHandle(void);
+Result FSUSER_UpdateSha256Context(const void * data, u32 inputSize, u8 * hash);
+
+Result romfsInit(void);
+Result romfsMountFromFile(Handle fd, u32 offset, const char * name);
+Result romfsUnmount(const char * name);
+
+//---------------------------------------------------------------------------------
+// Text
+//---------------------------------------------------------------------------------
+
+// Like libctru's: stop at a 0 in the input, write at most len units without a
+// terminator, and return how many units the whole input takes
+ssize_t utf8_to_utf16(u16 * out, const u8 * in, size_t len);
+ssize_t utf16_to_utf8(u8 * out, const u16 * in, size_t len);
+ssize_t utf16_to_utf32(u32 * out, const u16 * in, size_t len);
+
+//---------------------------------------------------------------------------------
+// System services
+//---------------------------------------------------------------------------------
+
+typedef enum {
+    CFG_REGION_JPN = 0,
+    CFG_REGION_USA = 1,
+    CFG_REGION_EUR = 2,
+    CFG_REGION_AUS = 3,
+    CFG_REGION_CHN = 4,
+    CFG_REGION_KOR = 5,
+    CFG_REGION_TWN = 6,
+} CFG_Region;
+
+typedef enum {
+    CFG_LANGUAGE_JP = 0,
+    CFG_LANGUAGE_EN = 1,
+    CFG_LANGUAGE_FR = 2,
+    CFG_LANGUAGE_DE = 3,
+    CFG_LANGUAGE_IT = 4,
+    CFG_LANGUAGE_ES = 5,
+    CFG_LANGUAGE_ZH = 6,
+    CFG_LANGUAGE_KO = 7,
+    CFG_LANGUAGE_NL = 8,
+    CFG_LANGUAGE_PT = 9,
+    CFG_LANGUAGE_RU = 10,
+    CFG_LANGUAGE_TW = 11,
+} CFG_Language;
+
+Result CFGU_SecureInfoGetRegion(u8 * region);
+Result CFGU_GetSystemLanguage(u8 * language);
+Result CFGU_GetConfigInfoBlk2(u32 size, u32 blkID, void * outData);
+
+typedef struct {
+    u16 index;
+    u16 type;
+    u32 contentId;
+    u64 size;
+    u8 flags;
+    u8 padding[7];
+} AM_ContentInfo;
+
+enum {
+    AM_CONTENT_INSTALLED = BIT(0),
+    AM_CONTENT_OWNED = BIT(1),
+};
+
+Result amAppInit(void);
+void amExit(void);
+Result AMAPP_GetDLCContentInfoCount(u32 * count, FS_MediaType mediatype, u64 titleID);
+Result AMAPP_ListDLCContentInfos(u32 * contentInfoRead, FS_MediaType mediatype, u64 titleID, u32 contentInfoCount, u32 offset, AM_ContentInfo * contentInfos);
+
+#define ACT_DEFAULT_ACCOUNT 0xFE
+#define INFO_TYPE_PRINCIPAL_ID 0xC
+
+Result actInit(bool forceService);
+void actExit(void);
+Result ACT_Initialize(u32 sdkVersion, u32 sharedMemSize, u32 sharedMem);
+Result ACT_GetAccountInfo(void * out, u32 size, u8 accountSlot, u32 infoType);
+
+//---------------------------------------------------------------------------------
+// Software keyboard, which never gets any input on the host
+//---------------------------------------------------------------------------------
+
+typedef struct {
+    int type;
+} SwkbdState;
+
+typedef enum {
+    SWKBD_TYPE_NORMAL = 0,
+    SWKBD_TYPE_QWERTY,
+    SWKBD_TYPE_NUMPAD,
+    SWKBD_TYPE_WESTERN,
+} SwkbdType;
+
+typedef enum {
+    SWKBD_BUTTON_LEFT = 0,
+    SWKBD_BUTTON_MIDDLE,
+    SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_CONFIRM = SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_NONE,
+} SwkbdButton;
+
+typedef enum {
+    SWKBD_ANYTHING = 0,
+    SWKBD_NOTEMPTY,
+    SWKBD_NOTEMPTY_NOTBLANK,
+    SWKBD_NOTBLANK,
+    SWKBD_FIXEDLEN,
+} SwkbdValidInput;
+
+enum {
+    SWKBD_FILTER_CALLBACK = BIT(5),
+};
+
+enum {
+    SWKBD_DARKEN_TOP_SCREEN = BIT(1),
+    SWKBD_PREDICTIVE_INPUT = BIT(2),
+};
+
+typedef enum {
+    SWKBD_CALLBACK_OK = 0,
+    SWKBD_CALLBACK_CLOSE,
+    SWKBD_CALLBACK_CONTINUE,
+} SwkbdCallbackResult;
+
+typedef SwkbdCallbackResult (*SwkbdCallbackFn)(void * user, const char ** ppMessage, const char * text, size_t textlen);
+
+void swkbdInit(SwkbdState * swkbd, SwkbdType type, int numButtons, int maxTextLength);
+void swkbdSetFeatures(SwkbdState * swkbd, u32 features);
+void swkbdSetHintText(SwkbdState * swkbd, const char * text);
+void swkbdSetButton(SwkbdState * swkbd, SwkbdButton button, const char * text, bool submit);
+void swkbdSetValidation(SwkbdState * swkbd, SwkbdValidInput validInput, u32 filterFlags, u32 maxDigits);
+void swkbdSetFilterCallback(SwkbdState * swkbd, SwkbdCallbackFn callback, void * user);
+SwkbdButton swkbdInputText(SwkbdState * swkbd, char * buf, size_t bufsize);
+int swkbdGetResult(SwkbdState * swkbd);
+
+//---------------------------------------------------------------------------------
+// Sound, only for the types music.h keeps
+//---------------------------------------------------------------------------------
+
+typedef struct {
+    void * data_vaddr;
+    u32 nsamples;
+    int status;
+} ndspWaveBuf;
+
+typedef struct {
+    u16 index;
+    s16 history0;
+    s16 history1;
+} ndspAdpcmData;
+
+#endif
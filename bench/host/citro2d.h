@@ -0,0 +1,52 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Stand-in for citro2d: the image types the lists hand to the UI, and the
+// colour packing the placeholder colours and the config use
+
+#ifndef BENCH_HOST_CITRO2D_H
+#define BENCH_HOST_CITRO2D_H
+
+typedef struct {
+    u16 width;
+    u16 height;
+    float left;
+    float top;
+    float right;
+    float bottom;
+} Tex3DS_SubTexture;
+
+typedef struct {
+    C3D_Tex * tex;
+    const Tex3DS_SubTexture * subtex;
+} C2D_Image;
+
+static inline u32 C2D_Color32(u8 r, u8 g, u8 b, u8 a)
+{
+    return r | (g << 8) | (b << 16) | ((u32)a << 24);
+}
+
+#endif
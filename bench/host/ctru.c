@@ -0,0 +1,494 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The libctru calls bench/host/3ds.h declares, for the app code the host
+// benchmarks link
+
+#include "common.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#define HOST_RES_UNSUPPORTED MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_APPLICATION, RD_NOT_IMPLEMENTED)
+
+// What ACT_GetAccountInfo gives for the principal ID of the only account
+#define HOST_NNID 0x0BADBADB
+
+//---------------------------------------------------------------------------------
+// Threads and synchronization
+//---------------------------------------------------------------------------------
+
+struct Thread_tag {
+    pthread_t id;
+    ThreadFunc entrypoint;
+    void * arg;
+};
+
+static void * thread_start(void * arg)
+{
+    Thread thread = (Thread)arg;
+    thread->entrypoint(thread->arg);
+    return NULL;
+}
+
+// The cores threads can be made on: the host's, or ANEMONE_HOST_CORES of them,
+// which is how the benchmarks compare consoles with more or fewer cores
+static long host_cores(void)
+{
+    const char * cores = getenv("ANEMONE_HOST_CORES");
+    return cores != NULL ? atol(cores) : sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+// stack_size and prio are the 3DS's business: host threads get the default
+// stack, which sanitizers need, and the host's scheduling
+Thread threadCreate(ThreadFunc entrypoint, void * arg, size_t stack_size, int prio, int core_id, bool detached)
+{
+    (void)stack_size;
+    (void)prio;
+    if(core_id >= host_cores())
+        return NULL;
+
+    Thread thread = malloc(sizeof(struct Thread_tag));
+    if(thread == NULL)
+        return NULL;
+
+    thread->entrypoint = entrypoint;
+    thread->arg = arg;
+    if(pthread_create(&thread->id, NULL, thread_start, thread) != 0)
+    {
+        free(thread);
+        return NULL;
+    }
+
+    if(detached)
+        pthread_detach(thread->id);
+    return thread;
+}
+
+Result threadJoin(Thread thread, u64 timeout_ns)
+{
+    (void)timeout_ns;
+    return pthread_join(thread->id, NULL) == 0 ? 0 : HOST_RES_UNSUPPORTED;
+}
+
+void threadFree(Thread thread)
+{
+    free(thread);
+}
+
+void LightLock_Init(LightLock * lock)
+{
+    pthread_mutex_init(lock, NULL);
+}
+
+void LightLock_Lock(LightLock * lock)
+{
+    pthread_mutex_lock(lock);
+}
+
+void LightLock_Unlock(LightLock * lock)
+{
+    pthread_mutex_unlock(lock);
+}
+
+void CondVar_Init(CondVar * cv)
+{
+    pthread_cond_init(cv, NULL);
+}
+
+void CondVar_Wait(CondVar * cv, LightLock * lock)
+{
+    pthread_cond_wait(cv, lock);
+}
+
+void CondVar_Signal(CondVar * cv)
+{
+    pthread_cond_signal(cv);
+}
+
+void CondVar_Broadcast(CondVar * cv)
+{
+    pthread_cond_broadcast(cv);
+}
+
+Result svcGetThreadPriority(s32 * out, Handle handle)
+{
+    (void)handle;
+    *out = 0x30;
+    return 0;
+}
+
+u64 svcGetSystemTick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * SYSCLOCK_ARM11 + (u64)ts.tv_nsec * SYSCLOCK_ARM11 / 1000000000;
+}
+
+Result svcSendSyncRequest(Handle session)
+{
+    (void)session;
+    return HOST_RES_UNSUPPORTED;
+}
+
+u32 * getThreadCommandBuffer(void)
+{
+    static __thread u32 command_buffer[0x40];
+    return command_buffer;
+}
+
+//---------------------------------------------------------------------------------
+// Filesystem
+//---------------------------------------------------------------------------------
+
+Handle * fsGetSessionHandle(void)
+{
+    static Handle session = 0;
+    return &session;
+}
+
+Result FSUSER_UpdateSha256Context(const void * data, u32 inputSize, u8 * hash)
+{
+    (void)data;
+    (void)inputSize;
+    (void)hash;
+    return HOST_RES_UNSUPPORTED;
+}
+
+// Nothing mounts at romfs:/, so whatever reads from it doesn't find it
+Result romfsInit(void)
+{
+    return 0;
+}
+
+Result romfsMountFromFile(Handle fd, u32 offset, const char * name)
+{
+    (void)fd;
+    (void)offset;
+    (void)name;
+    return HOST_RES_UNSUPPORTED;
+}
+
+Result romfsUnmount(const char * name)
+{
+    (void)name;
+    return HOST_RES_UNSUPPORTED;
+}
+
+//---------------------------------------------------------------------------------
+// Text
+//---------------------------------------------------------------------------------
+
+// Returns how many bytes the code point at in takes, 0 at the end of the input
+static ssize_t decode_utf8(u32 * out, const u8 * in)
+{
+    if(in[0] < 0x80)
+    {
+        *out = in[0];
+        return in[0] != 0;
+    }
+
+    int extra;
+    u32 code;
+    if((in[0] & 0xE0) == 0xC0)
+    {
+        extra = 1;
+        code = in[0] & 0x1F;
+    }
+    else if((in[0] & 0xF0) == 0xE0)
+    {
+        extra = 2;
+        code = in[0] & 0x0F;
+    }
+    else if((in[0] & 0xF8) == 0xF0)
+    {
+        extra = 3;
+        code = in[0] & 0x07;
+    }
+    else
+    {
+        return -1;
+    }
+
+    for(int i = 1; i <= extra; i++)
+    {
+        if((in[i] & 0xC0) != 0x80)
+            return -1;
+        code = (code << 6) | (in[i] & 0x3F);
+    }
+
+    *out = code;
+    return extra + 1;
+}
+
+// Returns how many units the code point at in takes, 0 at the end of the input
+static ssize_t decode_utf16(u32 * out, const u16 * in)
+{
+    if(in[0] >= 0xD800 && in[0] < 0xDC00)
+    {
+        if(in[1] < 0xDC00 || in[1] >= 0xE000)
+            return -1;
+        *out = 0x10000 + ((in[0] - 0xD800) << 10) + (in[1] - 0xDC00);
+        return 2;
+    }
+
+    if(in[0] >= 0xDC00 && in[0] < 0xE000)
+        return -1;
+
+    *out = in[0];
+    return in[0] != 0;
+}
+
+ssize_t utf8_to_utf16(u16 * out, const u8 * in, size_t len)
+{
+    size_t written = 0;
+    u32 code;
+    ssize_t units;
+    while((units = decode_utf8(&code, in)) > 0)
+    {
+        in += units;
+        if(code >= 0x10000)
+        {
+            if(out != NULL && written + 2 <= len)
+            {
+                out[written] = 0xD800 | ((code - 0x10000) >> 10);
+                out[written + 1] = 0xDC00 | ((code - 0x10000) & 0x3FF);
+            }
+            written += 2;
+        }
+        else
+        {
+            if(out != NULL && written + 1 <= len)
+                out[written] = code;
+            written++;
+        }
+    }
+
+    return units < 0 ? -1 : (ssize_t)written;
+}
+
+ssize_t utf16_to_utf8(u8 * out, const u16 * in, size_t len)
+{
+    size_t written = 0;
+    u32 code;
+    ssize_t units;
+    while((units = decode_utf16(&code, in)) > 0)
+    {
+        in += units;
+        u8 encoded[4];
+        int size;
+        if(code < 0x80)
+        {
+            encoded[0] = code;
+            size = 1;
+        }
+        else if(code < 0x800)
+        {
+            encoded[0] = 0xC0 | (code >> 6);
+            encoded[1] = 0x80 | (code & 0x3F);
+            size = 2;
+        }
+        else if(code < 0x10000)
+        {
+            encoded[0] = 0xE0 | (code >> 12);
+            encoded[1] = 0x80 | ((code >> 6) & 0x3F);
+            encoded[2] = 0x80 | (code & 0x3F);
+            size = 3;
+        }
+        else
+        {
+            encoded[0] = 0xF0 | (code >> 18);
+            encoded[1] = 0x80 | ((code >> 12) & 0x3F);
+            encoded[2] = 0x80 | ((code >> 6) & 0x3F);
+            encoded[3] = 0x80 | (code & 0x3F);
+            size = 4;
+        }
+
+        if(out != NULL && written + size <= len)
+            memcpy(out + written, encoded, size);
+        written += size;
+    }
+
+    return units < 0 ? -1 : (ssize_t)written;
+}
+
+ssize_t utf16_to_utf32(u32 * out, const u16 * in, size_t len)
+{
+    size_t written = 0;
+    u32 code;
+    ssize_t units;
+    while((units = decode_utf16(&code, in)) > 0)
+    {
+        in += units;
+        if(out != NULL && written + 1 <= len)
+            out[written] = code;
+        written++;
+    }
+
+    return units < 0 ? -1 : (ssize_t)written;
+}
+
+//---------------------------------------------------------------------------------
+// System services
+//---------------------------------------------------------------------------------
+
+Result CFGU_SecureInfoGetRegion(u8 * region)
+{
+    *region = CFG_REGION_USA;
+    return 0;
+}
+
+Result CFGU_GetSystemLanguage(u8 * language)
+{
+    *language = CFG_LANGUAGE_EN;
+    return 0;
+}
+
+Result CFGU_GetConfigInfoBlk2(u32 size, u32 blkID, void * outData)
+{
+    (void)size;
+    (void)blkID;
+    (void)outData;
+    return HOST_RES_UNSUPPORTED;
+}
+
+Result amAppInit(void)
+{
+    return HOST_RES_UNSUPPORTED;
+}
+
+void amExit(void)
+{
+}
+
+Result AMAPP_GetDLCContentInfoCount(u32 * count, FS_MediaType mediatype, u64 titleID)
+{
+    (void)mediatype;
+    (void)titleID;
+    *count = 0;
+    return HOST_RES_UNSUPPORTED;
+}
+
+Result AMAPP_ListDLCContentInfos(u32 * contentInfoRead, FS_MediaType mediatype, u64 titleID, u32 contentInfoCount, u32 offset, AM_ContentInfo * contentInfos)
+{
+    (void)mediatype;
+    (void)titleID;
+    (void)contentInfoCount;
+    (void)offset;
+    (void)contentInfos;
+    *contentInfoRead = 0;
+    return HOST_RES_UNSUPPORTED;
+}
+
+Result actInit(bool forceService)
+{
+    (void)forceService;
+    return 0;
+}
+
+void actExit(void)
+{
+}
+
+Result ACT_Initialize(u32 sdkVersion, u32 sharedMemSize, u32 sharedMem)
+{
+    (void)sdkVersion;
+    (void)sharedMemSize;
+    (void)sharedMem;
+    return 0;
+}
+
+Result ACT_GetAccountInfo(void * out, u32 size, u8 accountSlot, u32 infoType)
+{
+    (void)accountSlot;
+    if(infoType != INFO_TYPE_PRINCIPAL_ID || size < sizeof(u32))
+        return HOST_RES_UNSUPPORTED;
+
+    const u32 nnid = HOST_NNID;
+    memcpy(out, &nnid, sizeof(nnid));
+    return 0;
+}
+
+//---------------------------------------------------------------------------------
+// Software keyboard
+//---------------------------------------------------------------------------------
+
+void swkbdInit(SwkbdState * swkbd, SwkbdType type, int numButtons, int maxTextLength)
+{
+    (void)numButtons;
+    (void)maxTextLength;
+    swkbd->type = type;
+}
+
+void swkbdSetFeatures(SwkbdState * swkbd, u32 features)
+{
+    (void)swkbd;
+    (void)features;
+}
+
+void swkbdSetHintText(SwkbdState * swkbd, const char * text)
+{
+    (void)swkbd;
+    (void)text;
+}
+
+void swkbdSetButton(SwkbdState * swkbd, SwkbdButton button, const char * text, bool submit)
+{
+    (void)swkbd;
+    (void)button;
+    (void)text;
+    (void)submit;
+}
+
+void swkbdSetValidation(SwkbdState * swkbd, SwkbdValidInput validInput, u32 filterFlags, u32 maxDigits)
+{
+    (void)swkbd;
+    (void)validInput;
+    (void)filterFlags;
+    (void)maxDigits;
+}
+
+void swkbdSetFilterCallback(SwkbdState * swkbd, SwkbdCallbackFn callback, void * user)
+{
+    (void)swkbd;
+    (void)callback;
+    (void)user;
+}
+
+// As if the keyboard was closed without typing anything
+SwkbdButton swkbdInputText(SwkbdState * swkbd, char * buf, size_t bufsize)
+{
+    (void)swkbd;
+    if(bufsize != 0)
+        buf[0] = '\0';
+    return SWKBD_BUTTON_NONE;
+}
+
+int swkbdGetResult(SwkbdState * swkbd)
+{
+    (void)swkbd;
+    return -1;
+}
@@ -0,0 +1,47 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The user feedback from ui_feedback.h, for the host: nothing to draw, the
+// errors go to stderr
+
+#include "ui_feedback.h"
+
+void throw_error(const char * error, ErrorLevel level)
+{
+    DEBUG("%s: %s\n", level == ERROR_LEVEL_WARNING ? "warning" : "error", error);
+}
+
+void draw_install(InstallType type)
+{
+    (void)type;
+}
+
+void draw_loading_bar(u32 current, u32 max, InstallType type)
+{
+    (void)current;
+    (void)max;
+    (void)type;
+}
@@ -0,0 +1,456 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Install benchmark: load_entries on /Themes, the theme installs and
+// install_badges, as the app runs them, against a generated SD card and the
+// home menu's extdata. host/ctru.c answers like a USA console, so the theme
+// extdata is 000002cd and the home menu's 0000008f.
+//
+//     ./install_bench [themes] [badge sets]
+//
+// The themes are a mix of zips and folders; every badge set is a folder with
+// a set icon, badges straight in /Badges would need the app's romfs. Each
+// result is checked against what was generated.
+
+#include "bench_theme.h"
+#include "fs.h"
+#include "themes.h"
+#include "badges.h"
+#include "ui_strings.h"
+
+#include <errno.h>
+#include <png.h>
+#include <sys/stat.h>
+
+#define BENCH_ROOT "vfs_install"
+#define DEFAULT_THEMES 64
+#define DEFAULT_BADGE_SETS 8
+#define BADGES_PER_SET 12 // files, every other one a sheet of 2 badges
+#define RUNS 3
+
+#define THEME_BODY_SIZE 0x80000
+#define THEME_BGM_SIZE 0x40000
+
+#define THEME_EXTDATA 0x000002cd
+#define HOME_EXTDATA 0x0000008f
+#define BADGE_EXTDATA 0x000014d1
+#define THEME_EXTDATA_BODY_SIZE 0x150000
+#define THEME_EXTDATA_BGM_SIZE 0x337000
+
+#define CACHE_DIR "/3ds/" APP_TITLE "/cache"
+
+typedef struct {
+    u32 body_size;
+    u32 bgm_size;
+} Theme_Sizes_s;
+
+static Theme_Sizes_s * theme_sizes;
+static int themes_count;
+
+static Entry_List_s list;
+static Entry_s * zip_theme;
+static Entry_s * folder_theme;
+
+// Makes a file of zeroes, the way the home menu has its extdata files already there
+static bool create_zeroed(FS_Archive archive, const char * path, u32 size)
+{
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_WRITE | FS_OPEN_CREATE)))
+        return false;
+
+    const Result res = vfs_set_size(handle, size);
+    vfs_close(handle);
+    return R_SUCCEEDED(res);
+}
+
+static bool generate_extdata(u32 id, const char * const * paths, const u32 * sizes, int count)
+{
+    char dir[64];
+    snprintf(dir, sizeof(dir), BENCH_ROOT "/extdata/%08lx", (unsigned long)id);
+    if(mkdir(BENCH_ROOT "/extdata", 0755) != 0 && errno != EEXIST)
+        return false;
+    if(mkdir(dir, 0755) != 0)
+        return false;
+
+    const u32 extdata_path[3] = {MEDIATYPE_SD, id, 0};
+    const FS_Path path = {PATH_BINARY, sizeof(extdata_path), extdata_path};
+    FS_Archive archive;
+    if(R_FAILED(vfs_open_archive(&archive, ARCHIVE_EXTDATA, path)))
+        return false;
+
+    bool ok = true;
+    for(int i = 0; ok && i < count; i++)
+        ok = create_zeroed(archive, paths[i], sizes[i]);
+    vfs_close_archive(archive);
+    return ok;
+}
+
+static bool generate_themes(FS_Archive archive)
+{
+    if(R_FAILED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, "/Themes"))))
+        return false;
+
+    theme_sizes = calloc(themes_count, sizeof(Theme_Sizes_s));
+    bool ok = theme_sizes != NULL;
+    for(int i = 0; ok && i < themes_count; i++)
+    {
+        Bench_Theme_s theme;
+        char name[16];
+        snprintf(name, sizeof(name), "%04i", i);
+        ok = bench_make_theme(&theme, i, THEME_BODY_SIZE, THEME_BGM_SIZE)
+            && bench_write_theme(archive, "/Themes", name, &theme, i % 4 != 0);
+        theme_sizes[i].body_size = theme.body_size;
+        theme_sizes[i].bgm_size = theme.bgm_size;
+        bench_free_theme(&theme);
+    }
+
+    return ok;
+}
+
+// An RGBA picture, in memory as a PNG file
+static u8 * make_png(u32 width, u32 height, u32 seed, u32 * size)
+{
+    u8 * pixels = malloc(width * height * 4);
+    if(pixels == NULL)
+        return NULL;
+
+    u32 state = seed;
+    for(u32 y = 0; y < height; y++)
+    {
+        for(u32 x = 0; x < width; x++)
+        {
+            u8 * const pixel = pixels + (y * width + x) * 4;
+            pixel[0] = x * 4 + seed;
+            pixel[1] = y * 4;
+            pixel[2] = bench_random(&state);
+            pixel[3] = (x % 64 < 4 || y % 64 < 4) ? 0 : 0xFF;
+        }
+    }
+
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = width;
+    image.height = height;
+    image.format = PNG_FORMAT_RGBA;
+
+    png_alloc_size_t png_size = 0;
+    u8 * png = NULL;
+    if(png_image_write_to_memory(&image, NULL, &png_size, 0, pixels, 0, NULL) && (png = malloc(png_size)) != NULL
+        && !png_image_write_to_memory(&image, png, &png_size, 0, pixels, 0, NULL))
+    {
+        free(png);
+        png = NULL;
+    }
+
+    free(pixels);
+    *size = png != NULL ? png_size : 0;
+    return png;
+}
+
+static bool write_png(FS_Archive archive, const char * path, u32 width, u32 height, u32 seed)
+{
+    u32 size = 0;
+    u8 * png = make_png(width, height, seed, &size);
+    const bool ok = png != NULL && bench_write_file(archive, path, png, size);
+    free(png);
+    return ok;
+}
+
+static int badges_in_sets(int sets)
+{
+    return sets * (BADGES_PER_SET + BADGES_PER_SET / 2);
+}
+
+static bool generate_badges(FS_Archive archive, int sets)
+{
+    if(R_FAILED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, "/Badges"))))
+        return false;
+
+    // open_badge_extdata makes this set for ThemePlaza's badges, with an icon
+    // from the romfs unless it's there already
+    bool ok = R_SUCCEEDED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, "/Badges/ThemePlaza Badges")))
+        && write_png(archive, "/Badges/ThemePlaza Badges/_seticon.png", 48, 48, sets);
+    char path[64];
+    for(int set = 0; ok && set < sets; set++)
+    {
+        snprintf(path, sizeof(path), "/Badges/Set %02i", set);
+        ok = R_SUCCEEDED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, path)));
+        snprintf(path, sizeof(path), "/Badges/Set %02i/_seticon.png", set);
+        ok = ok && write_png(archive, path, 48, 48, set);
+        for(int badge = 0; ok && badge < BADGES_PER_SET; badge++)
+        {
+            snprintf(path, sizeof(path), "/Badges/Set %02i/Badge %02i.png", set, badge);
+            ok = write_png(archive, path, badge % 2 ? 128 : 64, 64, set * BADGES_PER_SET + badge);
+        }
+    }
+
+    return ok;
+}
+
+// The number in "Theme <number>", -1 if that isn't the name
+static int theme_number(const u16 * name)
+{
+    char ascii[0x41] = {0};
+    for(int i = 0; i < 0x40 && name[i]; i++)
+        ascii[i] = name[i] < 0x80 ? name[i] : '?';
+
+    int number = -1;
+    if(sscanf(ascii, "Theme %d", &number) != 1 || number < 0 || number >= themes_count)
+        return -1;
+    return number;
+}
+
+static bool check_list(void)
+{
+    if(list.entries_count != themes_count)
+        return false;
+
+    for(int i = 0; i < list.entries_count; i++)
+    {
+        const Entry_s * const entry = list.entries[i];
+        Icon_s smdh;
+        const int number = theme_number(entry->name);
+        if(number < 0 || (number % 4 != 0) != entry->is_zip)
+            return false;
+
+        bench_fill_smdh(&smdh, number);
+        if(memcmp(entry->author, smdh.author, sizeof(smdh.author)))
+            return false;
+    }
+
+    return true;
+}
+
+static ThemeManage_bin_s * read_theme_manage(void)
+{
+    char * buf = NULL;
+    if(file_to_buf(fsMakePath(PATH_ASCII, "/ThemeManage.bin"), ArchiveThemeExt, &buf) < sizeof(ThemeManage_bin_s))
+    {
+        free(buf);
+        return NULL;
+    }
+    return (ThemeManage_bin_s *)buf;
+}
+
+// What the home menu would read: the theme's bgm, and a body that says it has one
+static bool check_bgm_installed(const Entry_s * entry)
+{
+    ThemeManage_bin_s * theme_manage = read_theme_manage();
+    u8 bgm_flag = 0;
+    const bool ok = theme_manage != NULL
+        && theme_manage->music_size == theme_sizes[theme_number(entry->name)].bgm_size
+        && read_lz_file_byte(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, 5, &bgm_flag) && bgm_flag == 1;
+    free(theme_manage);
+    return ok;
+}
+
+static bool check_body_installed(const Entry_s * entry)
+{
+    ThemeManage_bin_s * theme_manage = read_theme_manage();
+    const bool ok = theme_manage != NULL && theme_manage->body_size == theme_sizes[theme_number(entry->name)].body_size;
+    free(theme_manage);
+    return ok;
+}
+
+static bool check_shuffle_installed(void)
+{
+    ThemeManage_bin_s * theme_manage = read_theme_manage();
+    bool ok = theme_manage != NULL;
+    for(int i = 0; ok && i < MAX_SHUFFLE_THEMES; i++)
+    {
+        const Theme_Sizes_s * const sizes = &theme_sizes[theme_number(list.entries[i]->name)];
+        ok = theme_manage->shuffle_body_sizes[i] == sizes->body_size && theme_manage->shuffle_music_sizes[i] == sizes->bgm_size;
+    }
+    free(theme_manage);
+    return ok;
+}
+
+static bool check_badges_installed(int sets)
+{
+    char * mng = NULL;
+    const u32 size = file_to_buf(fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), ArchiveBadgeExt, &mng);
+    u32 badges = 0;
+    if(size == BADGE_MNG_SIZE)
+        memcpy(&badges, mng + 0x8, sizeof(badges));
+    const bool ok = size == BADGE_MNG_SIZE && mng[0x4] == sets && badges == (u32)badges_in_sets(sets);
+    free(mng);
+    return ok;
+}
+
+static void free_list(void)
+{
+    list_free_entries(&list);
+    memset(&list, 0, sizeof(list));
+}
+
+static void clear_cache(void)
+{
+    free_list();
+    vfs_delete_dir_recursively(ArchiveSD, fsMakePath(PATH_ASCII, CACHE_DIR));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, CACHE_DIR));
+}
+
+static Result load_themes(void)
+{
+    return load_entries(main_paths[REMOTE_MODE_THEMES], &list, INSTALL_LOADING_THEMES);
+}
+
+static Result install_zip_theme(void)
+{
+    return theme_install(zip_theme);
+}
+
+static Result install_folder_theme(void)
+{
+    return theme_install(folder_theme);
+}
+
+static Result install_no_bgm(void)
+{
+    return no_bgm_install(zip_theme);
+}
+
+static Result install_bgm(void)
+{
+    return bgm_install(zip_theme);
+}
+
+static Result install_shuffle(void)
+{
+    return shuffle_install(&list);
+}
+
+// Best of RUNS in seconds, prepare isn't timed. Stops at the first run that fails
+static double time_runs(void (*prepare)(void), Result (*run)(void), Result * res)
+{
+    double best = 0;
+    *res = 0;
+    for(int i = 0; i < RUNS && R_SUCCEEDED(*res); i++)
+    {
+        if(prepare != NULL)
+            prepare();
+
+        const double start = bench_now();
+        *res = run();
+        const double elapsed = bench_now() - start;
+        if(i == 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    return best;
+}
+
+static bool report(const char * name, double seconds, Result res, bool ok)
+{
+    if(R_FAILED(res))
+        printf("  %-26s failed: 0x%08lx\n", name, (unsigned long)res);
+    else
+        printf("  %-26s %8.2f ms%s\n", name, seconds * 1000, ok ? "" : "  WRONG RESULTS");
+    return R_SUCCEEDED(res) && ok;
+}
+
+static bool find_themes_to_install(void)
+{
+    for(int i = 0; i < list.entries_count; i++)
+    {
+        if(list.entries[i]->is_zip && zip_theme == NULL)
+            zip_theme = list.entries[i];
+        else if(!list.entries[i]->is_zip && folder_theme == NULL)
+            folder_theme = list.entries[i];
+    }
+
+    for(int i = 0; i < MAX_SHUFFLE_THEMES && i < list.entries_count; i++)
+        list.entries[i]->in_shuffle = true;
+    list.shuffle_count = min(MAX_SHUFFLE_THEMES, list.entries_count);
+    return zip_theme != NULL && folder_theme != NULL;
+}
+
+int main(int argc, char ** argv)
+{
+    themes_count = argc > 1 ? atoi(argv[1]) : DEFAULT_THEMES;
+    const int sets = argc > 2 ? atoi(argv[2]) : DEFAULT_BADGE_SETS;
+    if(themes_count < MAX_SHUFFLE_THEMES || themes_count > 9999 || sets < 1 || sets > 99 || badges_in_sets(sets) > MAX_BADGE)
+    {
+        DEBUG("usage: %s [themes, %i to 9999] [badge sets, 1 to %i]\n", argv[0], MAX_SHUFFLE_THEMES, MAX_BADGE / badges_in_sets(1));
+        return 1;
+    }
+
+    const FS_Archive archive = bench_open_sdmc(BENCH_ROOT);
+    const char * const theme_files[] = {"/ThemeManage.bin", "/BodyCache.bin", "/BgmCache.bin"};
+    const u32 theme_sizes_extdata[] = {0x800, THEME_EXTDATA_BODY_SIZE, THEME_EXTDATA_BGM_SIZE};
+    const char * const home_files[] = {"/SaveData.dat"};
+    const u32 home_sizes[] = {sizeof(SaveData_dat_s)};
+    const char * const badge_files[] = {"/BadgeData.dat", "/BadgeMngFile.dat"};
+    const u32 badge_sizes[] = {BADGE_DATA_SIZE, BADGE_MNG_SIZE};
+    if(archive == 0 || !generate_themes(archive) || !generate_badges(archive, sets)
+        || !generate_extdata(THEME_EXTDATA, theme_files, theme_sizes_extdata, 3)
+        || !generate_extdata(HOME_EXTDATA, home_files, home_sizes, 1)
+        || !generate_extdata(BADGE_EXTDATA, badge_files, badge_sizes, 2))
+    {
+        DEBUG("can't set up %s\n", BENCH_ROOT);
+        return 1;
+    }
+    vfs_close_archive(archive);
+
+    language = init_strings(CFG_LANGUAGE_EN);
+    if(R_FAILED(init_sd()) || R_FAILED(open_archives()) || R_FAILED(open_badge_extdata()))
+    {
+        DEBUG("can't open the archives in %s\n", BENCH_ROOT);
+        return 1;
+    }
+
+    printf("%i themes, %i badges in %i sets\n", themes_count, badges_in_sets(sets), sets);
+    Result res;
+    double seconds = time_runs(clear_cache, load_themes, &res);
+    bool ok = report("load_entries, no cache", seconds, res, check_list());
+    seconds = time_runs(free_list, load_themes, &res);
+    ok = report("load_entries, cached", seconds, res, check_list()) && ok;
+
+    if(!find_themes_to_install())
+    {
+        DEBUG("no zip and folder themes to install\n");
+        return 1;
+    }
+
+    seconds = time_runs(NULL, install_zip_theme, &res);
+    ok = report("theme_install, zip", seconds, res, check_bgm_installed(zip_theme)) && ok;
+    seconds = time_runs(NULL, install_folder_theme, &res);
+    ok = report("theme_install, folder", seconds, res, check_bgm_installed(folder_theme)) && ok;
+    seconds = time_runs(NULL, install_no_bgm, &res);
+    ok = report("no_bgm_install", seconds, res, check_body_installed(zip_theme)) && ok;
+    seconds = time_runs(NULL, install_bgm, &res);
+    ok = report("bgm_install", seconds, res, check_bgm_installed(zip_theme)) && ok;
+    seconds = time_runs(NULL, install_shuffle, &res);
+    ok = report("shuffle_install", seconds, res, check_shuffle_installed()) && ok;
+    seconds = time_runs(NULL, install_badges, &res);
+    ok = report("install_badges", seconds, res, check_badges_installed(sets)) && ok;
+
+    free_list();
+    free(theme_sizes);
+    close_archives();
+    return ok ? 0 : 1;
+}
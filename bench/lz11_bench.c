@@ -0,0 +1,175 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// LZ11 compressor benchmark: speed and ratio of lz11_compress at each level,
+// with every output written to the vfs and read back the way
+// decompress_lz_file does it, then compared with the input.
+//
+//     ./lz11_bench [body_LZ.bin ...]
+//
+// Files given are decompressed first when they're LZ11 already, so real
+// body_LZ.bin from themes can be used as is. Without any, a few generated
+// bodies are used instead.
+
+#include "bench.h"
+#include "lz.h"
+
+#define BENCH_ROOT "vfs_lz11"
+#define MIN_SECONDS 0.25
+
+static const int levels[] = {LZ11_LEVEL_FASTEST, 2, LZ11_LEVEL_DEFAULT, 6, LZ11_LEVEL_BEST};
+
+typedef struct {
+    const char * name;
+    u8 * data;
+    u32 size;
+} Sample_s;
+
+// Same steps as decompress_lz_file in fs.c, which can't be built here
+static u32 decompress_body(FS_Archive archive, const char * path, u8 ** buf)
+{
+    *buf = NULL;
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+        return 0;
+
+    u8 header[LZ11_HEADER_SIZE] = {0};
+    u32 read = 0;
+    vfs_read(handle, &read, 0, header, LZ11_HEADER_SIZE);
+    const u32 output_size = read == LZ11_HEADER_SIZE ? lz11_decompressed_size(header) : 0;
+
+    u32 written = 0;
+    if(output_size != 0 && (*buf = malloc(output_size)) != NULL)
+        written = lz11_decompress_file(handle, *buf, output_size);
+    vfs_close(handle);
+
+    if(written != output_size || written == 0)
+    {
+        free(*buf);
+        *buf = NULL;
+        return 0;
+    }
+    return written;
+}
+
+static bool load_sample(FS_Archive archive, const char * path, Sample_s * sample)
+{
+    u32 size = 0;
+    u8 * data = bench_load_host_file(path, &size);
+    if(data == NULL)
+        return false;
+
+    sample->name = path;
+    sample->data = data;
+    sample->size = size;
+
+    // a body_LZ.bin, benchmark on what's inside
+    if(size >= LZ11_HEADER_SIZE && lz11_decompressed_size(data) != 0
+        && bench_write_file(archive, "/sample.bin", data, size))
+    {
+        u8 * body = NULL;
+        const u32 body_size = decompress_body(archive, "/sample.bin", &body);
+        if(body_size != 0)
+        {
+            free(data);
+            sample->data = body;
+            sample->size = body_size;
+        }
+    }
+
+    return true;
+}
+
+static bool bench_sample(FS_Archive archive, const Sample_s * sample)
+{
+    u8 * compressed = malloc(lz11_compress_bound(sample->size));
+    bool ok = compressed != NULL;
+
+    printf("%s: %lu bytes\n", sample->name, (unsigned long)sample->size);
+    for(size_t i = 0; ok && i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        u32 compressed_size = 0;
+        u32 runs = 0;
+        const double start = bench_now();
+        double elapsed = 0;
+        do {
+            compressed_size = lz11_compress(sample->data, sample->size, compressed, levels[i]);
+            runs++;
+            elapsed = bench_now() - start;
+        } while(compressed_size != 0 && elapsed < MIN_SECONDS);
+
+        u8 * decompressed = NULL;
+        const bool round_trip = compressed_size != 0
+            && bench_write_file(archive, "/BodyCache.bin", compressed, compressed_size)
+            && decompress_body(archive, "/BodyCache.bin", &decompressed) == sample->size
+            && !memcmp(decompressed, sample->data, sample->size);
+        free(decompressed);
+
+        printf("  level %i: %8.2f MB/s  %6.2f%%  %s\n", levels[i],
+               (double)sample->size * runs / elapsed / 1e6,
+               100.0 * compressed_size / sample->size,
+               round_trip ? "round trip ok" : "ROUND TRIP FAILED");
+        ok = round_trip;
+    }
+
+    free(compressed);
+    return ok;
+}
+
+int main(int argc, char ** argv)
+{
+    const FS_Archive archive = bench_open_sdmc(BENCH_ROOT);
+    if(archive == 0)
+    {
+        DEBUG("can't set up %s\n", BENCH_ROOT);
+        return 1;
+    }
+
+    Sample_s samples[16];
+    int samples_count = 0;
+    for(int i = 1; i < argc && samples_count < 16; i++)
+    {
+        if(load_sample(archive, argv[i], &samples[samples_count]))
+            samples_count++;
+        else
+            DEBUG("can't read %s\n", argv[i]);
+    }
+    if(argc == 1)
+    {
+        samples[samples_count++] = (Sample_s){"generated 256 KiB", bench_generate_body(0x40000, 1), 0x40000};
+        samples[samples_count++] = (Sample_s){"generated 1.5 MiB", bench_generate_body(0x180000, 2), 0x180000};
+    }
+
+    bool ok = true;
+    for(int i = 0; i < samples_count; i++)
+    {
+        ok = bench_sample(archive, &samples[i]) && ok;
+        free(samples[i].data);
+    }
+
+    vfs_close_archive(archive);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// LZ11 decoder benchmark: lz11_decompress_file against the loop
+// decompress_lz_file used before it, which read the whole compressed file
+// into memory first and copied back references a byte at a time.
+//
+//     ./lz11_decode_bench [body_LZ.bin ...]
+//
+// Without files, generated bodies compressed with LZ11_LEVEL_DEFAULT are used.
+// Both decoders start from the file in the vfs root, so the times include
+// reading it.
+
+#include "bench.h"
+#include "lz.h"
+
+#define BENCH_ROOT "vfs_lz11_decode"
+#define BENCH_FILE "/BodyCache.bin"
+#define MIN_SECONDS 0.25
+
+// The old decompress_lz_file, with its FSUSER/FSFILE calls swapped for vfs_* and
+// temp_buf made unsigned, as char is on the ARM11
+static u32 old_decompress_file(FS_Archive archive, const char * path, char ** buf)
+{
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+        return 0;
+    u64 size;
+    vfs_get_size(handle, &size);
+
+    u8 * temp_buf = NULL;
+
+    if(size != 0)
+    {
+        temp_buf = calloc(1, size);
+        vfs_read(handle, NULL, 0, temp_buf, size);
+    }
+    vfs_close(handle);
+
+    if (temp_buf[0] != 0x11) {
+        free(temp_buf);
+        return 0;
+    }
+
+    u32 output_size = temp_buf[1] | ((temp_buf[2] << 8) & 0xFF00) | ((temp_buf[3] << 16) & 0xFF0000);
+
+    *buf = calloc(1, output_size);
+
+    u32 pos = 4;
+    u32 cur_written = 0;
+    u8 counter = 0;
+    u8 mask = 0;
+
+    while (cur_written < output_size)
+    {
+        if (counter == 0) // read mask
+        {
+            mask = temp_buf[pos++];
+            counter++;
+            continue;
+        }
+
+        if ((mask >> (8 - counter)) & 0x01) // compressed block
+        {
+            int len = 0;
+            int disp = 0;
+            switch (temp_buf[pos] >> 4)
+            {
+                case 0:
+                    len  = temp_buf[pos++] << 4;
+                    len |= temp_buf[pos] >> 4;
+                    len += 0x11;
+                    break;
+
+                case 1:
+                    len  = (temp_buf[pos++] & 0x0F) << 12;
+                    len |=  temp_buf[pos++] << 4;
+                    len |=  temp_buf[pos] >> 4;
+                    len += 0x111;
+                    break;
+
+                default:
+                    len  = (temp_buf[pos] >> 4) + 1;
+            }
+
+            disp  = (temp_buf[pos++] & 0x0F) << 8;
+            disp |=  temp_buf[pos++];
+
+            for (int i = 0; i < len; ++i)
+            {
+                *(*buf + cur_written + i) = *(*buf + cur_written - disp - 1 + i);
+            }
+
+            cur_written += len;
+        }
+        else // byte literal
+        {
+            *(*buf + cur_written) = temp_buf[pos++];
+            cur_written++;
+        }
+
+        if (++counter > 8) counter = 0;
+
+    }
+
+
+    free(temp_buf);
+
+    return cur_written;
+}
+
+// What decompress_lz_file does now
+static u32 new_decompress_file(FS_Archive archive, const char * path, char ** buf)
+{
+    *buf = NULL;
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+        return 0;
+
+    u8 header[LZ11_HEADER_SIZE] = {0};
+    u32 read = 0;
+    vfs_read(handle, &read, 0, header, LZ11_HEADER_SIZE);
+    const u32 output_size = read == LZ11_HEADER_SIZE ? lz11_decompressed_size(header) : 0;
+
+    u32 written = 0;
+    if(output_size != 0 && (*buf = malloc(output_size)) != NULL)
+        written = lz11_decompress_file(handle, (u8 *)*buf, output_size);
+    vfs_close(handle);
+
+    if(written != output_size)
+    {
+        free(*buf);
+        *buf = NULL;
+        return 0;
+    }
+    return written;
+}
+
+typedef u32 (*Decompress_f)(FS_Archive archive, const char * path, char ** buf);
+
+// Returns the MB/s of decompressed output, 0 when the output doesn't match
+static double time_decoder(FS_Archive archive, Decompress_f decompress, const u8 * expected, u32 size)
+{
+    u32 runs = 0;
+    bool ok = true;
+    const double start = bench_now();
+    double elapsed = 0;
+    do {
+        char * buf = NULL;
+        ok = decompress(archive, BENCH_FILE, &buf) == size && !memcmp(buf, expected, size);
+        free(buf);
+        runs++;
+        elapsed = bench_now() - start;
+    } while(ok && elapsed < MIN_SECONDS);
+
+    return ok ? (double)size * runs / elapsed / 1e6 : 0;
+}
+
+static bool bench_sample(FS_Archive archive, const char * name, const u8 * compressed, u32 compressed_size)
+{
+    char * body = NULL;
+    const u32 size = bench_write_file(archive, BENCH_FILE, compressed, compressed_size)
+        ? new_decompress_file(archive, BENCH_FILE, &body) : 0;
+    if(size == 0)
+    {
+        DEBUG("%s: not valid LZ11\n", name);
+        return false;
+    }
+
+    const double old_speed = time_decoder(archive, old_decompress_file, (u8 *)body, size);
+    const double new_speed = time_decoder(archive, new_decompress_file, (u8 *)body, size);
+    free(body);
+
+    printf("%s: %lu -> %lu bytes\n", name, (unsigned long)compressed_size, (unsigned long)size);
+    printf("  old loop:             %8.2f MB/s, input held in memory: %lu bytes\n", old_speed, (unsigned long)compressed_size);
+    printf("  lz11_decompress_file: %8.2f MB/s (%.2fx)\n", new_speed, old_speed != 0 ? new_speed / old_speed : 0);
+
+    // the old loop trusts the data, so it can't have failed on valid input; the new one must match it
+    if(new_speed == 0)
+        printf("  OUTPUT MISMATCH\n");
+    return old_speed != 0 && new_speed != 0;
+}
+
+int main(int argc, char ** argv)
+{
+    const FS_Archive archive = bench_open_sdmc(BENCH_ROOT);
+    if(archive == 0)
+    {
+        DEBUG("can't set up %s\n", BENCH_ROOT);
+        return 1;
+    }
+
+    bool ok = true;
+    for(int i = 1; i < argc; i++)
+    {
+        u32 size = 0;
+        u8 * data = bench_load_host_file(argv[i], &size);
+        if(data == NULL)
+        {
+            DEBUG("can't read %s\n", argv[i]);
+            ok = false;
+            continue;
+        }
+        ok = bench_sample(archive, argv[i], data, size) && ok;
+        free(data);
+    }
+
+    if(argc == 1)
+    {
+        static const struct {
+            const char * name;
+            u32 size;
+        } generated[] = {
+            {"generated 256 KiB", 0x40000},
+            {"generated 1.5 MiB", 0x180000},
+        };
+
+        for(size_t i = 0; i < sizeof(generated) / sizeof(generated[0]); i++)
+        {
+            u8 * body = bench_generate_body(generated[i].size, i + 1);
+            u8 * compressed = malloc(lz11_compress_bound(generated[i].size));
+            const u32 compressed_size = lz11_compress(body, generated[i].size, compressed, LZ11_LEVEL_DEFAULT);
+            ok = bench_sample(archive, generated[i].name, compressed, compressed_size) && ok;
+            free(compressed);
+            free(body);
+        }
+    }
+
+    vfs_close_archive(archive);
+    return ok ? 0 : 1;
+}
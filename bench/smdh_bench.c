@@ -0,0 +1,171 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// SMDH pipeline benchmark: runs smdh_pipeline_run over a list loaded with
+// load_entries from a generated library of N zipped themes, giving it 0 to
+// SMDH_PIPELINE_MAX_WORKERS cores to make workers on, 0 being the serial pass.
+//
+//     ./smdh_bench [N]
+//
+// host/ctru.c makes threads on the first ANEMONE_HOST_CORES cores, which
+// stand in for the cores a 3DS lets the app use. The library sits in the
+// host's page cache, so the reader is much cheaper than it is on an SD
+// card: the numbers show the inflate and parse side.
+
+#include "bench_theme.h"
+#include "fs.h"
+#include "smdh_pipeline.h"
+
+#include <unistd.h>
+
+#define BENCH_ROOT "vfs_smdh"
+#define DEFAULT_ENTRIES 400
+#define BODY_SIZE 0x10000
+
+static bool generate_library(FS_Archive archive, int count)
+{
+    if(R_FAILED(vfs_create_dir(archive, fsMakePath(PATH_ASCII, "/Themes"))))
+        return false;
+
+    bool ok = true;
+    for(int i = 0; ok && i < count; i++)
+    {
+        Bench_Theme_s theme;
+        char name[16];
+        snprintf(name, sizeof(name), "%04i", i);
+        ok = bench_make_theme(&theme, i, BODY_SIZE, 0) && bench_write_theme(archive, "/Themes", name, &theme, true);
+        bench_free_theme(&theme);
+    }
+
+    return ok;
+}
+
+// The theme a file name like "0042.zip" was generated from
+static int theme_index(const Entry_s * entry)
+{
+    int index = 0;
+    for(int i = 0; i < 4; i++)
+        index = index * 10 + entry->file_name[i] - '0';
+    return index;
+}
+
+// So nothing left from the last run passes for what this one parsed
+static void clear_entries(Entry_List_s * list)
+{
+    for(int i = 0; i < list->entries_count; i++)
+    {
+        Entry_s * const entry = list->entries[i];
+        memset(entry->name, 0, sizeof(entry->name));
+        memset(entry->desc, 0, 0x81 * sizeof(u16));
+        memset(entry->author, 0, sizeof(entry->author));
+    }
+}
+
+// Returns the seconds smdh_pipeline_run takes to parse every entry
+static double run_pipeline(Entry_List_s * list, const int * indices)
+{
+    clear_entries(list);
+    const double start = bench_now();
+    smdh_pipeline_run(list, indices, list->entries_count, INSTALL_LOADING_THEMES, NULL);
+    return bench_now() - start;
+}
+
+// Every entry has to end up with its own strings, whichever worker parsed it
+static bool check_parsed(const Entry_List_s * list)
+{
+    Icon_s smdh;
+    for(int i = 0; i < list->entries_count; i++)
+    {
+        const Entry_s * const entry = list->entries[i];
+        bench_fill_smdh(&smdh, theme_index(entry));
+        if(memcmp(entry->name, smdh.name, sizeof(smdh.name))
+            || memcmp(entry->desc, smdh.desc, sizeof(smdh.desc))
+            || memcmp(entry->author, smdh.author, sizeof(smdh.author)))
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    const int count = argc > 1 ? atoi(argv[1]) : DEFAULT_ENTRIES;
+    if(count <= 0 || count > 9999)
+    {
+        DEBUG("usage: %s [entries, 1 to 9999]\n", argv[0]);
+        return 1;
+    }
+
+    const FS_Archive archive = bench_open_sdmc(BENCH_ROOT);
+    if(archive == 0 || !generate_library(archive, count))
+    {
+        DEBUG("can't set up %s\n", BENCH_ROOT);
+        return 1;
+    }
+    vfs_close_archive(archive);
+
+    Entry_List_s list;
+    memset(&list, 0, sizeof(list));
+    if(R_FAILED(init_sd()) || R_FAILED(load_entries("/Themes/", &list, INSTALL_LOADING_THEMES)) || list.entries_count != count)
+    {
+        DEBUG("can't load %s/sdmc/Themes\n", BENCH_ROOT);
+        return 1;
+    }
+
+    int * indices = malloc(count * sizeof(int));
+    bool ok = indices != NULL && check_parsed(&list);
+    for(int i = 0; ok && i < count; i++)
+        indices[i] = i;
+
+    printf("%i zipped themes, %li cores\n", count, sysconf(_SC_NPROCESSORS_ONLN));
+    double serial = 0;
+    for(int cores = 0; ok && cores <= SMDH_PIPELINE_MAX_WORKERS; cores++)
+    {
+        char cores_env[8];
+        snprintf(cores_env, sizeof(cores_env), "%i", cores);
+        setenv("ANEMONE_HOST_CORES", cores_env, 1);
+
+        // best of a few runs, the first one also warms the page cache
+        double best = 0;
+        for(int run = 0; ok && run < 3; run++)
+        {
+            const double elapsed = run_pipeline(&list, indices);
+            if(run == 0 || elapsed < best)
+                best = elapsed;
+            ok = check_parsed(&list);
+        }
+
+        if(cores == 0)
+            serial = best;
+        printf("  %i worker%s: %8.0f entries/s  %5.2fx%s\n", cores, cores == 1 ? " " : "s",
+               count / best, serial / best, ok ? "" : "  WRONG RESULTS");
+    }
+
+    free(indices);
+    list_free_entries(&list);
+    vfs_close_archive(ArchiveSD);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Zip member lookup benchmark: zip_open, zip_find and zip_read through the
+// central directory against walking the local headers from the start of the
+// file, as zip_file_to_buf did with libarchive, for the first, middle and
+// last member of zips with more and bigger members.
+//
+//     ./zip_bench
+//
+// The walk reads through the data of every member before the one it's after,
+// in blocks of the size the old code gave archive_read_open_filename.
+
+#include "bench.h"
+#include "bench_zip.h"
+#include "zip.h"
+
+#define BENCH_ROOT "vfs_zip"
+#define BENCH_FILE "/bench.zip"
+#define MIN_SECONDS 0.1
+#define WALK_BLOCK 0x4000
+
+static const u32 members_counts[] = {4, 32, 256};
+static const u32 member_sizes[] = {0x4000, 0x20000};
+
+static inline u16 get16(const u8 * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline u32 get32(const u8 * p)
+{
+    return get16(p) | ((u32)get16(p + 2) << 16);
+}
+
+static void member_name(char * name, u32 index)
+{
+    sprintf(name, "file%04lu.bin", (unsigned long)index);
+}
+
+static bool write_bench_zip(FS_Archive archive, u32 count, u32 member_size, u32 * zip_size)
+{
+    Bench_Zip_Member_s * members = calloc(count, sizeof(Bench_Zip_Member_s));
+    char (* names)[16] = calloc(count, sizeof(*names));
+    u8 * deflated = malloc((u64)count * (member_size + 0x100));
+    bool ok = members != NULL && names != NULL && deflated != NULL;
+
+    u32 deflated_pos = 0;
+    for(u32 i = 0; ok && i < count; i++)
+    {
+        u8 * data = bench_generate_body(member_size, i + 1);
+        member_name(names[i], i);
+        members[i].name = names[i];
+        members[i].method = 8;
+        members[i].data = deflated + deflated_pos;
+        members[i].compressed_size = bench_deflate_raw(data, member_size, deflated + deflated_pos, member_size + 0x100);
+        members[i].size = member_size;
+        members[i].crc = crc32(0, data, member_size);
+        deflated_pos += members[i].compressed_size;
+        ok = members[i].compressed_size != 0;
+        free(data);
+    }
+
+    u8 * zip = ok ? bench_build_zip(members, count, zip_size) : NULL;
+    ok = zip != NULL && bench_write_file(archive, BENCH_FILE, zip, *zip_size);
+
+    free(zip);
+    free(deflated);
+    free(names);
+    free(members);
+    return ok;
+}
+
+// Through the central directory, what zip_file_to_buf does now
+static u32 read_direct(FS_Archive archive, const char * name, char ** buf)
+{
+    *buf = NULL;
+    Zip_s zip;
+    if(R_FAILED(zip_open(&zip, archive, fsMakePath(PATH_ASCII, BENCH_FILE))))
+        return 0;
+
+    const Zip_Entry_s * entry = zip_find(&zip, name);
+    const u32 size = entry != NULL ? zip_read(&zip, entry, buf) : 0;
+    zip_close(&zip);
+    return size;
+}
+
+// Header after header from the start of the file, reading through the data of the ones that don't match
+static u32 read_walk(FS_Archive archive, const char * name, char ** buf)
+{
+    *buf = NULL;
+    Handle handle;
+    if(R_FAILED(vfs_open_file(&handle, archive, fsMakePath(PATH_ASCII, BENCH_FILE), FS_OPEN_READ)))
+        return 0;
+
+    u8 * block = malloc(WALK_BLOCK);
+    u32 size = 0;
+    u64 offset = 0;
+    u8 header[30];
+    char header_name[0x100];
+    u32 read = 0;
+    while(block != NULL && R_SUCCEEDED(vfs_read(handle, &read, offset, header, sizeof(header))) && read == sizeof(header)
+        && get32(header) == 0x04034B50)
+    {
+        Zip_Entry_s entry = {
+            .method = get16(header + 8),
+            .crc = get32(header + 14),
+            .compressed_size = get32(header + 18),
+            .size = get32(header + 22),
+            .name_length = get16(header + 26),
+        };
+        const u16 extra_length = get16(header + 28);
+        if(entry.name_length >= sizeof(header_name)
+            || R_FAILED(vfs_read(handle, &read, offset + sizeof(header), header_name, entry.name_length)) || read != entry.name_length)
+            break;
+        header_name[entry.name_length] = '\0';
+        offset += sizeof(header) + entry.name_length + extra_length;
+
+        if(!strcasecmp(header_name, name))
+        {
+            u8 * compressed = malloc(entry.compressed_size);
+            *buf = malloc(entry.size);
+            if(compressed != NULL && *buf != NULL
+                && R_SUCCEEDED(vfs_read(handle, &read, offset, compressed, entry.compressed_size)) && read == entry.compressed_size
+                && zip_inflate(&entry, compressed, (u8 *)*buf))
+                size = entry.size;
+            free(compressed);
+            break;
+        }
+
+        for(u32 done = 0; done < entry.compressed_size; done += read)
+        {
+            if(R_FAILED(vfs_read(handle, &read, offset + done, block, min(WALK_BLOCK, entry.compressed_size - done))) || read == 0)
+                break;
+        }
+        offset += entry.compressed_size;
+    }
+
+    free(block);
+    vfs_close(handle);
+    if(size == 0)
+    {
+        free(*buf);
+        *buf = NULL;
+    }
+    return size;
+}
+
+typedef u32 (*Read_f)(FS_Archive archive, const char * name, char ** buf);
+
+// Microseconds per lookup, 0 when the member didn't come out as it went in
+static double time_lookup(FS_Archive archive, Read_f read_member, u32 index, u32 member_size)
+{
+    char name[16];
+    member_name(name, index);
+    u8 * expected = bench_generate_body(member_size, index + 1);
+
+    u32 runs = 0;
+    bool ok = true;
+    const double start = bench_now();
+    double elapsed = 0;
+    do {
+        char * buf = NULL;
+        ok = read_member(archive, name, &buf) == member_size && !memcmp(buf, expected, member_size);
+        free(buf);
+        runs++;
+        elapsed = bench_now() - start;
+    } while(ok && elapsed < MIN_SECONDS);
+
+    free(expected);
+    return ok ? elapsed * 1e6 / runs : 0;
+}
+
+int main(void)
+{
+    const FS_Archive archive = bench_open_sdmc(BENCH_ROOT);
+    if(archive == 0)
+    {
+        DEBUG("can't set up %s\n", BENCH_ROOT);
+        return 1;
+    }
+
+    bool ok = true;
+    printf("members  member size   zip size  position  central dir      walk\n");
+    for(size_t i = 0; ok && i < sizeof(members_counts) / sizeof(members_counts[0]); i++)
+    {
+        for(size_t j = 0; ok && j < sizeof(member_sizes) / sizeof(member_sizes[0]); j++)
+        {
+            const u32 count = members_counts[i];
+            const u32 member_size = member_sizes[j];
+            u32 zip_size = 0;
+            if(!write_bench_zip(archive, count, member_size, &zip_size))
+            {
+                DEBUG("can't write a zip of %lu members\n", (unsigned long)count);
+                ok = false;
+                break;
+            }
+
+            static const char * const position_names[] = {"first", "middle", "last"};
+            const u32 positions[] = {0, count / 2, count - 1};
+            for(int p = 0; p < 3; p++)
+            {
+                const double direct = time_lookup(archive, read_direct, positions[p], member_size);
+                const double walk = time_lookup(archive, read_walk, positions[p], member_size);
+                printf("%7lu  %11lu  %9lu  %-8s  %8.1f us  %8.1f us%s\n", (unsigned long)count, (unsigned long)member_size,
+                       (unsigned long)zip_size, position_names[p], direct, walk, direct != 0 && walk != 0 ? "" : "  WRONG DATA");
+                ok = ok && direct != 0 && walk != 0;
+            }
+        }
+    }
+
+    vfs_close_archive(archive);
+    return ok ? 0 : 1;
+}
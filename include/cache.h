@@ -0,0 +1,45 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "common.h"
+
+// What the lists keep under /3ds/Anemone3DS/cache is one file per folder and
+// kind of data, named after a hash of the folder's path
+
+#define CACHE_PATH_SIZE 0x40
+
+#define FNV_OFFSET_BASIS 0x811C9DC5
+#define FNV_PRIME 0x01000193
+
+// FNV-1a over the UTF-16 units of a file name, for the caches' lookup tables
+u32 hash_file_name(const u16 * name, size_t len);
+// Writes the path of the kind cache of the folder at loading_path to out, which holds CACHE_PATH_SIZE
+void cache_file_path(char * out, const char * kind, const char * loading_path);
+
+#endif
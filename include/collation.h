@@ -0,0 +1,46 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include "common.h"
+
+// Sort keys for UTF-16 text: case folded, fullwidth ASCII mapped to ASCII,
+// then written out as UTF-8, whose byte order is code point order. Keys can be
+// compared with memcmp, shorter first on a tie, or sorted with collation_sort.
+
+#define COLLATION_MAX_BYTES_PER_UNIT 3 // a surrogate pair is 2 units and 4 bytes
+
+// Writes the key for the first max_len units of text (less if it's terminated) to out and returns its length.
+// With out NULL only the length is returned
+u32 collation_key(u8 * out, const u16 * text, size_t max_len);
+
+// Stable MSD radix sort of order by key. Key i is keys[offsets[i]] to keys[offsets[i + 1]].
+// Returns false if there wasn't enough memory, order is untouched then
+bool collation_sort(u32 * order, u32 count, const u8 * keys, const u32 * offsets);
+
+#endif
@@ -30,40 +30,11 @@
 #include "common.h"
 #include "loading.h"
 #include "colors.h"
+#include "ui_feedback.h"
+#include "ui_strings.h"
 
 #define MAX_LINES 10
 
-typedef enum InstallType_e {
-    INSTALL_LOADING_THEMES,
-    INSTALL_LOADING_SPLASHES,
-    INSTALL_LOADING_ICONS,
-
-    INSTALL_SPLASH,
-    INSTALL_SPLASH_DELETE,
-
-    INSTALL_SINGLE,
-    INSTALL_SHUFFLE,
-    INSTALL_BGM,
-    INSTALL_NO_BGM,
-
-    INSTALL_DOWNLOAD,
-    INSTALL_CHECKING_DOWNLOAD,
-    INSTALL_ENTRY_DELETE,
-
-    INSTALL_LOADING_REMOTE_THEMES,
-    INSTALL_LOADING_REMOTE_SPLASHES,
-    INSTALL_LOADING_REMOTE_BADGES,
-    INSTALL_LOADING_REMOTE_PREVIEW,
-    INSTALL_LOADING_REMOTE_BGM,
-
-    INSTALL_DUMPING_THEME,
-    INSTALL_DUMPING_ALL_THEMES,
-    INSTALL_DUMPING_BADGES,
-    INSTALL_BADGES,
-
-    INSTALL_NONE,
-} InstallType;
-
 typedef enum {
     // InstallType text
     TEXT_INSTALL_LOADING_THEMES,
@@ -128,15 +99,8 @@ typedef enum {
     TEXT_AMOUNT
 } Text;
 
-typedef enum {
-    ERROR_LEVEL_ERROR,
-    ERROR_LEVEL_WARNING,
-} ErrorLevel;
-
 #define BUTTONS_START_Y 130
 #define BUTTONS_STEP 22
-#define BUTTONS_INFO_LINES 4
-#define BUTTONS_INFO_COLUNMNS 2
 
 typedef enum {
     BUTTONS_Y_INFO = BUTTONS_START_Y+5,
@@ -151,11 +115,6 @@ typedef enum {
     BUTTONS_X_MAX = 380,
 } ButtonPos;
 
-typedef struct {
-    const char * info_line;
-    const char * instructions[BUTTONS_INFO_LINES][BUTTONS_INFO_COLUNMNS];
-} Instructions_s;
-
 extern C3D_RenderTarget * top;
 extern C3D_RenderTarget * bottom;
 extern C2D_TextBuf staticBuf, dynamicBuf;
@@ -169,14 +128,10 @@ void start_frame(void);
 void end_frame(void);
 void set_screen(C3D_RenderTarget * screen);
 
-void throw_error(const char * error, ErrorLevel level);
 bool draw_confirm(const char * conf_msg, Entry_List_s * list, DrawMode draw_mode);
 
 void draw_preview(C2D_Image preview, int preview_offset, float preview_scale);
 
-void draw_install(InstallType type);
-void draw_loading_bar(u32 current, u32 max, InstallType type);
-
 void draw_text(float x, float y, float z, float scaleX, float scaleY, Color color, const char * text);
 void draw_text_wrap(float x, float y, float z, float scaleX, float scaleY, Color color, const char * text, float max_width);
 void draw_text_wrap_scaled(float x, float y, float z, Color color, const char * text, float max_scale, float min_scale, float max_width);
@@ -0,0 +1,85 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include "common.h"
+#include "entries_list.h"
+
+// Finds entries with the same content under different names. A background
+// thread fingerprints every entry of a list with the sizes and CRC-32 of the
+// files that matter for it (body_LZ.bin and bgm.bcstm for themes, splash.bin
+// and splashbottom.bin for splashes). Zips already have both in their central
+// directory, folders have their files read. Fingerprints are kept next to the
+// entries index under /3ds/Anemone3DS/cache with the modification stamps they
+// were made with, so only new or changed entries are ever hashed again.
+
+#define DUPLICATES_CACHE_MAGIC 0x50444641 // "AFDP"
+#define DUPLICATES_CACHE_VERSION 1
+
+#define FINGERPRINT_FILES 2
+
+typedef struct {
+    u32 sizes[FINGERPRINT_FILES]; // 0 when the file is missing
+    u32 crcs[FINGERPRINT_FILES];
+} Fingerprint_s;
+
+typedef struct {
+    u32 name_offset; // in the job's names
+    u16 name_len;
+    bool is_zip;
+    bool hashed; // fingerprint is valid
+    u64 mtimes[FINGERPRINT_FILES]; // of the zip, or of every file of a folder
+    Fingerprint_s fingerprint;
+} Duplicates_Item_s;
+
+typedef struct {
+    Thread thread;
+    volatile bool run_thread;
+    volatile bool done; // every item was fingerprinted
+    const char * loading_path;
+    const char * const * files;
+    // the entries as they were when the job started, the list can change in the meantime
+    Entry_Prefix_s prefix;
+    Duplicates_Item_s * items;
+    int items_count;
+    u16 * names;
+    u32 * table; // open addressing on the file name, item index + 1
+    u32 table_size;
+} Duplicates_Job_s;
+
+// Starts fingerprinting the list's entries, visible or not. Returns false if the
+// list has nothing to compare or without enough memory
+bool duplicates_start(Duplicates_Job_s * job, const Entry_List_s * list);
+// Saves what was fingerprinted so far if the job hadn't finished, then frees it
+void duplicates_stop(Duplicates_Job_s * job);
+// Once the job is done, numbers every set of entries with the same fingerprint from 1,
+// by entry id in groups, 0 for the entries without a duplicate. Entries added after the job
+// started are left out. Returns the amount of sets, -1 without enough memory
+int duplicates_group(const Duplicates_Job_s * job, const Entry_List_s * list, u32 ** groups);
+
+#endif
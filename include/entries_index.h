@@ -0,0 +1,72 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef ENTRIES_INDEX_H
+#define ENTRIES_INDEX_H
+
+#include "common.h"
+#include "entries_list.h"
+
+// On-SD cache of what load_entries gets out of every info.smdh, one file per
+// loading path under /3ds/Anemone3DS/cache. Records are keyed by file name and
+// only used while the size and modification stamp they were made with still
+// match, so an unchanged folder loads without opening a single entry.
+// Records also say where the entry's icon is in the icon pack saved with them.
+
+#define ENTRIES_INDEX_MAGIC 0x58444941 // "AIDX"
+#define ENTRIES_INDEX_VERSION 2
+
+typedef struct {
+    u64 size; // zip size, 0 for folders
+    u64 mtime; // of the zip, or of the folder's info.smdh (0 when it has none)
+} Entry_Stamp_s;
+
+typedef struct {
+    char * data; // the index file, records are read straight out of it
+    u32 data_size;
+    u32 records_count;
+    u32 * table; // open addressing on the file name, offset of the record + 1
+    u32 table_size;
+    u32 hits;
+    u32 pack_id; // of the icon pack the records' icons are in
+} Entries_Index_s;
+
+// a missing or unreadable index just loads empty
+void entries_index_load(Entries_Index_s * index, const char * loading_path);
+// copies name, description, author, placeholder color and pack icon into entry if the index has an up to date record for it,
+// the description only if entry has room for it. Where the record is goes to entry->index_offset
+bool entries_index_fill(Entries_Index_s * index, Entry_s * entry, const Entry_Stamp_s * stamp);
+// reads the description of an entry filled from the index for loading_path back out of it, without loading the rest
+bool entries_index_read_desc(const char * loading_path, const Entry_s * entry, u16 * desc);
+// true once every entry was filled from the index and no record went unused
+bool entries_index_up_to_date(const Entries_Index_s * index, int entries_count);
+void entries_index_free(Entries_Index_s * index);
+
+// replaces the index for loading_path with the list's entries, stamps parallel to list->entries, their icons in the pack pack_id.
+// The descriptions the entries don't have are taken from previous, their index_offset is updated
+Result entries_index_save(const char * loading_path, Entry_List_s * list, const Entry_Stamp_s * stamps, const Entries_Index_s * previous, u32 pack_id);
+
+#endif
@@ -28,6 +28,9 @@
 #define ENTRIES_LIST_H
 
 #include "common.h"
+#include "zip.h"
+#include "search_index.h"
+#include "ui_feedback.h"
 #include <jansson.h>
 
 typedef enum {
@@ -36,34 +39,110 @@ typedef enum {
     SORT_NAME,
     SORT_AUTHOR,
     SORT_PATH,
+
+    SORT_MODES_AMOUNT,
 } SortMode;
 
+// What's only needed for the selected entry or when opening it, kept out of Entry_s
+// so sorting and drawing the list don't drag it through the cache
+typedef struct {
+    u16 desc[0x81];
+} Entry_Cold_s;
+
+// Fixed size records handed out from blocks that never move, so pointers to them stay valid
+// for as long as the list. Removed records are put aside to be handed out again
+typedef struct {
+    void ** blocks;
+    int blocks_count;
+    int used; // records handed out from the blocks, the free ones included
+    void * free_records; // each starts with a pointer to the next one
+} Entry_Pool_s;
+
+#define ENTRY_BLOCK_SIZE 64 // entries in a block of the entry pool
+#define ENTRY_COLD_BLOCK_SIZE 64
+// Past this many entries, a list loaded from its index leaves the descriptions there
+// and reads the ones that get shown into a small cache
+#define ENTRY_COLD_RESIDENT_MAX 1024
+#define ENTRY_DESC_CACHE_SIZE 8
+
+// The folder all the entries of a list are in, so they only keep their file name
 typedef struct {
     u16 path[0x106];
+    u16 len;
+} Entry_Prefix_s;
+
+#define ENTRY_NO_ICON 0xFFFFFFFF // for pack_icon, the entry has no icon to read
+
+#define ENTRY_NAMES_BLOCK_SIZE 0x800 // in units, a block holds many file names
+#define ENTRY_PATH_SIZE 0x120 // in units, for an entry's path and a file inside it
+
+typedef struct {
+    const Entry_Prefix_s * prefix;
+    const u16 * file_name; // in the list's name blocks, terminated
+    u16 file_name_len;
+    u16 icon_slot; // 1 + the slot of the list's icon atlas holding its icon, 0 without one
+    u16 * desc; // in the list's cold store, NULL while it's left in the index. Use list_entry_desc to read it
     bool is_zip;
     bool in_shuffle;
     bool no_bgm_shuffle;
     bool installed;
     u32 placeholder_color; // doubles as not-info-loaded when == 0
+    u32 id; // position in the order the list was loaded in, what sort_orders refer to
+    u32 index_offset; // of the entry's record in the on-SD index, 0 without one
+    u32 pack_icon; // 1 + where its icon is in the list's icon pack, 0 if it isn't there
 
     json_int_t tp_download_id;
     u16 name[0x41];
-    u16 desc[0x81];
     u16 author[0x41];
 } Entry_s;
 
 typedef struct {
     Tex3DS_SubTexture subtex;
     u16 x, y;
+    // for a local list's atlas: whose icon this is, and the slots used just before and after it, -1 at either end
+    Entry_s * entry;
+    s16 newer, older;
+    bool ready; // the entry's icon has been copied to the slot, it isn't only claimed
+    bool requested; // the icon loader has been asked for it and hasn't answered yet
+    u16 claims; // goes up whenever the slot changes hands, so answers for a previous owner are told apart
 } Entry_Icon_s;
 
 typedef struct {
-    Entry_s * entries;
+    const Entry_s * entry;
+    u16 desc[0x81];
+} Entry_Desc_Cache_s;
+
+// The bytes of a texture's data written since the GPU was last made to see them, none when start == end
+typedef struct {
+    u32 start, end;
+} Texture_Range_s;
+
+typedef struct {
+    Entry_s ** entries; // in the order they're shown, the entries themselves are in entry_pool
     int entries_count;
     int entries_capacity;
+    int hidden_count; // entries after entries_count that don't match the search
+    Entry_Pool_s entry_pool;
+    Entry_Pool_s cold_pool;
+    bool page_cold; // descriptions of entries with a record in the index are only read from it
+    Entry_Desc_Cache_s desc_cache[ENTRY_DESC_CACHE_SIZE];
+    int desc_cache_next;
+    Entry_Prefix_s * prefix;
+    Handle icon_pack; // open while the list is, 0 without one
+    // blocks of ENTRY_NAMES_BLOCK_SIZE, never moved once allocated. Removed entries' names stay until the list is freed
+    u16 ** name_blocks;
+    int name_blocks_count;
+    int name_block_used;
 
     C3D_Tex icons_texture;
+    Texture_Range_s icons_dirty;
     Entry_Icon_s * icons_info;
+    int icons_count; // slots in the icon atlas, 0 for a remote list
+    s16 icons_newest, icons_oldest; // ends of the atlas' slots in the order they were last used
+    // where the icon thread sees the scroll going, to load icons before they're shown
+    u64 scroll_moved_tick;
+    int scroll_direction; // 1 down, -1 up, 0 when it stopped or jumped
+    u32 scroll_ms_per_entry;
 
     int previous_scroll;
     int scroll;
@@ -80,6 +159,9 @@ typedef struct {
     int entry_size; // size in pixels of an entry icon
 
     SortMode current_sort;
+    u32 * sort_orders[SORT_MODES_AMOUNT]; // entry ids per sort mode, built on first use
+    Search_Index_s search_index; // built on the first search
+    u8 * search_matches; // by entry id, while a search filter is applied
 
     json_int_t tp_current_page;
     json_int_t tp_page_count;
@@ -87,20 +169,74 @@ typedef struct {
     const char * loading_path;
 } Entry_List_s;
 
+// Lets several files be read from the same entry while only opening its zip once
+typedef struct {
+    const Entry_s * entry;
+    u16 path[ENTRY_PATH_SIZE]; // the entry's path, the file being read goes after it
+    u32 path_len;
+    bool zip_tried;
+    bool zip_opened;
+    Zip_s zip;
+} Entry_Session_s;
+
 void sort_by_name(Entry_List_s * list);
 void sort_by_author(Entry_List_s * list);
 void sort_by_filename(Entry_List_s * list);
 
 void delete_entry(Entry_s * entry, bool is_file);
 // assumes list has been memset to 0
-typedef enum InstallType_e InstallType;
 Result load_entries(const char * loading_path, Entry_List_s * list, const InstallType loading_screen);
 u32 load_data(const char * filename, const Entry_s * entry, char ** buf);
+void entry_session_open(Entry_Session_s * session, const Entry_s * entry);
+u32 entry_session_load(Entry_Session_s * session, const char * filename, char ** buf);
+u32 entry_session_load_deflated(Entry_Session_s * session, const char * filename, char ** buf, Zip_Entry_s * member);
+u32 entry_session_load_into(Entry_Session_s * session, const char * filename, char * buf, u32 max_size);
+u32 entry_session_copy_to_file(Entry_Session_s * session, const char * filename, Handle dest, u64 dest_offset, u32 max_size);
+void entry_session_close(Entry_Session_s * session);
 C2D_Image get_icon_at(Entry_List_s * list, size_t index);
 
+// The icon atlas of a local list keeps the icons around the ones shown. Entries find their slot through icon_slot,
+// and a slot needed for another icon is taken from whichever was used the longest ago, all in constant time.
+// Empties every slot, icons_info has to hold icons_count of them
+void list_reset_icons(Entry_List_s * list);
+// The slot holding entry's icon, marked as just used, or -1
+int list_use_icon(Entry_List_s * list, const Entry_s * entry);
+// Gives entry the slot used the longest ago, taking it from the entry holding it. It isn't ready until its icon is copied there
+int list_claim_icon(Entry_List_s * list, Entry_s * entry);
+
 // assumes list doesn't have any elements yet
 void list_init_capacity(Entry_List_s * list, const int init_capacity);
 // assumes list has been inited with a non zero capacity
+// the new entry is zeroed, with its description in the cold store and in the list's folder
 ssize_t list_add_entry(Entry_List_s * list);
+// Sets the folder of the entries added from then on. Returns false without enough memory
+bool list_set_prefix(Entry_List_s * list, const char * path);
+// Copies len units of file_name to the list's name blocks for entry. Returns false without enough memory
+bool list_set_file_name(Entry_List_s * list, Entry_s * entry, const u16 * file_name, size_t len);
+// Writes the entry's path, followed by inner if it isn't NULL, to out, which needs room for ENTRY_PATH_SIZE units.
+// Everything's length is known, so nothing is scanned for its end
+FS_Path entry_path(const Entry_s * entry, const char * inner, u16 * out);
+// Gives entry a description of its own in the cold store, returns false without enough memory
+bool list_keep_desc(Entry_List_s * list, Entry_s * entry);
+// The entry's description, read from the index if the list left it there. Only valid until the next call
+const u16 * list_entry_desc(Entry_List_s * list, const Entry_s * entry);
+void list_free_entries(Entry_List_s * list);
+
+// Adds the entry at path where the current sort puts it, reading its info.smdh, and keeps the selected entry selected.
+// Clears the search. Returns the new entry's index, or -1 without enough memory
+ssize_t list_insert_entry(Entry_List_s * list, const u16 * path, bool is_zip);
+// Drops the entry at index, the others keep their order. An index past the entries, hidden ones included, is ignored.
+// Clears the search when it leaves no entry shown
+void list_remove_entry(Entry_List_s * list, int index);
+// Returns the index of the entry at path, visible or not, or -1
+ssize_t list_find_entry(const Entry_List_s * list, const u16 * path);
+
+// Only shows the entries whose name, author or file name contain query, ignoring case.
+// An empty query shows everything again. Returns false if nothing matched, the list is left as it was then
+bool list_search(Entry_List_s * list, const u16 * query);
+void list_clear_search(Entry_List_s * list);
+// Only shows the entries in a group, by entry id in groups from 1 to groups_count with 0 for none,
+// every group together. Until the list is sorted again, that's also how it's ordered. Returns false if nothing was shown
+bool list_show_groups(Entry_List_s * list, const u32 * groups, int groups_count);
 
 #endif
@@ -30,6 +30,8 @@
 #include "common.h"
 #include "badges.h"
 #include "config.h"
+#include "zip.h"
+#include "vfs.h"
 
 #define ILLEGAL_CHARS "><\"?;:/\\+,.|[=]*\n\r"
 
@@ -55,6 +57,13 @@ typedef struct {
     u32 coppa : 1;
 } Parental_Restrictions_s;
 
+// A theme or splash written to the SD card, for the lists to take in without reading their folder again
+typedef struct {
+    RemoteMode mode;
+    bool is_zip;
+    u16 path[0x106];
+} Saved_Entry_s;
+
 Result init_sd(void);
 Result open_archives(void);
 Result open_badge_extdata(void);
@@ -62,15 +71,29 @@ Result close_archives(void);
 Result load_parental_controls(Parental_Restrictions_s *restrictions);
 
 u32 file_to_buf(FS_Path path, FS_Archive archive, char ** buf);
+u32 file_to_given_buf(FS_Path path, FS_Archive archive, char * buf, u32 max_size);
+u32 file_to_handle(FS_Path path, FS_Archive archive, Handle dest, u64 dest_offset, u32 max_size);
 u32 zip_memory_to_buf(const char * file_name, void * zip_memory, size_t zip_size, char ** buf);
 u32 zip_file_to_buf(const char * file_name, const u16 * zip_path, char ** buf);
+u32 zip_opened_file_to_buf(const Zip_s * zip, const char * file_name, const u16 * zip_path, char ** buf);
+u32 zip_opened_file_to_given_buf(const Zip_s * zip, const char * file_name, const u16 * zip_path, char * buf, u32 max_size);
+u32 zip_opened_file_to_handle(const Zip_s * zip, const char * file_name, const u16 * zip_path, Handle dest, u64 dest_offset, u32 max_size);
 u32 decompress_lz_file(FS_Path file_name, FS_Archive archive, char ** buf);
-u32 compress_lz_file_fast(FS_Path path, FS_Archive archive, char * in_buf, u32 size);
+bool read_lz_file_byte(FS_Path path, FS_Archive archive, u32 offset, u8 * value);
+u32 patch_lz_file(FS_Path path, FS_Archive archive, u32 compressed_size, u32 offset, u8 value);
+u32 compress_lz_file(FS_Path path, FS_Archive archive, char * in_buf, u32 size);
 
 Result buf_to_file(u32 size, FS_Path path, FS_Archive archive, char * buf);
+Result zero_handle_range(Handle handle, u64 offset, u64 size);
 Result zero_handle_memeasy(Handle handle);
+Result create_file_sized(FS_Path path, FS_Archive archive, u32 size);
+Result rewrite_file(FS_Path path, FS_Archive archive, u32 file_size, const char * buf, u32 size);
 void remake_file(FS_Path path, FS_Archive archive, u32 size);
 void save_zip_to_sd(char * filename, u32 size, char * buf, RemoteMode mode);
+void note_saved_entry(RemoteMode mode, const u16 * path, bool is_zip);
+// Hands over what was noted since the last call, to be freed by the caller.
+// Returns false if something couldn't be noted, the folders have to be read again then
+bool take_saved_entries(Saved_Entry_s ** entries, int * count);
 s16 for_each_file_zip(u16 *zip_path, u32 (*zip_iter_callback)(char *filebuf, u64 file_size, const char *name, void *userdata), void *userdata);
 
 #endif
@@ -0,0 +1,68 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef ICON_PACK_H
+#define ICON_PACK_H
+
+#include "common.h"
+#include "write_batch.h"
+
+// On-SD cache of every entry's big icon, one file per loading path under
+// /3ds/Anemone3DS/cache next to the entries index. Icons are kept as they are
+// in info.smdh, which is already the tiled RGB565 the icon atlas takes, so
+// showing one is a small read without opening the entry, and icons at
+// consecutive places are read together. The index records where each entry's
+// icon is and which pack that was, its stamps tell when an icon is outdated.
+
+#define ICON_PACK_MAGIC 0x50434941 // "AICP"
+#define ICON_PACK_VERSION 1
+#define ICON_PACK_ICON_SIZE (48 * 48 * sizeof(u16))
+#define ICON_PACK_READ_MAX 8 // icons read at once when they're one after the other
+// a pack holding more than twice as many icons as there are entries, plus this, is started over
+#define ICON_PACK_SLACK 64
+
+typedef struct {
+    Handle file; // 0 without a pack
+    u32 id; // a new one every time the pack is started over
+    u32 icons_count; // places handed out, icons are only appended
+    bool changed;
+    Write_Batch_s batch;
+    LightLock lock;
+} Icon_Pack_s;
+
+// Opens the pack for loading_path if it's the one the index was saved with, or starts over with an empty one.
+// Without a pack, file is left at 0 and nothing gets written
+void icon_pack_open(Icon_Pack_s * pack, const char * loading_path, u32 id, u32 entries_count);
+// Hands out count places from the end of the pack, returns the first one
+u32 icon_pack_reserve(Icon_Pack_s * pack, u32 count);
+// Writes an icon to a place that was handed out, from any thread. Nothing is read back until the pack is committed
+void icon_pack_write(Icon_Pack_s * pack, u32 position, const u16 * icon);
+// Writes out the icons and the header. The file stays open, for reading icons out of it
+Result icon_pack_commit(Icon_Pack_s * pack);
+// Reads count icons from position on into buf, returns how many were read
+u32 icon_pack_read(Handle file, u32 position, u32 count, u16 * buf);
+
+#endif
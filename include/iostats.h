@@ -0,0 +1,94 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include "common.h"
+
+// Per phase, call site, archive and operation I/O accounting: count, bytes
+// and a latency histogram. Only built with `make IOSTATS=1`, otherwise
+// every hook below compiles to nothing.
+//
+// A phase is a step of an install (IOSTATS_PHASE), a site is the fs.c helper
+// the I/O went through (IOSTATS_SITE). Both last until the end of the
+// enclosing block, and I/O outside any site is counted as "direct".
+
+typedef enum {
+    IOSTATS_OP_OPEN = 0,
+    IOSTATS_OP_READ,
+    IOSTATS_OP_WRITE,
+    IOSTATS_OP_CREATE,
+    IOSTATS_OP_DELETE,
+    IOSTATS_OP_READ_DIR,
+
+    IOSTATS_OP_AMOUNT,
+} IoStats_Op;
+
+#ifdef IOSTATS
+
+const char * iostats_enter_phase(const char * phase);
+void iostats_leave_phase(const char ** previous);
+const char * iostats_enter_site(const char * site);
+void iostats_leave_site(const char ** previous);
+
+void iostats_name_archive(FS_Archive archive, const char * name);
+void iostats_track_handle(Handle handle, FS_Archive archive);
+void iostats_untrack_handle(Handle handle);
+
+u64 iostats_now(void);
+void iostats_record(IoStats_Op op, FS_Archive archive, u32 bytes, u64 start);
+void iostats_record_handle(IoStats_Op op, Handle handle, u32 bytes, u64 start);
+
+// prints everything recorded since the last report on the debug console,
+// saves it as JSON to /3ds/Anemone3DS/iostats_<what>.json, then starts over
+void iostats_report(const char * what);
+
+#define IOSTATS_CONCAT_(a, b) a##b
+#define IOSTATS_CONCAT(a, b) IOSTATS_CONCAT_(a, b)
+// don't goto past these, the cleanup has to run
+#define IOSTATS_PHASE(name) const char * IOSTATS_CONCAT(iostats_phase_, __LINE__) __attribute__((cleanup(iostats_leave_phase), unused)) = iostats_enter_phase(name)
+#define IOSTATS_SITE(name) const char * IOSTATS_CONCAT(iostats_site_, __LINE__) __attribute__((cleanup(iostats_leave_site), unused)) = iostats_enter_site(name)
+#define IOSTATS_START() const u64 iostats_start_ = iostats_now()
+#define IOSTATS_RECORD(op, archive, bytes) iostats_record(op, archive, bytes, iostats_start_)
+#define IOSTATS_RECORD_HANDLE(op, handle, bytes) iostats_record_handle(op, handle, bytes, iostats_start_)
+
+#else
+
+#define iostats_name_archive(archive, name) do {} while(0)
+#define iostats_track_handle(handle, archive) do {} while(0)
+#define iostats_untrack_handle(handle) do {} while(0)
+#define iostats_report(what) do {} while(0)
+
+#define IOSTATS_PHASE(name) do {} while(0)
+#define IOSTATS_SITE(name) do {} while(0)
+#define IOSTATS_START() do {} while(0)
+#define IOSTATS_RECORD(op, archive, bytes) do {} while(0)
+#define IOSTATS_RECORD_HANDLE(op, handle, bytes) do {} while(0)
+
+#endif
+
+#endif
@@ -46,6 +46,10 @@ enum ICON_IDS_OFFSET {
     ICONS_OFFSET_AMOUNT,
 };
 
+// The icon atlas of a local list has room for at least this many of the ICONS_OFFSET_AMOUNT screens loaded
+// around the scroll, so scrolling back or jumping around can find icons still there
+#define ICONS_ATLAS_WINDOWS 2
+
 typedef struct {
     u8 _padding1[4 + 2 + 2];
 
@@ -64,17 +68,69 @@ typedef struct {
     volatile bool run_thread;
 } Thread_Arg_s;
 
-void copy_texture_data(C3D_Tex * texture, const u16 * src, const Entry_Icon_s * current_icon);
+#define ICON_QUEUE_SIZE 16 // a power of 2, icons asked for and not taken back yet
+
+// What the icon loader needs to read an entry's icon, copied so the entry can change or go meanwhile
+typedef struct {
+    Entry_List_s * list;
+    u16 slot;
+    u16 claims; // the slot's when it was asked for
+    u32 generation;
+    const Entry_Prefix_s * prefix;
+    const u16 * file_name;
+    u16 file_name_len;
+    bool is_zip;
+    Handle pack;
+    u32 pack_icon;
+} Icon_Request_s;
+
+typedef struct {
+    Entry_List_s * list;
+    u16 slot;
+    u16 claims;
+    const u16 * pixels; // NULL if there's no icon
+    void * data; // freed once taken. Icons read together are in one buffer, given with the last of them
+    bool skipped; // the scroll moved on before it was read
+} Icon_Result_s;
+
+// The main loop asks for icons and the icon thread answers through a ring each, with nothing held by both.
+// Counters only ever go up and only one side writes each, the slot is the count modulo ICON_QUEUE_SIZE
+typedef struct {
+    Icon_Request_s requests[ICON_QUEUE_SIZE];
+    u32 requests_added, requests_taken;
+    Icon_Result_s results[ICON_QUEUE_SIZE];
+    u32 results_added, results_taken;
+    u32 generation; // goes up when the scroll moves, requests from before then aren't read
+    LightEvent request_added;
+
+    // only used by the main loop
+    Entry_s ** plan;
+    int plan_capacity;
+} Icon_Loader_s;
+
+// Copies an icon to its place in texture, adding it to dirty. The GPU only sees it once dirty is flushed
+void copy_texture_data(C3D_Tex * texture, const u16 * src, const Entry_Icon_s * current_icon, Texture_Range_s * dirty);
+// One cache maintenance call for everything copied to texture since the last one
+void flush_texture_data(C3D_Tex * texture, Texture_Range_s * dirty);
 void parse_smdh(Icon_s * icon, Entry_s * entry, const u16 * fallback_name);
 
 
 bool load_preview_from_buffer(char * row_pointers, u32 size, C2D_Image * preview_image, int * preview_offset, int height);
-bool load_preview(const Entry_List_s * list, C2D_Image * preview_image, int * preview_offset);
+bool load_preview(Entry_Session_s * session, C2D_Image * preview_image, int * preview_offset);
 void free_preview(C2D_Image preview_image);
-Result load_audio(const Entry_s *, audio_s *);
+Result load_audio(Entry_Session_s *, audio_s *);
 Result load_audio_ogg(const Entry_s * entry, audio_ogg_s * audio);
+// Loads the icons around the scroll that aren't in the list's atlas already
 void load_icons_first(Entry_List_s * current_list, bool silent);
 void handle_scrolling(Entry_List_s * list);
+
+void icon_loader_init(Icon_Loader_s * loader);
+// Called by the main loop every frame: puts the icons read since in their list's atlas, follows the scroll
+// and asks for the icons it needs next. Never waits on the icon thread
+void update_icons(Entry_List_s * list, Icon_Loader_s * loader);
+// Once the icon thread has stopped, takes what it left in the rings so nothing is waited for anymore
+void icon_loader_drain(Icon_Loader_s * loader);
+// thread_arg[0] is the Icon_Loader_s, stops once run_thread is cleared and request_added signaled
 void load_icons_thread(void * void_arg);
 
 #endif
@@ -0,0 +1,53 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef LZ_H
+#define LZ_H
+
+#include "common.h"
+
+// LZ11 is the format used for body_LZ.bin / BodyCache.bin
+#define LZ11_MAGIC 0x11
+#define LZ11_HEADER_SIZE 4
+#define LZ11_MAX_SIZE 0xFFFFFF
+
+// speed/ratio tradeoff for lz11_compress, higher is smaller but slower
+#define LZ11_LEVEL_FASTEST 1
+#define LZ11_LEVEL_DEFAULT 3
+#define LZ11_LEVEL_BEST 9
+
+u32 lz11_compress_bound(u32 size);
+u32 lz11_compress(const u8 * in, u32 size, u8 * out, int level);
+
+// return false to stop decompressing
+typedef bool (*Lz11_Output_cb)(void * userdata, const u8 * data, u32 size);
+
+u32 lz11_decompressed_size(const u8 * header);
+u32 lz11_decompress_file(Handle handle, u8 * out, u32 out_size);
+u32 lz11_decompress_file_stream(Handle handle, Lz11_Output_cb output, void * userdata);
+u32 lz11_patch_file(Handle handle, u32 compressed_size, u32 offset, u8 value);
+
+#endif
@@ -55,7 +55,8 @@
 #define THEMEPLAZA_ICON_FORMAT       THEMEPLAZA_DOWNLOAD_FORMAT  "/preview/icon"
 #define THEMEPLAZA_SMDH_FORMAT       THEMEPLAZA_DOWNLOAD_FORMAT  "/smdh"
 
-#define CACHE_PATH_FORMAT            "/3ds/"  APP_TITLE  "/cache/%"  JSON_INTEGER_FORMAT
+#define CACHE_PATH                   "/3ds/"  APP_TITLE  "/cache/"
+#define CACHE_NAME_FORMAT            "%"  JSON_INTEGER_FORMAT
 
 typedef struct {
     char *result_buf;
@@ -0,0 +1,54 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include "common.h"
+
+// Substring search over one folded text per entry. Every 3 byte window of the
+// texts is hashed into a bucket listing the entries it appears in, so a query
+// only has to check the entries of its rarest trigram instead of every text.
+// Shorter queries fall back to checking every text.
+
+#define SEARCH_BUCKETS 4096
+#define SEARCH_FIELD_SEPARATOR 0 // can't be typed, so no match goes across fields
+
+typedef struct {
+    u8 * texts;
+    u32 * text_offsets; // text i is texts[text_offsets[i]] to texts[text_offsets[i + 1]]
+    u32 * bucket_starts; // bucket b is postings[bucket_starts[b]] to postings[bucket_starts[b + 1]]
+    u32 * postings; // entry indices, ascending and without repeats in a bucket
+    u32 count;
+} Search_Index_s;
+
+// takes ownership of texts and text_offsets, freeing them if it fails
+bool search_index_build(Search_Index_s * index, u8 * texts, u32 * text_offsets, u32 count);
+// sets matches[i] for every text containing query (already folded) and returns how many did
+u32 search_index_query(const Search_Index_s * index, const u8 * query, u32 query_len, u8 * matches);
+void search_index_free(Search_Index_s * index);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef SMDH_PIPELINE_H
+#define SMDH_PIPELINE_H
+
+#include "common.h"
+#include "entries_list.h"
+#include "icon_pack.h"
+
+// Fills in name, description and author of list entries from their info.smdh.
+// The calling thread only reads, deflated smdh are left compressed and handed
+// over with the reading done to workers on every core that lets the app run a
+// thread (the syscore with the time limit from init_services, the extra New 3DS
+// cores), which inflate and parse them. Every result goes to the entry it came
+// from, so the list ends up the same as with a serial pass. With an icon pack,
+// the entries' icons are written to it too, in the order they were read.
+
+#define SMDH_PIPELINE_SLOTS 16
+#define SMDH_PIPELINE_MAX_WORKERS 4
+#define SMDH_PIPELINE_STACK_SIZE 0x4000
+
+// indices are the entries to load, in the order they should be read. pack can be NULL
+void smdh_pipeline_run(Entry_List_s * list, const int * indices, int count, InstallType loading_screen, Icon_Pack_s * pack);
+
+#endif
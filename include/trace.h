@@ -0,0 +1,67 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common.h"
+
+// Timeline of where the time goes during startup, installs and remote browsing.
+// Only built with `make TRACE=1`, otherwise every hook below compiles to nothing.
+//
+// A span (TRACE_SPAN) lasts until the end of the enclosing block and is kept in
+// a fixed ring buffer once it ends, the oldest ones making room for the newest.
+// Times are in microseconds since the first span, from the system tick on the
+// console and from the monotonic clock on the host.
+
+#ifdef TRACE
+
+typedef struct {
+    const char * name; // has to outlive the report, a string literal
+    u64 start;
+} Trace_Span_s;
+
+u64 trace_now(void);
+void trace_end_span(const Trace_Span_s * span);
+
+// saves the spans recorded since the last report to /3ds/Anemone3DS/trace_<what>.json
+// in the Chrome trace event format, for chrome://tracing or Perfetto, then starts over
+void trace_report(const char * what);
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// don't goto past these, the cleanup has to run
+#define TRACE_SPAN(name) const Trace_Span_s TRACE_CONCAT(trace_span_, __LINE__) __attribute__((cleanup(trace_end_span), unused)) = {name, trace_now()}
+
+#else
+
+#define trace_report(what) do {} while(0)
+
+#define TRACE_SPAN(name) do {} while(0)
+
+#endif
+
+#endif
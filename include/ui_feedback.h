@@ -0,0 +1,76 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef UI_FEEDBACK_H
+#define UI_FEEDBACK_H
+
+#include "common.h"
+
+// What the installing, loading and file code shows the user while it works.
+// draw.c puts it on the screens, the host benchmarks link bench/host/ui.c instead
+
+typedef enum InstallType_e {
+    INSTALL_LOADING_THEMES,
+    INSTALL_LOADING_SPLASHES,
+    INSTALL_LOADING_ICONS,
+
+    INSTALL_SPLASH,
+    INSTALL_SPLASH_DELETE,
+
+    INSTALL_SINGLE,
+    INSTALL_SHUFFLE,
+    INSTALL_BGM,
+    INSTALL_NO_BGM,
+
+    INSTALL_DOWNLOAD,
+    INSTALL_CHECKING_DOWNLOAD,
+    INSTALL_ENTRY_DELETE,
+
+    INSTALL_LOADING_REMOTE_THEMES,
+    INSTALL_LOADING_REMOTE_SPLASHES,
+    INSTALL_LOADING_REMOTE_BADGES,
+    INSTALL_LOADING_REMOTE_PREVIEW,
+    INSTALL_LOADING_REMOTE_BGM,
+
+    INSTALL_DUMPING_THEME,
+    INSTALL_DUMPING_ALL_THEMES,
+    INSTALL_DUMPING_BADGES,
+    INSTALL_BADGES,
+
+    INSTALL_NONE,
+} InstallType;
+
+typedef enum {
+    ERROR_LEVEL_ERROR,
+    ERROR_LEVEL_WARNING,
+} ErrorLevel;
+
+void throw_error(const char * error, ErrorLevel level);
+
+void draw_install(InstallType type);
+void draw_loading_bar(u32 current, u32 max, InstallType type);
+
+#endif
@@ -28,9 +28,16 @@
 #define UISTRINGS_H
 
 #include "colors.h"
-#include "draw.h"
 #include "common.h"
 
+#define BUTTONS_INFO_LINES 4
+#define BUTTONS_INFO_COLUNMNS 2
+
+typedef struct {
+    const char * info_line;
+    const char * instructions[BUTTONS_INFO_LINES][BUTTONS_INFO_COLUNMNS];
+} Instructions_s;
+
 typedef struct {
     const char *quit;
     const char *thread_error;
@@ -115,6 +122,8 @@ typedef struct {
     const char *not_enough_themes;
     const char *uninstall_confirm;
     const char *delete_confirm;
+    const char *duplicates_pending;
+    const char *no_duplicates;
 } Main_Strings_s;
 
 typedef struct {
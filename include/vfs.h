@@ -0,0 +1,63 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef VFS_H
+#define VFS_H
+
+#include "common.h"
+
+// Thin layer over the archive and file services, so the install and list
+// loading paths don't talk to FSUSER/FSFILE directly.
+// Built for the 3DS it forwards to fs:USER. Built for anything else, every
+// archive is a directory under $ANEMONE_VFS_ROOT (default "vfs"):
+//     sdmc/                 ARCHIVE_SDMC
+//     extdata/<id>/         ARCHIVE_EXTDATA, id as 8 hex digits
+// File and directory handles are plain descriptors there.
+
+Result vfs_open_archive(FS_Archive * archive, FS_ArchiveID id, FS_Path path);
+Result vfs_close_archive(FS_Archive archive);
+
+Result vfs_open_file(Handle * file, FS_Archive archive, FS_Path path, u32 flags);
+Result vfs_close(Handle file);
+Result vfs_read(Handle file, u32 * read, u64 offset, void * buf, u32 size);
+Result vfs_write(Handle file, u32 * written, u64 offset, const void * buf, u32 size, u32 flags);
+Result vfs_flush(Handle file);
+Result vfs_get_size(Handle file, u64 * size);
+Result vfs_set_size(Handle file, u64 size);
+
+Result vfs_create_file(FS_Archive archive, FS_Path path, u64 size);
+Result vfs_delete_file(FS_Archive archive, FS_Path path);
+Result vfs_create_dir(FS_Archive archive, FS_Path path);
+Result vfs_delete_dir_recursively(FS_Archive archive, FS_Path path);
+// Last modification stamp of a file. Only comparable with other stamps from
+// the same backend; the 3DS needs a PATH_UTF16 path for this.
+Result vfs_get_mtime(FS_Archive archive, FS_Path path, u64 * mtime);
+
+Result vfs_open_dir(Handle * dir, FS_Archive archive, FS_Path path);
+Result vfs_read_dir(Handle dir, u32 * read, u32 count, FS_DirectoryEntry * entries);
+Result vfs_close_dir(Handle dir);
+
+#endif
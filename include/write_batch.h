@@ -0,0 +1,64 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef WRITE_BATCH_H
+#define WRITE_BATCH_H
+
+#include "common.h"
+
+// Write combining for one open file: small writes are gathered into a few
+// staging segments, each covering a run of the file, and only go out when a
+// segment fills up or gets evicted. Nothing is flushed until commit.
+// Reads through the same handle don't see staged data, so don't mix them.
+
+#define WRITE_BATCH_SEGMENTS 6
+#define WRITE_BATCH_SEGMENT_SIZE 0x10000
+
+typedef struct {
+    u64 start;
+    u32 len;
+    u32 last_use;
+    u8 * buf;
+} Write_Batch_Segment_s;
+
+typedef struct {
+    Handle handle;
+    u8 * buf;
+    Write_Batch_Segment_s segments[WRITE_BATCH_SEGMENTS];
+    u32 use_counter;
+    bool write_through;
+    Result res;
+} Write_Batch_s;
+
+// the segments are allocated on the first small write, without memory for them writes go straight to the file
+void write_batch_begin(Write_Batch_s * batch, Handle handle);
+Result write_batch_write(Write_Batch_s * batch, u64 offset, const void * data, u32 size);
+// writes out everything staged and flushes the file once. Returns the first error of the batch
+Result write_batch_commit(Write_Batch_s * batch);
+// drops whatever is still staged. What was already written out stays written
+void write_batch_abort(Write_Batch_s * batch);
+
+#endif
@@ -0,0 +1,61 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef ZIP_H
+#define ZIP_H
+
+#include "common.h"
+
+// What's needed from a central directory record to find and read a member
+typedef struct {
+    u32 name_offset;
+    u16 name_length;
+    u16 method;
+    u16 flags;
+    u32 crc;
+    u32 compressed_size;
+    u32 size;
+    u32 local_header_offset;
+} Zip_Entry_s;
+
+typedef struct {
+    Handle handle;
+    Zip_Entry_s * entries;
+    u32 entries_count;
+    char * names;
+} Zip_s;
+
+Result zip_open(Zip_s * zip, FS_Archive archive, FS_Path path);
+void zip_close(Zip_s * zip);
+const Zip_Entry_s * zip_find(const Zip_s * zip, const char * name);
+bool zip_entry_supported(const Zip_Entry_s * entry);
+bool zip_read_into(const Zip_s * zip, const Zip_Entry_s * entry, u8 * out);
+u32 zip_read(const Zip_s * zip, const Zip_Entry_s * entry, char ** buf);
+u32 zip_read_compressed(const Zip_s * zip, const Zip_Entry_s * entry, char ** buf);
+bool zip_inflate(const Zip_Entry_s * entry, const u8 * compressed, u8 * out);
+bool zip_copy_to_file(const Zip_s * zip, const Zip_Entry_s * entry, Handle dest, u64 dest_offset);
+
+#endif
@@ -29,10 +29,14 @@
 // https://github.com/MrCheeze/GYTB
 
 #include "badges.h"
-#include "draw.h"
+#include "ui_feedback.h"
 #include "ui_strings.h"
+#include "iostats.h"
+#include "trace.h"
+#include "write_batch.h"
 
 Handle badgeDataHandle;
+Write_Batch_s badgeDataBatch;
 char *badgeMngBuffer;
 u16 *rgb_buf_64x64;
 u16 *rgb_buf_32x32;
@@ -87,12 +91,12 @@ int install_badge_generic(char *file_buf, u64 file_size, u16 *name, int *badge_c
         remove_exten(name);
         for (int j = 0; j < 16; ++j) // Copy name for all 16 languages
         {
-            FSFILE_Write(badgeDataHandle, NULL, 0x35E80 + *badge_count * 16 * 0x8A + j * 0x8A, name, 0x8A, 0);
+            write_batch_write(&badgeDataBatch, 0x35E80 + *badge_count * 16 * 0x8A + j * 0x8A, name, 0x8A);
         }
-        FSFILE_Write(badgeDataHandle, NULL, 0x318F80 + *badge_count * 0x2800, rgb_buf_64x64 + badge * 64 * 64, 64 * 64 * 2, 0);
-        FSFILE_Write(badgeDataHandle, NULL, 0x31AF80 + *badge_count * 0x2800, alpha_buf_64x64 + badge * 64 * 64/2, 64 * 64/2, 0);
-        FSFILE_Write(badgeDataHandle, NULL, 0xCDCF80 + *badge_count * 0xA00, rgb_buf_32x32 + badge * 32 * 32, 32 * 32 * 2, 0);
-        FSFILE_Write(badgeDataHandle, NULL, 0xCDD780 + *badge_count * 0xA00, alpha_buf_32x32 + badge * 32 * 32/2, 32 * 32/2, 0);
+        write_batch_write(&badgeDataBatch, 0x318F80 + *badge_count * 0x2800, rgb_buf_64x64 + badge * 64 * 64, 64 * 64 * 2);
+        write_batch_write(&badgeDataBatch, 0x31AF80 + *badge_count * 0x2800, alpha_buf_64x64 + badge * 64 * 64/2, 64 * 64/2);
+        write_batch_write(&badgeDataBatch, 0xCDCF80 + *badge_count * 0xA00, rgb_buf_32x32 + badge * 32 * 32, 32 * 32 * 2);
+        write_batch_write(&badgeDataBatch, 0xCDD780 + *badge_count * 0xA00, alpha_buf_32x32 + badge * 32 * 32/2, 32 * 32/2);
 
         int badge_id = *badge_count + 1;
         memcpy(badgeMngBuffer + 0x3E8 + *badge_count * 0x28 + 0x4, &badge_id, 4);
@@ -171,13 +175,13 @@ int install_badge_dir(FS_DirectoryEntry set_dir, int *badge_count, int set_id)
     utf8_to_utf16(set_icon, (u8 *) "_seticon.png", 16);
     struacat(path, main_paths[REMOTE_MODE_BADGES]);
     strucat(path, set_dir.name);
-    res = FSUSER_OpenDirectory(&folder, ArchiveSD, fsMakePath(PATH_UTF16, path));
+    res = vfs_open_dir(&folder, ArchiveSD, fsMakePath(PATH_UTF16, path));
     if (R_FAILED(res))
     {
         return -1;
     }
     u32 entries_read;
-    res = FSDIR_Read(folder, &entries_read, 1024, badge_files);
+    res = vfs_read_dir(folder, &entries_read, 1024, badge_files);
     int badges_in_set = 0;
     progress_finish += entries_read;
     for (u32 i = 0; i < entries_read && *badge_count < 1000; ++i)
@@ -218,7 +222,7 @@ int install_badge_dir(FS_DirectoryEntry set_dir, int *badge_count, int set_id)
     u32 total_count = 0xFFFF * badges_in_set;
     for (int i = 0; i < 16; ++i)
     {
-        FSFILE_Write(badgeDataHandle, NULL, set_index * 0x8A0 + i * 0x8A, set_dir.name, strulen(set_dir.name, 0x45) * 2 + 2, 0);
+        write_batch_write(&badgeDataBatch, set_index * 0x8A0 + i * 0x8A, set_dir.name, strulen(set_dir.name, 0x45) * 2 + 2);
     }
     badgeMngBuffer[0x3D8 + set_index/8] |= 0 << (set_index % 8);
 
@@ -248,12 +252,12 @@ int install_badge_dir(FS_DirectoryEntry set_dir, int *badge_count, int set_id)
         pngToRGB565(icon_buf, icon_size, rgb_buf_64x64, alpha_buf_64x64, rgb_buf_32x32, alpha_buf_32x32, true);
     }
 
-    free(icon_buf);
-    FSFILE_Write(badgeDataHandle, NULL, 0x250F80 + set_index * 0x2000, rgb_buf_64x64, 64 * 64 * 2, 0);
+    write_batch_write(&badgeDataBatch, 0x250F80 + set_index * 0x2000, rgb_buf_64x64, 64 * 64 * 2);
     badgeMngBuffer[0x3D8 + set_index/8] |= 0 << (set_index % 8);
     end:
+    free(icon_buf);
     free(badge_files);
-    FSDIR_Close(folder);
+    vfs_close_dir(folder);
     return badges_in_set;
 }
 
@@ -294,7 +298,7 @@ SetNode * extract_sets(char *badgeMngBuffer, Handle backupDataHandle)
     {
         u16 set_path[256] = {0};
         struacat(set_path, "/3ds/" APP_TITLE "/BadgeBackups/Unknown Set");
-        FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_UTF16, set_path), FS_ATTRIBUTE_DIRECTORY);
+        vfs_create_dir(ArchiveSD, fsMakePath(PATH_UTF16, set_path));
         return NULL;
     }
 
@@ -313,7 +317,7 @@ SetNode * extract_sets(char *badgeMngBuffer, Handle backupDataHandle)
         {
             DEBUG("Processing icon for set %lu at index %lu\n", cursor->set_id, cursor->set_index);
             u16 utf16SetName[0x46] = {0};
-            FSFILE_Read(backupDataHandle, NULL, cursor->set_index * 16 * 0x8A, utf16SetName, 0x8A);
+            vfs_read(backupDataHandle, NULL, cursor->set_index * 16 * 0x8A, utf16SetName, 0x8A);
             replace_chars(utf16SetName, ILLEGAL_CHARS, u'-');
             u16 set_path[256] = {0};
             struacat(set_path, "/3ds/" APP_TITLE "/BadgeBackups/");
@@ -322,9 +326,9 @@ SetNode * extract_sets(char *badgeMngBuffer, Handle backupDataHandle)
             {
                 struacat(set_path, "Unknown Set");
             }
-            FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_UTF16, set_path), FS_ATTRIBUTE_DIRECTORY);
+            vfs_create_dir(ArchiveSD, fsMakePath(PATH_UTF16, set_path));
             memset(icon_alpha_buf, 255, 64 * 64 * 0.5);
-            FSFILE_Read(backupDataHandle, NULL, 0x250F80 + cursor->set_index * 0x2000, icon_rgb_buf, 0x2000);
+            vfs_read(backupDataHandle, NULL, 0x250F80 + cursor->set_index * 0x2000, icon_rgb_buf, 0x2000);
             char filename[256] = {0};
             utf16_to_utf8((u8 *) filename, set_path, 256);
             strcat(filename, "/_seticon.png");
@@ -344,6 +348,8 @@ SetNode * extract_sets(char *badgeMngBuffer, Handle backupDataHandle)
 
 Result extract_badges(void)
 {
+    IOSTATS_PHASE("extract");
+    TRACE_SPAN("extract_badges");
     DEBUG("Dumping installed badges...\n");
     char *badgeMngBuffer = NULL;
     u32 size = file_to_buf(fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), ArchiveBadgeExt, &badgeMngBuffer);
@@ -359,7 +365,7 @@ Result extract_badges(void)
     DEBUG("%lu badges found\n", badge_count);
     if (badge_count > 0)
     {
-        res = FSUSER_OpenFile(&backupDataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ, 0);
+        res = vfs_open_file(&backupDataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ);
         if (R_FAILED(res))
         {
             free(badgeMngBuffer);
@@ -392,7 +398,7 @@ Result extract_badges(void)
         char filename[512] = {0};
 
         u16 utf16Name[0x46] = {0};
-        FSFILE_Read(backupDataHandle, NULL, 0x35E80 + i * 16 * 0x8A, utf16Name, 0x8A);
+        vfs_read(backupDataHandle, NULL, 0x35E80 + i * 16 * 0x8A, utf16Name, 0x8A);
         replace_chars(utf16Name, ILLEGAL_CHARS, u'-');
         char utf8Name[256] = {0};
         res = utf16_to_utf8((u8 *) utf8Name, utf16Name, 256);
@@ -406,7 +412,7 @@ Result extract_badges(void)
             } else
             {
                 u16 utf16SetName[0x46] = {0};
-                FSFILE_Read(backupDataHandle, NULL, set_index * 16 * 0x8A, utf16SetName, 0x8A);
+                vfs_read(backupDataHandle, NULL, set_index * 16 * 0x8A, utf16SetName, 0x8A);
                 replace_chars(utf16SetName, ILLEGAL_CHARS, u'-');
                 char utf8SetName[128] = {0};
                 res = utf16_to_utf8((u8 *) utf8SetName, utf16SetName, 128);
@@ -429,8 +435,8 @@ Result extract_badges(void)
         }
         DEBUG("Dump filename: %s\n", filename);
 
-        FSFILE_Read(backupDataHandle, NULL, 0x318F80 + i * 0x2800, badge_rgb_buf, 0x2000);
-        FSFILE_Read(backupDataHandle, NULL, 0x318F80 + i * 0x2800 + 0x2000, badge_alpha_buf, 0x800);
+        vfs_read(backupDataHandle, NULL, 0x318F80 + i * 0x2800, badge_rgb_buf, 0x2000);
+        vfs_read(backupDataHandle, NULL, 0x318F80 + i * 0x2800 + 0x2000, badge_alpha_buf, 0x800);
         rgb565ToPngFile(filename, badge_rgb_buf, badge_alpha_buf, 64, 64);
         draw_loading_bar(i + 1, badge_count, INSTALL_DUMPING_BADGES);
     }
@@ -439,13 +445,16 @@ Result extract_badges(void)
     free(badge_rgb_buf);
     free(badge_alpha_buf);
     free_list(head);
-    FSFILE_Close(backupDataHandle);
+    vfs_close(backupDataHandle);
 
+    iostats_report("extract_badges");
     return res;
 }
 
 Result backup_badges_fast(void)
 {
+    IOSTATS_PHASE("backup");
+    TRACE_SPAN("backup_badges");
     char *badgeMng = NULL;
 
     DEBUG("writing badge data: making files...\n");
@@ -459,61 +468,64 @@ Result backup_badges_fast(void)
     DEBUG("loading existing badge mng file...\n");
     u32 mngRead = file_to_buf(fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), ArchiveBadgeExt, &badgeMng);
     DEBUG("loading existing badge data file\n");
-    Result res = FSUSER_OpenFile(&dataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ, 0);
+    Result res = vfs_open_file(&dataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ);
     if (mngRead != BADGE_MNG_SIZE || R_FAILED(res))
     {
         char err_string[128] = {0};
         sprintf(err_string, language.badges.extdata_locked, res);
         throw_error(err_string, ERROR_LEVEL_WARNING);
         if (badgeMng) free(badgeMng);
-        if (dataHandle) FSFILE_Close(dataHandle);
-        FSFILE_Close(sdHandle);
+        if (dataHandle) vfs_close(dataHandle);
+        vfs_close(sdHandle);
         return -1;
     }
-    remake_file(fsMakePath(PATH_ASCII, mng_path), ArchiveSD, BADGE_MNG_SIZE);
-
-    FSUSER_CreateFile(ArchiveSD, fsMakePath(PATH_ASCII, data_path), 0, BADGE_DATA_SIZE);
-    FSUSER_OpenFile(&sdHandle, ArchiveSD, fsMakePath(PATH_ASCII, data_path), FS_OPEN_WRITE, 0);
+    vfs_create_file(ArchiveSD, fsMakePath(PATH_ASCII, data_path), BADGE_DATA_SIZE);
+    vfs_open_file(&sdHandle, ArchiveSD, fsMakePath(PATH_ASCII, data_path), FS_OPEN_WRITE);
 
     DEBUG("writing badge data: writing BadgeMngFile...\n");
-    res = buf_to_file(mngRead, fsMakePath(PATH_ASCII, mng_path), ArchiveSD, badgeMng);
+    res = rewrite_file(fsMakePath(PATH_ASCII, mng_path), ArchiveSD, BADGE_MNG_SIZE, badgeMng, mngRead);
     if (R_FAILED(res))
     {
         DEBUG("Failed to write badgemngfile: 0x%08lx\n", res);
         free(badgeMng);
-        FSFILE_Close(dataHandle);
-        FSFILE_Close(sdHandle);
+        vfs_close(dataHandle);
+        vfs_close(sdHandle);
         return -1;
     }
     DEBUG("writing badge data: writing badgedata...\n");
     char *buf = malloc(0x10000);
     u64 size = BADGE_DATA_SIZE;
     u64 cur = 0;
+    Write_Batch_s batch;
+    write_batch_begin(&batch, sdHandle);
     while (size > 0)
     {
         u32 read = 0;
-        res = FSFILE_Read(dataHandle, &read, cur, buf, min(0x10000, size));
-        res = FSFILE_Write(sdHandle, NULL, cur, buf, read, FS_WRITE_FLUSH);
+        res = vfs_read(dataHandle, &read, cur, buf, min(0x10000, size));
+        if (R_FAILED(res) || read == 0) break;
+        write_batch_write(&batch, cur, buf, read);
         size -= read;
         cur += read;
     }
+    write_batch_commit(&batch);
 
     free(badgeMng);
     free(buf);
-    FSFILE_Close(dataHandle);
-    FSFILE_Close(sdHandle);
+    vfs_close(dataHandle);
+    vfs_close(sdHandle);
     return 0;
 }
 
 Result install_badges(void)
 {
+    TRACE_SPAN("install_badges");
     Handle handle = 0;
     Handle folder = 0;
     Result res = 0;
     draw_loading_bar(0, 1, INSTALL_BADGES);
     {
         char testpath[128] = "/3ds/" APP_TITLE "/BadgeData.dat";
-        if (R_FAILED(res = FSUSER_OpenFile(&handle, ArchiveSD, fsMakePath(PATH_ASCII, testpath), FS_OPEN_READ, 0)))
+        if (R_FAILED(res = vfs_open_file(&handle, ArchiveSD, fsMakePath(PATH_ASCII, testpath), FS_OPEN_READ)))
         {
             if (R_SUMMARY(res) == RS_NOTFOUND)
             {
@@ -526,7 +538,7 @@ Result install_badges(void)
         }
     }
 
-    if (handle) FSFILE_Close(handle);
+    if (handle) vfs_close(handle);
 
     DEBUG("Initializing ACT\n");
     res = actInit(true);
@@ -563,7 +575,7 @@ Result install_badges(void)
 
     DEBUG("Opening badge directory\n");
     FS_DirectoryEntry *badge_files = calloc(1024, sizeof(FS_DirectoryEntry));
-    res = FSUSER_OpenDirectory(&folder, ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_BADGES]));
+    res = vfs_open_dir(&folder, ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_BADGES]));
     if (R_FAILED(res))
     {
         DEBUG("Failed to open folder: %lx\n", res);
@@ -571,13 +583,13 @@ Result install_badges(void)
     }
 
     u32 entries_read;
-    res = FSDIR_Read(folder, &entries_read, 1024, badge_files);
+    res = vfs_read_dir(folder, &entries_read, 1024, badge_files);
     DEBUG("%lu files found\n", entries_read);
     rgb_buf_64x64 = malloc(12*6*64*64*2); //12x6 badges in sheet max, 64x64 pixel badges, 2 bytes per RGB data
     alpha_buf_64x64 = malloc(12*6*64*64/2); //Same thing, but 2 pixels of alpha data per byte
     rgb_buf_32x32 = malloc(12*6*32*32*2); //Same thing, but 32x32
     alpha_buf_32x32 = malloc(12*6*32*32/2);
-    res = FSUSER_OpenFile(&badgeDataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_WRITE, 0);
+    res = vfs_open_file(&badgeDataHandle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_WRITE);
     badgeMngBuffer = calloc(1, BADGE_MNG_SIZE);
 
     if (!rgb_buf_64x64)
@@ -621,6 +633,8 @@ Result install_badges(void)
     }
 
     zero_handle_memeasy(badgeDataHandle);
+    // thousands of small scattered writes follow, gather them up and flush once
+    write_batch_begin(&badgeDataBatch, badgeDataHandle);
 
     int badge_count = 0;
     int set_count = 0;
@@ -633,6 +647,8 @@ Result install_badges(void)
     draw_loading_bar(progress_status, progress_finish, INSTALL_BADGES);
     for (u32 i = 0; i < entries_read && badge_count < 1000; ++i)
     {
+        IOSTATS_PHASE("install_sets");
+        TRACE_SPAN("install_sets");
         if (!strcmp(badge_files[i].shortExt, "PNG"))
         {
             if (default_set == 0)
@@ -671,13 +687,15 @@ Result install_badges(void)
     DEBUG("Badges installed - doing metadata\n");
     if (default_set != 0)
     {
+        IOSTATS_PHASE("default_set");
+        TRACE_SPAN("default_set");
         int default_index = default_set - 1;
         u32 total_count = 0xFFFF * default_set_count;
         for (int i = 0; i < 16; ++i)
         {
             u16 name[0x8A/2] = {0};
             utf8_to_utf16(name, (u8 *) "Other Badges", 0x8A);
-            FSFILE_Write(badgeDataHandle, NULL, default_index * 0x8A0 + i * 0x8A, &name, strulen(name, 0x45) * 2, 0);
+            write_batch_write(&badgeDataBatch, default_index * 0x8A0 + i * 0x8A, &name, strulen(name, 0x45) * 2);
         }
         badgeMngBuffer[0x3D8 + default_index/8] |= 1 << (default_index % 8);
 
@@ -700,10 +718,15 @@ Result install_badges(void)
         fclose(fp);
         pngToRGB565(icon_buf, size, rgb_buf_64x64, alpha_buf_64x64, rgb_buf_32x32, alpha_buf_32x32, true);
         free(icon_buf);
-        FSFILE_Write(badgeDataHandle, NULL, 0x250F80 + default_index * 0x2000, rgb_buf_64x64, 64 * 64 * 2, 0);
+        write_batch_write(&badgeDataBatch, 0x250F80 + default_index * 0x2000, rgb_buf_64x64, 64 * 64 * 2);
     }
 
-    FSFILE_Flush(badgeDataHandle);
+    res = write_batch_commit(&badgeDataBatch);
+    if (R_FAILED(res))
+    {
+        DEBUG("Error writing badge data! %lx\n", res);
+        goto end;
+    }
 
     u32 total_badges = 0xFFFF * badge_count; // Quantity * unique badges?
 
@@ -729,11 +752,11 @@ Result install_badges(void)
         memset(badgeMngBuffer + 0xA028 + 0x30 * i + 0x28, 0x00, 0x8);
     }
 
-    res = FSUSER_OpenFile(&handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), FS_OPEN_READ, 0);
+    res = vfs_open_file(&handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), FS_OPEN_READ);
     if (res == 0)
     {
-        FSFILE_Read(handle, NULL, 0xB2E8, badgeMngBuffer+0xB2E8, 360 * 0x18);
-        FSFILE_Close(handle);
+        vfs_read(handle, NULL, 0xB2E8, badgeMngBuffer+0xB2E8, 360 * 0x18);
+        vfs_close(handle);
     }
 
     res = buf_to_file(BADGE_MNG_SIZE, fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), ArchiveBadgeExt, badgeMngBuffer);
@@ -753,10 +776,12 @@ Result install_badges(void)
     if (alpha_buf_64x64) free(alpha_buf_64x64);
     if (rgb_buf_32x32) free(rgb_buf_32x32);
     if (alpha_buf_32x32) free(alpha_buf_32x32);
-    if (handle) FSFILE_Close(handle);
-    if (folder) FSDIR_Close(folder);
-    if (badgeDataHandle) FSFILE_Close(badgeDataHandle);
+    if (handle) vfs_close(handle);
+    if (folder) vfs_close_dir(folder);
+    write_batch_abort(&badgeDataBatch);
+    if (badgeDataHandle) vfs_close(badgeDataHandle);
     if (badgeMngBuffer) free(badgeMngBuffer);
     if (badge_files) free(badge_files);
+    iostats_report("install_badges");
     return res;
 }
\ No newline at end of file
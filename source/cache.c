@@ -0,0 +1,49 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "cache.h"
+
+u32 hash_file_name(const u16 * name, size_t len)
+{
+    u32 hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < len; ++i)
+    {
+        hash ^= name[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+void cache_file_path(char * out, const char * kind, const char * loading_path)
+{
+    u32 hash = FNV_OFFSET_BASIS;
+    for(const char * c = loading_path; *c; ++c)
+    {
+        hash ^= (u8)*c;
+        hash *= FNV_PRIME;
+    }
+    snprintf(out, CACHE_PATH_SIZE, "/3ds/"  APP_TITLE  "/cache/%s_%08lx.bin", kind, hash);
+}
@@ -0,0 +1,212 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "collation.h"
+
+// below this, buckets are finished with an insertion sort
+#define COLLATION_INSERTION_THRESHOLD 16
+#define COLLATION_BUCKETS 257 // the key ended, then every byte value
+
+static u32 fold(u32 c)
+{
+    // fullwidth forms and the ideographic space, as typed with the Japanese keyboard
+    if(c >= 0xFF01 && c <= 0xFF5E)
+        c -= 0xFEE0;
+    else if(c == 0x3000)
+        c = ' ';
+
+    if(c >= 'A' && c <= 'Z')
+        return c + 0x20;
+    // Latin-1, except the multiplication sign
+    if(c >= 0xC0 && c <= 0xDE && c != 0xD7)
+        return c + 0x20;
+    // Latin Extended-A alternates upper and lower case, the parity of the pairs flips twice
+    if((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177))
+        return c | 1;
+    if((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E))
+        return (c & 1) ? c + 1 : c;
+    // the one capital whose small letter is in Latin-1
+    if(c == 0x178)
+        return 0xFF;
+    // Greek
+    if(c >= 0x391 && c <= 0x3AB && c != 0x3A2)
+        return c + 0x20;
+    // Cyrillic
+    if(c >= 0x400 && c <= 0x40F)
+        return c + 0x50;
+    if(c >= 0x410 && c <= 0x42F)
+        return c + 0x20;
+
+    return c;
+}
+
+static u32 put_utf8(u8 * out, u32 c)
+{
+    if(c < 0x80)
+    {
+        if(out != NULL)
+            out[0] = c;
+        return 1;
+    }
+    if(c < 0x800)
+    {
+        if(out != NULL)
+        {
+            out[0] = 0xC0 | (c >> 6);
+            out[1] = 0x80 | (c & 0x3F);
+        }
+        return 2;
+    }
+    if(c < 0x10000)
+    {
+        if(out != NULL)
+        {
+            out[0] = 0xE0 | (c >> 12);
+            out[1] = 0x80 | ((c >> 6) & 0x3F);
+            out[2] = 0x80 | (c & 0x3F);
+        }
+        return 3;
+    }
+
+    if(out != NULL)
+    {
+        out[0] = 0xF0 | (c >> 18);
+        out[1] = 0x80 | ((c >> 12) & 0x3F);
+        out[2] = 0x80 | ((c >> 6) & 0x3F);
+        out[3] = 0x80 | (c & 0x3F);
+    }
+    return 4;
+}
+
+u32 collation_key(u8 * out, const u16 * text, size_t max_len)
+{
+    u32 len = 0;
+    for(size_t i = 0; i < max_len && text[i] != 0; ++i)
+    {
+        u32 c = text[i];
+        if(c >= 0xD800 && c <= 0xDBFF && i + 1 < max_len && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF)
+        {
+            c = 0x10000 + ((c - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+            ++i;
+        }
+
+        len += put_utf8(out != NULL ? out + len : NULL, fold(c));
+    }
+
+    return len;
+}
+
+typedef struct {
+    u32 start;
+    u32 end;
+    u32 depth;
+} Collation_Range_s;
+
+static int compare_keys_from(const u8 * keys, const u32 * offsets, u32 a, u32 b, u32 depth)
+{
+    const u32 len_a = offsets[a + 1] - offsets[a] - depth;
+    const u32 len_b = offsets[b + 1] - offsets[b] - depth;
+    const int cmp = memcmp(keys + offsets[a] + depth, keys + offsets[b] + depth, min(len_a, len_b));
+    if(cmp != 0)
+        return cmp;
+    return (len_a > len_b) - (len_a < len_b);
+}
+
+static void insertion_sort(u32 * order, const Collation_Range_s * range, const u8 * keys, const u32 * offsets)
+{
+    for(u32 i = range->start + 1; i < range->end; ++i)
+    {
+        const u32 current = order[i];
+        u32 j = i;
+        while(j > range->start && compare_keys_from(keys, offsets, order[j - 1], current, range->depth) > 0)
+        {
+            order[j] = order[j - 1];
+            --j;
+        }
+        order[j] = current;
+    }
+}
+
+static inline u32 bucket_of(const u8 * keys, const u32 * offsets, u32 index, u32 depth)
+{
+    return offsets[index] + depth < offsets[index + 1] ? keys[offsets[index] + depth] + 1 : 0;
+}
+
+bool collation_sort(u32 * order, u32 count, const u8 * keys, const u32 * offsets)
+{
+    if(count < 2)
+        return true;
+
+    // every pending range holds at least 2 entries and none of them overlap
+    Collation_Range_s * ranges = malloc((count / 2 + 1) * sizeof(Collation_Range_s));
+    u32 * scratch = malloc(count * sizeof(u32));
+    u32 * bucket_starts = malloc((COLLATION_BUCKETS + 1) * sizeof(u32));
+    if(ranges == NULL || scratch == NULL || bucket_starts == NULL)
+    {
+        free(bucket_starts);
+        free(scratch);
+        free(ranges);
+        return false;
+    }
+
+    u32 pending = 0;
+    ranges[pending++] = (Collation_Range_s){0, count, 0};
+    while(pending != 0)
+    {
+        const Collation_Range_s range = ranges[--pending];
+        if(range.end - range.start < COLLATION_INSERTION_THRESHOLD)
+        {
+            insertion_sort(order, &range, keys, offsets);
+            continue;
+        }
+
+        memset(bucket_starts, 0, (COLLATION_BUCKETS + 1) * sizeof(u32));
+        for(u32 i = range.start; i < range.end; ++i)
+            bucket_starts[bucket_of(keys, offsets, order[i], range.depth) + 1]++;
+        for(u32 b = 0; b < COLLATION_BUCKETS; ++b)
+            bucket_starts[b + 1] += bucket_starts[b];
+
+        // bucket_starts[b] is moved on to the start of the next bucket as b is filled
+        for(u32 i = range.start; i < range.end; ++i)
+            scratch[range.start + bucket_starts[bucket_of(keys, offsets, order[i], range.depth)]++] = order[i];
+        memcpy(order + range.start, scratch + range.start, (range.end - range.start) * sizeof(u32));
+
+        // keys that ended here are all equal and stay in the order they came in
+        u32 bucket_start = range.start + bucket_starts[0];
+        for(u32 b = 1; b < COLLATION_BUCKETS; ++b)
+        {
+            const u32 bucket_end = range.start + bucket_starts[b];
+            if(bucket_end - bucket_start > 1)
+                ranges[pending++] = (Collation_Range_s){bucket_start, bucket_end, range.depth + 1};
+            bucket_start = bucket_end;
+        }
+    }
+
+    free(bucket_starts);
+    free(scratch);
+    free(ranges);
+    return true;
+}
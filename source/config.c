@@ -25,11 +25,13 @@
 */
 
 #include "config.h"
+#include "trace.h"
 
 Config_s config;
 
 void load_config(void)
 {
+    TRACE_SPAN("load_config");
     Handle test_handle;
     Result res;
     memset(&config, 0, sizeof(Config_s));
@@ -168,10 +170,10 @@ void load_config(void)
                     char *theme_path = calloc(1, strlen(json_string_value(value)) + 1 + (need_slash ? 1 : 0));
                     memcpy(theme_path, json_string_value(value), strlen(json_string_value(value)));
                     if (need_slash) theme_path[strlen(json_string_value(value))] = '/';
-                    if (R_SUCCEEDED(res = FSUSER_OpenDirectory(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, theme_path))))
+                    if (R_SUCCEEDED(res = vfs_open_dir(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, theme_path))))
                     {
                         main_paths[REMOTE_MODE_THEMES] = theme_path;
-                        FSDIR_Close(test_handle);
+                        vfs_close_dir(test_handle);
                     } else
                     {
                         DEBUG("Failed test - reverting to default. Err 0x%08lx\n", res);
@@ -184,10 +186,10 @@ void load_config(void)
                     char *splash_path = calloc(1, strlen(json_string_value(value)) + 1 + (need_slash ? 1 : 0));
                     memcpy(splash_path, json_string_value(value), strlen(json_string_value(value)));
                     if (need_slash) splash_path[strlen(json_string_value(value))] = '/';
-                    if (R_SUCCEEDED(res = FSUSER_OpenDirectory(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, splash_path))))
+                    if (R_SUCCEEDED(res = vfs_open_dir(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, splash_path))))
                     {
                         main_paths[REMOTE_MODE_SPLASHES] = splash_path;
-                        FSDIR_Close(test_handle);
+                        vfs_close_dir(test_handle);
                     } else
                     {
                         DEBUG("Failed test - reverting to default. Err 0x%08lx\n", res);
@@ -200,10 +202,10 @@ void load_config(void)
                     char *badge_path = calloc(1, strlen(json_string_value(value)) + 1 + (need_slash ? 1 : 0));
                     memcpy(badge_path, json_string_value(value), strlen(json_string_value(value)));
                     if (need_slash) badge_path[strlen(json_string_value(value))] = '/';
-                    if (R_SUCCEEDED(res = FSUSER_OpenDirectory(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, badge_path))))
+                    if (R_SUCCEEDED(res = vfs_open_dir(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, badge_path))))
                     {
                         main_paths[REMOTE_MODE_BADGES] = badge_path;
-                        FSDIR_Close(test_handle);
+                        vfs_close_dir(test_handle);
                     } else
                     {
                         DEBUG("Failed test - reverting to default. Err 0x%08lx\n", res);
@@ -1,6 +1,7 @@
 #include "conversion.h"
-#include "draw.h"
+#include "ui_feedback.h"
 
+#include <math.h>
 #include <png.h>
 
 // don't be fooled - this function always expects 64x64 input buffers. Width/height only
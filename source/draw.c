@@ -28,6 +28,7 @@
 #include "unicode.h"
 #include "colors.h"
 #include "ui_strings.h"
+#include "trace.h"
 
 #include "sprites.h"
 
@@ -55,6 +56,7 @@ static const char *remote_mode_switch_char[REMOTE_MODE_AMOUNT] = {
 
 void init_screens(void)
 {
+    TRACE_SPAN("init_screens");
     init_colors();
     gfxInitDefault();
     C3D_Init(C3D_DEFAULT_CMDBUF_SIZE);
@@ -529,7 +531,7 @@ void draw_text_wrap_scaled(float x, float y, float z, Color color, const char *
     }
 }
 
-static void draw_entry_info(Entry_s * entry)
+static void draw_entry_info(Entry_s * entry, const u16 * desc)
 {
     char author[0x41] = {0};
     utf16_to_utf8((u8 *)author, entry->author, 0x40);
@@ -543,7 +545,7 @@ static void draw_entry_info(Entry_s * entry)
     draw_text(20, 50, 0.5, 0.7, 0.7, colors[COLOR_WHITE_BACKGROUND], title);
 
     char description[0x81] = {0};
-    utf16_to_utf8((u8 *)description, entry->desc, 0x80);
+    utf16_to_utf8((u8 *)description, desc, 0x80);
     draw_text_wrap(20, 70, 0.5, 0.5, 0.5, colors[COLOR_WHITE_BACKGROUND], description, 363);
 }
 
@@ -563,8 +565,8 @@ void draw_grid_interface(Entry_List_s * list, Instructions_s instructions, int e
     draw_instructions(instructions);
 
     int selected_entry = list->selected_entry;
-    Entry_s * current_entry = &list->entries[selected_entry];
-    draw_entry_info(current_entry);
+    Entry_s * current_entry = list->entries[selected_entry];
+    draw_entry_info(current_entry, list_entry_desc(list, current_entry));
 
     set_screen(bottom);
 
@@ -589,7 +591,7 @@ void draw_grid_interface(Entry_List_s * list, Instructions_s instructions, int e
     {
         if(i >= list->entries_count) break;
 
-        current_entry = &list->entries[i];
+        current_entry = list->entries[i];
 
         char name[0x41] = {0};
         utf16_to_utf8((u8 *)name, current_entry->name, 0x40);
@@ -701,8 +703,8 @@ void draw_interface(Entry_List_s * list, Instructions_s instructions, DrawMode d
     draw_instructions(instructions);
 
     int selected_entry = list->selected_entry;
-    Entry_s * current_entry = &list->entries[selected_entry];
-    draw_entry_info(current_entry);
+    Entry_s * current_entry = list->entries[selected_entry];
+    draw_entry_info(current_entry, list_entry_desc(list, current_entry));
 
     set_screen(bottom);
 
@@ -757,7 +759,7 @@ void draw_interface(Entry_List_s * list, Instructions_s instructions, DrawMode d
     {
         if(i >= list->entries_count) break;
 
-        current_entry = &list->entries[i];
+        current_entry = list->entries[i];
 
         char name[0x41] = {0};
         utf16_to_utf8((u8 *)name, current_entry->name, 0x40);
@@ -800,15 +802,13 @@ void draw_interface(Entry_List_s * list, Instructions_s instructions, DrawMode d
 
         if(current_entry->placeholder_color == 0)
         {
-            C2D_Image image;
-            if(list->entries_count > list->entries_loaded * ICONS_OFFSET_AMOUNT)
+            // nothing until the icon thread has loaded it, the slot can be taken back meanwhile
+            const int icon_slot = current_entry->icon_slot;
+            if(icon_slot != 0 && list->icons_info[icon_slot - 1].ready)
             {
-                const int offset_to_visible_icons = ICONS_VISIBLE * list->entries_loaded;
-                image = get_icon_at(list, offset_to_visible_icons + (i - list->scroll));
+                const C2D_Image image = get_icon_at(list, icon_slot - 1);
+                C2D_DrawImageAt(image, horizontal_offset, vertical_offset, 0.5f, NULL, 1.0f, 1.0f);
             }
-            else
-                image = get_icon_at(list, i);
-            C2D_DrawImageAt(image, horizontal_offset, vertical_offset, 0.5f, NULL, 1.0f, 1.0f);
         }
         else
         {
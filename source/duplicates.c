@@ -0,0 +1,510 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "duplicates.h"
+#include "fs.h"
+#include "cache.h"
+#include "vfs.h"
+#include "unicode.h"
+
+#include <zlib.h>
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 records_count;
+    u32 reserved;
+} Duplicates_Cache_Header_s;
+
+// followed by the file name, without terminator
+typedef struct {
+    u64 mtimes[FINGERPRINT_FILES];
+    Fingerprint_s fingerprint;
+    u16 file_name_len;
+    u16 reserved;
+} Duplicates_Cache_Record_s;
+
+typedef struct {
+    char * data;
+    u32 data_size;
+    u32 records_count;
+    u32 * table; // open addressing on the file name, offset of the record + 1
+    u32 table_size;
+} Duplicates_Cache_s;
+
+#define DUPLICATES_STACK_SIZE 0x4000
+#define DUPLICATES_CHUNK_SIZE 0x8000
+
+static const char * const theme_files[FINGERPRINT_FILES] = {
+    "/body_LZ.bin",
+    "/bgm.bcstm",
+};
+
+static const char * const splash_files[FINGERPRINT_FILES] = {
+    "/splash.bin",
+    "/splashbottom.bin",
+};
+
+static u32 record_size(const Duplicates_Cache_Record_s * record)
+{
+    return (sizeof(Duplicates_Cache_Record_s) + record->file_name_len * sizeof(u16) + 3) & ~3;
+}
+
+static void cache_free(Duplicates_Cache_s * cache)
+{
+    free(cache->data);
+    free(cache->table);
+    memset(cache, 0, sizeof(Duplicates_Cache_s));
+}
+
+static void cache_load(Duplicates_Cache_s * cache, const char * loading_path)
+{
+    memset(cache, 0, sizeof(Duplicates_Cache_s));
+
+    char cache_path[CACHE_PATH_SIZE];
+    cache_file_path(cache_path, "fingerprints", loading_path);
+    cache->data_size = file_to_buf(fsMakePath(PATH_ASCII, cache_path), ArchiveSD, &cache->data);
+    if(cache->data_size < sizeof(Duplicates_Cache_Header_s))
+        goto invalid;
+
+    Duplicates_Cache_Header_s header;
+    memcpy(&header, cache->data, sizeof(header));
+    if(header.magic != DUPLICATES_CACHE_MAGIC || header.version != DUPLICATES_CACHE_VERSION || header.records_count == 0)
+        goto invalid;
+    if(header.records_count > (cache->data_size - sizeof(header)) / sizeof(Duplicates_Cache_Record_s))
+        goto invalid;
+
+    cache->table_size = 1;
+    while(cache->table_size < header.records_count * 2)
+        cache->table_size <<= 1;
+    cache->table = calloc(cache->table_size, sizeof(u32));
+    if(cache->table == NULL)
+        goto invalid;
+
+    u32 offset = sizeof(Duplicates_Cache_Header_s);
+    for(u32 i = 0; i < header.records_count; ++i)
+    {
+        Duplicates_Cache_Record_s record;
+        if(offset + sizeof(record) > cache->data_size)
+            goto invalid;
+        memcpy(&record, cache->data + offset, sizeof(record));
+        if(record.file_name_len == 0 || record.file_name_len >= 0x106 || offset + record_size(&record) > cache->data_size)
+            goto invalid;
+
+        const u16 * file_name = (const u16 *)(cache->data + offset + sizeof(record));
+        u32 slot = hash_file_name(file_name, record.file_name_len) & (cache->table_size - 1);
+        while(cache->table[slot] != 0)
+            slot = (slot + 1) & (cache->table_size - 1);
+        cache->table[slot] = offset + 1;
+
+        offset += record_size(&record);
+    }
+
+    cache->records_count = header.records_count;
+    return;
+
+    invalid:
+    if(cache->data_size != 0)
+        DEBUG("Discarding fingerprints %s\n", cache_path);
+    cache_free(cache);
+}
+
+// Returns the offset of the record for file_name + 1, or 0
+static u32 cache_find(const Duplicates_Cache_s * cache, const u16 * file_name, u16 file_name_len, Duplicates_Cache_Record_s * record)
+{
+    if(cache->records_count == 0)
+        return 0;
+
+    u32 slot = hash_file_name(file_name, file_name_len) & (cache->table_size - 1);
+    for(; cache->table[slot] != 0; slot = (slot + 1) & (cache->table_size - 1))
+    {
+        const char * record_data = cache->data + cache->table[slot] - 1;
+        memcpy(record, record_data, sizeof(Duplicates_Cache_Record_s));
+        if(record->file_name_len == file_name_len && !memcmp(record_data + sizeof(Duplicates_Cache_Record_s), file_name, file_name_len * sizeof(u16)))
+            return cache->table[slot];
+    }
+
+    return 0;
+}
+
+// Writes the fingerprinted items, and the records of those not gotten to yet
+static void cache_save(const Duplicates_Job_s * job, const Duplicates_Cache_s * cache, int processed)
+{
+    u32 size = sizeof(Duplicates_Cache_Header_s);
+    u32 records_count = 0;
+    for(int i = 0; i < job->items_count; ++i)
+    {
+        const Duplicates_Item_s * item = &job->items[i];
+        Duplicates_Cache_Record_s record;
+        if(item->hashed || (i >= processed && cache_find(cache, job->names + item->name_offset, item->name_len, &record)))
+        {
+            record.file_name_len = item->name_len;
+            size += record_size(&record);
+            records_count++;
+        }
+    }
+
+    char * buf = calloc(1, size);
+    if(buf == NULL)
+    {
+        DEBUG("Not enough memory to save the fingerprints\n");
+        return;
+    }
+
+    const Duplicates_Cache_Header_s header = {
+        .magic = DUPLICATES_CACHE_MAGIC,
+        .version = DUPLICATES_CACHE_VERSION,
+        .records_count = records_count,
+    };
+    memcpy(buf, &header, sizeof(header));
+
+    u32 offset = sizeof(header);
+    for(int i = 0; i < job->items_count; ++i)
+    {
+        const Duplicates_Item_s * item = &job->items[i];
+        const u16 * file_name = job->names + item->name_offset;
+        Duplicates_Cache_Record_s record = {0};
+        if(item->hashed)
+        {
+            memcpy(record.mtimes, item->mtimes, sizeof(record.mtimes));
+            record.fingerprint = item->fingerprint;
+            record.file_name_len = item->name_len;
+        }
+        else if(i < processed || !cache_find(cache, file_name, item->name_len, &record))
+        {
+            continue;
+        }
+
+        memcpy(buf + offset, &record, sizeof(record));
+        memcpy(buf + offset + sizeof(record), file_name, record.file_name_len * sizeof(u16));
+        offset += record_size(&record);
+    }
+
+    char cache_path[CACHE_PATH_SIZE];
+    cache_file_path(cache_path, "fingerprints", job->loading_path);
+    Result res = rewrite_file(fsMakePath(PATH_ASCII, cache_path), ArchiveSD, size, buf, size);
+    if(R_FAILED(res))
+        DEBUG("Failed to save fingerprints %s: 0x%08lx\n", cache_path, res);
+
+    free(buf);
+}
+
+// An entry to hand to entry_path, only its path is filled
+static void item_entry(const Duplicates_Job_s * job, const Duplicates_Item_s * item, Entry_s * entry)
+{
+    memset(entry, 0, sizeof(Entry_s));
+    entry->prefix = &job->prefix;
+    entry->file_name = job->names + item->name_offset;
+    entry->file_name_len = item->name_len;
+    entry->is_zip = item->is_zip;
+}
+
+// missing files get 0, so adding one later changes the stamps too
+static void get_item_mtimes(const Duplicates_Job_s * job, const Entry_s * entry, u64 * mtimes)
+{
+    u16 path[ENTRY_PATH_SIZE];
+    memset(mtimes, 0, FINGERPRINT_FILES * sizeof(u64));
+    if(entry->is_zip)
+    {
+        if(R_FAILED(vfs_get_mtime(ArchiveSD, entry_path(entry, NULL, path), &mtimes[0])))
+            mtimes[0] = 0;
+        return;
+    }
+
+    for(int i = 0; i < FINGERPRINT_FILES; ++i)
+    {
+        if(R_FAILED(vfs_get_mtime(ArchiveSD, entry_path(entry, job->files[i], path), &mtimes[i])))
+            mtimes[i] = 0;
+    }
+}
+
+static void fingerprint_zip(const Duplicates_Job_s * job, const Entry_s * entry, Fingerprint_s * fingerprint)
+{
+    u16 path[ENTRY_PATH_SIZE];
+    Zip_s zip;
+    if(R_FAILED(zip_open(&zip, ArchiveSD, entry_path(entry, NULL, path))))
+        return;
+
+    for(int i = 0; i < FINGERPRINT_FILES; ++i)
+    {
+        // the member names don't have the leading '/'
+        const Zip_Entry_s * member = zip_find(&zip, job->files[i] + 1);
+        if(member == NULL)
+            continue;
+        fingerprint->sizes[i] = member->size;
+        fingerprint->crcs[i] = member->crc;
+    }
+
+    zip_close(&zip);
+}
+
+// Returns false if the job was stopped before every file was read
+static bool fingerprint_folder(const Duplicates_Job_s * job, const Entry_s * entry, Fingerprint_s * fingerprint, u8 * chunk)
+{
+    u16 path[ENTRY_PATH_SIZE];
+    for(int i = 0; i < FINGERPRINT_FILES; ++i)
+    {
+        Handle handle;
+        if(R_FAILED(vfs_open_file(&handle, ArchiveSD, entry_path(entry, job->files[i], path), FS_OPEN_READ)))
+            continue;
+
+        u64 size = 0;
+        vfs_get_size(handle, &size);
+        uLong crc = crc32(0, Z_NULL, 0);
+        u64 offset = 0;
+        while(offset < size && job->run_thread)
+        {
+            u32 read = 0;
+            if(R_FAILED(vfs_read(handle, &read, offset, chunk, DUPLICATES_CHUNK_SIZE)) || read == 0)
+                break;
+            crc = crc32(crc, chunk, read);
+            offset += read;
+        }
+        vfs_close(handle);
+
+        if(!job->run_thread)
+            return false;
+        fingerprint->sizes[i] = offset;
+        fingerprint->crcs[i] = crc;
+    }
+
+    return true;
+}
+
+static void duplicates_thread(void * arg)
+{
+    Duplicates_Job_s * job = (Duplicates_Job_s *)arg;
+
+    Duplicates_Cache_s cache;
+    cache_load(&cache, job->loading_path);
+    u8 * chunk = malloc(DUPLICATES_CHUNK_SIZE);
+
+    bool changed = cache.records_count != (u32)job->items_count;
+    int processed = 0;
+    for(; processed < job->items_count && job->run_thread && chunk != NULL; ++processed)
+    {
+        Duplicates_Item_s * item = &job->items[processed];
+        Entry_s entry;
+        item_entry(job, item, &entry);
+        get_item_mtimes(job, &entry, item->mtimes);
+
+        Duplicates_Cache_Record_s record;
+        if(cache_find(&cache, entry.file_name, entry.file_name_len, &record) && !memcmp(record.mtimes, item->mtimes, sizeof(item->mtimes)))
+        {
+            item->fingerprint = record.fingerprint;
+            item->hashed = true;
+            continue;
+        }
+
+        changed = true;
+        memset(&item->fingerprint, 0, sizeof(Fingerprint_s));
+        if(item->is_zip)
+            fingerprint_zip(job, &entry, &item->fingerprint);
+        else if(!fingerprint_folder(job, &entry, &item->fingerprint, chunk))
+            break;
+        item->hashed = true;
+    }
+
+    if(changed)
+        cache_save(job, &cache, processed);
+    DEBUG("fingerprinted %i/%i entries of %s\n", processed, job->items_count, job->loading_path);
+
+    free(chunk);
+    cache_free(&cache);
+    job->done = processed == job->items_count;
+}
+
+bool duplicates_start(Duplicates_Job_s * job, const Entry_List_s * list)
+{
+    memset(job, 0, sizeof(Duplicates_Job_s));
+    const int count = list->entries_count + list->hidden_count;
+    if(list->entries == NULL || count < 2 || list->prefix == NULL)
+        return false;
+
+    if(list->mode == MODE_THEMES)
+        job->files = theme_files;
+    else if(list->mode == MODE_SPLASHES)
+        job->files = splash_files;
+    else
+        return false;
+
+    u32 names_size = 0;
+    for(int i = 0; i < count; ++i)
+        names_size += list->entries[i]->file_name_len;
+
+    job->table_size = 1;
+    while(job->table_size < (u32)count * 2)
+        job->table_size <<= 1;
+
+    job->items = calloc(count, sizeof(Duplicates_Item_s));
+    job->names = malloc(names_size * sizeof(u16));
+    job->table = calloc(job->table_size, sizeof(u32));
+    if(job->items == NULL || job->names == NULL || job->table == NULL)
+        goto fail;
+
+    u32 name_offset = 0;
+    for(int i = 0; i < count; ++i)
+    {
+        const Entry_s * entry = list->entries[i];
+        Duplicates_Item_s * item = &job->items[i];
+        item->name_offset = name_offset;
+        item->name_len = entry->file_name_len;
+        item->is_zip = entry->is_zip;
+        memcpy(job->names + name_offset, entry->file_name, entry->file_name_len * sizeof(u16));
+        name_offset += entry->file_name_len;
+
+        u32 slot = hash_file_name(entry->file_name, entry->file_name_len) & (job->table_size - 1);
+        while(job->table[slot] != 0)
+            slot = (slot + 1) & (job->table_size - 1);
+        job->table[slot] = i + 1;
+    }
+
+    job->items_count = count;
+    job->prefix = *list->prefix;
+    job->loading_path = list->loading_path;
+    job->run_thread = true;
+
+    // lowest priority, it only gets the time the UI leaves
+    job->thread = threadCreate(duplicates_thread, job, DUPLICATES_STACK_SIZE, 0x3f, -2, false);
+    if(job->thread == NULL)
+        goto fail;
+    return true;
+
+    fail:
+    DEBUG("Couldn't start looking for duplicates\n");
+    free(job->items);
+    free(job->names);
+    free(job->table);
+    memset(job, 0, sizeof(Duplicates_Job_s));
+    return false;
+}
+
+void duplicates_stop(Duplicates_Job_s * job)
+{
+    if(job->thread != NULL)
+    {
+        job->run_thread = false;
+        threadJoin(job->thread, U64_MAX);
+        threadFree(job->thread);
+    }
+
+    free(job->items);
+    free(job->names);
+    free(job->table);
+    memset(job, 0, sizeof(Duplicates_Job_s));
+}
+
+static const Duplicates_Item_s * find_item(const Duplicates_Job_s * job, const Entry_s * entry)
+{
+    u32 slot = hash_file_name(entry->file_name, entry->file_name_len) & (job->table_size - 1);
+    for(; job->table[slot] != 0; slot = (slot + 1) & (job->table_size - 1))
+    {
+        const Duplicates_Item_s * item = &job->items[job->table[slot] - 1];
+        if(item->name_len == entry->file_name_len && !memcmp(job->names + item->name_offset, entry->file_name, entry->file_name_len * sizeof(u16)))
+            return item;
+    }
+
+    return NULL;
+}
+
+static u32 hash_fingerprint(const Fingerprint_s * fingerprint)
+{
+    u32 hash = FNV_OFFSET_BASIS;
+    for(int i = 0; i < FINGERPRINT_FILES; ++i)
+    {
+        hash = (hash ^ fingerprint->crcs[i]) * FNV_PRIME;
+        hash = (hash ^ fingerprint->sizes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+int duplicates_group(const Duplicates_Job_s * job, const Entry_List_s * list, u32 ** groups)
+{
+    *groups = NULL;
+    const u32 count = list->entries_count + list->hidden_count;
+    if(!job->done || count == 0)
+        return 0;
+
+    u32 table_size = 1;
+    while(table_size < count * 2)
+        table_size <<= 1;
+
+    // by entry id, the item each entry had when the job started
+    const Duplicates_Item_s ** items = calloc(count, sizeof(Duplicates_Item_s *));
+    // open addressing on the fingerprint, entry id + 1 of the first entry that had it
+    u32 * table = calloc(table_size, sizeof(u32));
+    u32 * table_groups = calloc(table_size, sizeof(u32));
+    *groups = calloc(count, sizeof(u32));
+    int groups_count = 0;
+    if(items == NULL || table == NULL || table_groups == NULL || *groups == NULL)
+    {
+        free(*groups);
+        *groups = NULL;
+        groups_count = -1;
+        goto end;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        const Entry_s * entry = list->entries[i];
+        const Duplicates_Item_s * item = find_item(job, entry);
+        // entries without any of the files don't have anything to be a duplicate of
+        if(item == NULL || !item->hashed)
+            continue;
+        bool empty = true;
+        for(int j = 0; j < FINGERPRINT_FILES; ++j)
+            empty = empty && item->fingerprint.sizes[j] == 0;
+        if(empty)
+            continue;
+        items[entry->id] = item;
+
+        u32 slot = hash_fingerprint(&item->fingerprint) & (table_size - 1);
+        for(; table[slot] != 0; slot = (slot + 1) & (table_size - 1))
+        {
+            if(!memcmp(&items[table[slot] - 1]->fingerprint, &item->fingerprint, sizeof(Fingerprint_s)))
+                break;
+        }
+
+        if(table[slot] == 0)
+        {
+            table[slot] = entry->id + 1;
+            continue;
+        }
+
+        if(table_groups[slot] == 0)
+        {
+            table_groups[slot] = ++groups_count;
+            (*groups)[table[slot] - 1] = table_groups[slot];
+        }
+        (*groups)[entry->id] = table_groups[slot];
+    }
+
+    end:
+    free(table_groups);
+    free(table);
+    free(items);
+    return groups_count;
+}
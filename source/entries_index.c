@@ -0,0 +1,299 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "entries_index.h"
+#include "fs.h"
+#include "cache.h"
+#include "vfs.h"
+#include "unicode.h"
+#include "trace.h"
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 records_count;
+    u32 pack_id;
+} Entries_Index_Header_s;
+
+// followed by the file name, name, description and author, without terminators
+typedef struct {
+    u64 size;
+    u64 mtime;
+    u32 placeholder_color;
+    u32 pack_icon;
+    u16 file_name_len;
+    u16 name_len;
+    u16 desc_len;
+    u16 author_len;
+} Entries_Index_Record_s;
+
+static u32 record_size(const Entries_Index_Record_s * record)
+{
+    const u32 strings_len = record->file_name_len + record->name_len + record->desc_len + record->author_len;
+    // keeps the next record 4 byte aligned
+    return (sizeof(Entries_Index_Record_s) + strings_len * sizeof(u16) + 3) & ~3;
+}
+
+static bool record_valid(const Entries_Index_Record_s * record)
+{
+    return record->file_name_len != 0 && record->file_name_len < 0x106
+        && record->name_len < 0x41 && record->desc_len < 0x81 && record->author_len < 0x41;
+}
+
+void entries_index_load(Entries_Index_s * index, const char * loading_path)
+{
+    TRACE_SPAN("entries_index_load");
+    memset(index, 0, sizeof(Entries_Index_s));
+
+    char index_path[CACHE_PATH_SIZE];
+    cache_file_path(index_path, "index", loading_path);
+    index->data_size = file_to_buf(fsMakePath(PATH_ASCII, index_path), ArchiveSD, &index->data);
+    if(index->data_size < sizeof(Entries_Index_Header_s))
+        goto invalid;
+
+    Entries_Index_Header_s header;
+    memcpy(&header, index->data, sizeof(header));
+    if(header.magic != ENTRIES_INDEX_MAGIC || header.version != ENTRIES_INDEX_VERSION || header.records_count == 0)
+        goto invalid;
+    if(header.records_count > (index->data_size - sizeof(header)) / sizeof(Entries_Index_Record_s))
+        goto invalid;
+
+    index->table_size = 1;
+    while(index->table_size < header.records_count * 2)
+        index->table_size <<= 1;
+    index->table = calloc(index->table_size, sizeof(u32));
+    if(index->table == NULL)
+        goto invalid;
+
+    u32 offset = sizeof(Entries_Index_Header_s);
+    for(u32 i = 0; i < header.records_count; ++i)
+    {
+        Entries_Index_Record_s record;
+        if(offset + sizeof(record) > index->data_size)
+            goto invalid;
+        memcpy(&record, index->data + offset, sizeof(record));
+        if(!record_valid(&record) || offset + record_size(&record) > index->data_size)
+            goto invalid;
+
+        const u16 * file_name = (const u16 *)(index->data + offset + sizeof(record));
+        u32 slot = hash_file_name(file_name, record.file_name_len) & (index->table_size - 1);
+        while(index->table[slot] != 0)
+            slot = (slot + 1) & (index->table_size - 1);
+        index->table[slot] = offset + 1;
+
+        offset += record_size(&record);
+    }
+
+    index->records_count = header.records_count;
+    index->pack_id = header.pack_id;
+    return;
+
+    invalid:
+    if(index->data_size != 0)
+        DEBUG("Discarding entries index %s\n", index_path);
+    entries_index_free(index);
+}
+
+bool entries_index_fill(Entries_Index_s * index, Entry_s * entry, const Entry_Stamp_s * stamp)
+{
+    if(index->records_count == 0)
+        return false;
+
+    const u16 * const file_name = entry->file_name;
+    const size_t file_name_len = entry->file_name_len;
+    u32 slot = hash_file_name(file_name, file_name_len) & (index->table_size - 1);
+    for(; index->table[slot] != 0; slot = (slot + 1) & (index->table_size - 1))
+    {
+        const char * record_data = index->data + index->table[slot] - 1;
+        Entries_Index_Record_s record;
+        memcpy(&record, record_data, sizeof(record));
+
+        const u16 * strings = (const u16 *)(record_data + sizeof(record));
+        if(record.file_name_len != file_name_len || memcmp(strings, file_name, file_name_len * sizeof(u16)))
+            continue;
+
+        if(record.size != stamp->size || record.mtime != stamp->mtime)
+            return false;
+
+        strings += record.file_name_len;
+        memcpy(entry->name, strings, record.name_len * sizeof(u16));
+        strings += record.name_len;
+        if(entry->desc != NULL)
+            memcpy(entry->desc, strings, record.desc_len * sizeof(u16));
+        strings += record.desc_len;
+        memcpy(entry->author, strings, record.author_len * sizeof(u16));
+        entry->placeholder_color = record.placeholder_color;
+        entry->pack_icon = record.pack_icon;
+        entry->index_offset = index->table[slot] - 1;
+
+        index->hits++;
+        return true;
+    }
+
+    return false;
+}
+
+bool entries_index_up_to_date(const Entries_Index_s * index, int entries_count)
+{
+    return index->hits == (u32)entries_count && index->records_count == (u32)entries_count;
+}
+
+void entries_index_free(Entries_Index_s * index)
+{
+    free(index->data);
+    free(index->table);
+    memset(index, 0, sizeof(Entries_Index_s));
+}
+
+bool entries_index_read_desc(const char * loading_path, const Entry_s * entry, u16 * desc)
+{
+    char index_path[CACHE_PATH_SIZE];
+    cache_file_path(index_path, "index", loading_path);
+    Handle file;
+    if(R_FAILED(vfs_open_file(&file, ArchiveSD, fsMakePath(PATH_ASCII, index_path), FS_OPEN_READ)))
+        return false;
+
+    // the record and its strings up to the description, all in one read
+    u32 buf[(sizeof(Entries_Index_Record_s) + (0x105 + 0x40 + 0x80) * sizeof(u16) + 3) / 4];
+    u32 read = 0;
+    const Result res = vfs_read(file, &read, entry->index_offset, buf, sizeof(buf));
+    vfs_close(file);
+
+    Entries_Index_Record_s record;
+    if(R_FAILED(res) || read < sizeof(record))
+        return false;
+    memcpy(&record, buf, sizeof(record));
+    if(!record_valid(&record) || sizeof(record) + (record.file_name_len + record.name_len + record.desc_len) * sizeof(u16) > read)
+        return false;
+
+    // the index could have been written again since the entry was filled from it
+    const u16 * strings = (const u16 *)((const char *)buf + sizeof(record));
+    if(record.file_name_len != entry->file_name_len || memcmp(strings, entry->file_name, record.file_name_len * sizeof(u16)))
+        return false;
+
+    memset(desc, 0, 0x81 * sizeof(u16));
+    memcpy(desc, strings + record.file_name_len + record.name_len, record.desc_len * sizeof(u16));
+    return true;
+}
+
+// The description of an entry that was left in the previous index is copied from there
+static const u16 * record_desc(const Entries_Index_s * previous, const Entry_s * entry, u16 * desc_len)
+{
+    if(entry->desc != NULL)
+    {
+        *desc_len = strulen(entry->desc, 0x80);
+        return entry->desc;
+    }
+
+    *desc_len = 0;
+    if(entry->index_offset == 0 || entry->index_offset >= previous->data_size)
+        return NULL;
+
+    const char * record_data = previous->data + entry->index_offset;
+    Entries_Index_Record_s record;
+    memcpy(&record, record_data, sizeof(record));
+    *desc_len = record.desc_len;
+    return (const u16 *)(record_data + sizeof(record)) + record.file_name_len + record.name_len;
+}
+
+static u32 fill_record(Entries_Index_Record_s * record, const Entry_s * entry, const Entry_Stamp_s * stamp, const Entries_Index_s * previous)
+{
+    record->size = stamp->size;
+    record->mtime = stamp->mtime;
+    record->placeholder_color = entry->placeholder_color;
+    record->pack_icon = entry->pack_icon;
+    record->file_name_len = min(entry->file_name_len, 0x105);
+    record->name_len = strulen(entry->name, 0x40);
+    record_desc(previous, entry, &record->desc_len);
+    record->author_len = strulen(entry->author, 0x40);
+    return record_size(record);
+}
+
+Result entries_index_save(const char * loading_path, Entry_List_s * list, const Entry_Stamp_s * stamps, const Entries_Index_s * previous, u32 pack_id)
+{
+    TRACE_SPAN("entries_index_save");
+    u32 size = sizeof(Entries_Index_Header_s);
+    for(int i = 0; i < list->entries_count; ++i)
+    {
+        Entries_Index_Record_s record;
+        size += fill_record(&record, list->entries[i], &stamps[i], previous);
+    }
+
+    char * buf = calloc(1, size);
+    if(buf == NULL)
+    {
+        DEBUG("Not enough memory to save the entries index\n");
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+
+    const Entries_Index_Header_s header = {
+        .magic = ENTRIES_INDEX_MAGIC,
+        .version = ENTRIES_INDEX_VERSION,
+        .records_count = list->entries_count,
+        .pack_id = pack_id,
+    };
+    memcpy(buf, &header, sizeof(header));
+
+    u32 offset = sizeof(header);
+    for(int i = 0; i < list->entries_count; ++i)
+    {
+        const Entry_s * entry = list->entries[i];
+        Entries_Index_Record_s record;
+        const u32 this_size = fill_record(&record, entry, &stamps[i], previous);
+        memcpy(buf + offset, &record, sizeof(record));
+
+        u16 * strings = (u16 *)(buf + offset + sizeof(record));
+        memcpy(strings, entry->file_name, record.file_name_len * sizeof(u16));
+        strings += record.file_name_len;
+        memcpy(strings, entry->name, record.name_len * sizeof(u16));
+        strings += record.name_len;
+        if(record.desc_len != 0)
+            memcpy(strings, record_desc(previous, entry, &record.desc_len), record.desc_len * sizeof(u16));
+        strings += record.desc_len;
+        memcpy(strings, entry->author, record.author_len * sizeof(u16));
+
+        offset += this_size;
+    }
+
+    char index_path[CACHE_PATH_SIZE];
+    cache_file_path(index_path, "index", loading_path);
+    Result res = rewrite_file(fsMakePath(PATH_ASCII, index_path), ArchiveSD, size, buf, size);
+    if(R_FAILED(res))
+        DEBUG("Failed to save entries index %s: 0x%08lx\n", index_path, res);
+
+    // the records are where this index put them now, or nowhere if it couldn't be written
+    offset = sizeof(header);
+    for(int i = 0; i < list->entries_count; ++i)
+    {
+        Entries_Index_Record_s record;
+        const u32 this_size = fill_record(&record, list->entries[i], &stamps[i], previous);
+        list->entries[i]->index_offset = R_SUCCEEDED(res) ? offset : 0;
+        offset += this_size;
+    }
+
+    free(buf);
+    return res;
+}
@@ -26,32 +26,175 @@
 
 #include "entries_list.h"
 #include "loading.h"
-#include "draw.h"
+#include "ui_feedback.h"
 #include "fs.h"
 #include "unicode.h"
+#include "iostats.h"
+#include "trace.h"
+#include "entries_index.h"
+#include "smdh_pipeline.h"
+#include "icon_pack.h"
+#include "collation.h"
+#include "search_index.h"
+
+static FS_Path utf16_path(u16 * path, u32 len)
+{
+    path[len] = 0;
+    return (FS_Path){
+        .type = PATH_UTF16,
+        .size = (len + 1) * sizeof(u16),
+        .data = path,
+    };
+}
+
+static u32 append_ascii(u16 * path, u32 len, const char * text)
+{
+    for(; *text != '\0' && len < ENTRY_PATH_SIZE - 1; ++text)
+        path[len++] = *text;
+    return len;
+}
+
+static u32 write_entry_path(const Entry_s * entry, u16 * out)
+{
+    u32 len = 0;
+    if(entry->prefix != NULL)
+    {
+        len = entry->prefix->len;
+        memcpy(out, entry->prefix->path, len * sizeof(u16));
+    }
+
+    const u32 file_name_len = min(entry->file_name_len, ENTRY_PATH_SIZE - 1 - len);
+    memcpy(out + len, entry->file_name, file_name_len * sizeof(u16));
+    return len + file_name_len;
+}
+
+FS_Path entry_path(const Entry_s * entry, const char * inner, u16 * out)
+{
+    u32 len = write_entry_path(entry, out);
+    if(inner != NULL)
+        len = append_ascii(out, len, inner);
+    return utf16_path(out, len);
+}
 
 void delete_entry(Entry_s * entry, bool is_file)
 {
+    u16 path[ENTRY_PATH_SIZE];
     if(is_file)
-        FSUSER_DeleteFile(ArchiveSD, fsMakePath(PATH_UTF16, entry->path));
+        vfs_delete_file(ArchiveSD, entry_path(entry, NULL, path));
     else
-        FSUSER_DeleteDirectoryRecursively(ArchiveSD, fsMakePath(PATH_UTF16, entry->path));
+        vfs_delete_dir_recursively(ArchiveSD, entry_path(entry, NULL, path));
 }
 
 u32 load_data(const char * filename, const Entry_s * entry, char ** buf)
 {
+    Entry_Session_s session;
+    entry_session_open(&session, entry);
+    u32 size = entry_session_load(&session, filename, buf);
+    entry_session_close(&session);
+    return size;
+}
+
+// The zip is only opened on the first load, so a session can be opened up front for not much more than copying its path
+void entry_session_open(Entry_Session_s * session, const Entry_s * entry)
+{
+    session->entry = entry;
+    session->path_len = write_entry_path(entry, session->path);
+    session->path[session->path_len] = 0;
+    session->zip_tried = false;
+    session->zip_opened = false;
+}
+
+static const Zip_s * session_zip(Entry_Session_s * session)
+{
+    if(!session->zip_tried)
+    {
+        IOSTATS_SITE("zip_open");
+        session->zip_tried = true;
+        session->zip_opened = R_SUCCEEDED(zip_open(&session->zip, ArchiveSD, utf16_path(session->path, session->path_len)));
+    }
+
+    return session->zip_opened ? &session->zip : NULL;
+}
+
+// the file read before is cut off again
+static const u16 * session_entry_path(Entry_Session_s * session)
+{
+    session->path[session->path_len] = 0;
+    return session->path;
+}
+
+static FS_Path session_file_path(Entry_Session_s * session, const char * filename)
+{
+    return utf16_path(session->path, append_ascii(session->path, session->path_len, filename));
+}
+
+u32 entry_session_load(Entry_Session_s * session, const char * filename, char ** buf)
+{
+    const Entry_s * entry = session->entry;
     if(entry->is_zip)
     {
-        return zip_file_to_buf(filename + 1, entry->path, buf); //the first character will always be '/' because of the other case
+        //the first character will always be '/' because of the other case
+        return zip_opened_file_to_buf(session_zip(session), filename + 1, session_entry_path(session), buf);
     }
     else
     {
-        u16 path[0x106] = {0};
-        strucat(path, entry->path);
-        struacat(path, filename);
+        return file_to_buf(session_file_path(session, filename), ArchiveSD, buf);
+    }
+}
 
-        return file_to_buf(fsMakePath(PATH_UTF16, path), ArchiveSD, buf);
+// Like entry_session_load, except a deflated zip member is left compressed for zip_inflate.
+// member->compressed_size is only non zero when that happened
+u32 entry_session_load_deflated(Entry_Session_s * session, const char * filename, char ** buf, Zip_Entry_s * member)
+{
+    memset(member, 0, sizeof(Zip_Entry_s));
+    const Zip_s * zip = session->entry->is_zip ? session_zip(session) : NULL;
+    if(zip != NULL)
+    {
+        const Zip_Entry_s * found = zip_find(zip, filename + 1);
+        const u32 size = found != NULL ? zip_read_compressed(zip, found, buf) : 0;
+        if(size != 0)
+        {
+            *member = *found;
+            return size;
+        }
     }
+
+    return entry_session_load(session, filename, buf);
+}
+
+// Reads the file into buf if it fits in max_size, returns its size either way
+u32 entry_session_load_into(Entry_Session_s * session, const char * filename, char * buf, u32 max_size)
+{
+    const Entry_s * entry = session->entry;
+    if(entry->is_zip)
+    {
+        return zip_opened_file_to_given_buf(session_zip(session), filename + 1, session_entry_path(session), buf, max_size);
+    }
+    else
+    {
+        return file_to_given_buf(session_file_path(session, filename), ArchiveSD, buf, max_size);
+    }
+}
+
+// Writes the file to dest at dest_offset if it fits in max_size, without loading all of it. Returns its size either way
+u32 entry_session_copy_to_file(Entry_Session_s * session, const char * filename, Handle dest, u64 dest_offset, u32 max_size)
+{
+    const Entry_s * entry = session->entry;
+    if(entry->is_zip)
+    {
+        return zip_opened_file_to_handle(session_zip(session), filename + 1, session_entry_path(session), dest, dest_offset, max_size);
+    }
+    else
+    {
+        return file_to_handle(session_file_path(session, filename), ArchiveSD, dest, dest_offset, max_size);
+    }
+}
+
+void entry_session_close(Entry_Session_s * session)
+{
+    if(session->zip_opened)
+        zip_close(&session->zip);
+    session->zip_opened = false;
 }
 
 C2D_Image get_icon_at(Entry_List_s * list, size_t index)
@@ -62,76 +205,606 @@ C2D_Image get_icon_at(Entry_List_s * list, size_t index)
     };
 }
 
-static int compare_entries_base(const Entry_s * const a, const Entry_s * const b)
+static void unlink_icon(Entry_List_s * list, int slot)
+{
+    Entry_Icon_s * const icon = &list->icons_info[slot];
+    if(icon->newer >= 0)
+        list->icons_info[icon->newer].older = icon->older;
+    else
+        list->icons_newest = icon->older;
+    if(icon->older >= 0)
+        list->icons_info[icon->older].newer = icon->newer;
+    else
+        list->icons_oldest = icon->newer;
+}
+
+static void link_icon_newest(Entry_List_s * list, int slot)
+{
+    Entry_Icon_s * const icon = &list->icons_info[slot];
+    icon->newer = -1;
+    icon->older = list->icons_newest;
+    if(list->icons_newest >= 0)
+        list->icons_info[list->icons_newest].newer = slot;
+    else
+        list->icons_oldest = slot;
+    list->icons_newest = slot;
+}
+
+static void link_icon_oldest(Entry_List_s * list, int slot)
+{
+    Entry_Icon_s * const icon = &list->icons_info[slot];
+    icon->older = -1;
+    icon->newer = list->icons_oldest;
+    if(list->icons_oldest >= 0)
+        list->icons_info[list->icons_oldest].older = slot;
+    else
+        list->icons_newest = slot;
+    list->icons_oldest = slot;
+}
+
+void list_reset_icons(Entry_List_s * list)
+{
+    list->icons_newest = -1;
+    list->icons_oldest = -1;
+    for(int i = 0; i < list->icons_count; ++i)
+    {
+        Entry_Icon_s * const icon = &list->icons_info[i];
+        if(icon->entry != NULL)
+            icon->entry->icon_slot = 0;
+        icon->entry = NULL;
+        icon->ready = false;
+        icon->requested = false;
+        icon->claims++;
+        link_icon_newest(list, i);
+    }
+}
+
+int list_use_icon(Entry_List_s * list, const Entry_s * entry)
+{
+    const int slot = entry->icon_slot - 1;
+    if(slot >= 0 && slot != list->icons_newest)
+    {
+        unlink_icon(list, slot);
+        link_icon_newest(list, slot);
+    }
+    return slot;
+}
+
+int list_claim_icon(Entry_List_s * list, Entry_s * entry)
+{
+    const int slot = list->icons_oldest;
+    Entry_Icon_s * const icon = &list->icons_info[slot];
+    if(icon->entry != NULL)
+        icon->entry->icon_slot = 0;
+    icon->entry = entry;
+    icon->ready = false;
+    icon->requested = false;
+    icon->claims++;
+    entry->icon_slot = slot + 1;
+    unlink_icon(list, slot);
+    link_icon_newest(list, slot);
+    return slot;
+}
+
+// the slot is the first to be taken again
+static void drop_icon(Entry_List_s * list, Entry_s * entry)
+{
+    const int slot = entry->icon_slot - 1;
+    if(slot < 0)
+        return;
+
+    Entry_Icon_s * const icon = &list->icons_info[slot];
+    icon->entry = NULL;
+    icon->ready = false;
+    icon->requested = false;
+    icon->claims++;
+    entry->icon_slot = 0;
+    unlink_icon(list, slot);
+    link_icon_oldest(list, slot);
+}
+
+// the key of an entry is whether it's filled, so those without an smdh come last, then the collation key of the field
+static u32 entry_sort_key(u8 * out, const Entry_s * entry, SortMode mode)
 {
-    // entry->placeholder_color == 0 means it is not filled (no name, author, description)
-    // if a is filled and b is filled, return == 0
-    // if a is not filled and b is not filled, return == 0
-    // if a is not filled, return < 0
-    // if b is an unfilled entry, return > 0
-    return ((int)(a->placeholder_color != 0)) - ((int)(b->placeholder_color != 0));
+    if(out != NULL)
+        out[0] = entry->placeholder_color != 0;
+
+    u8 * const text_out = out != NULL ? out + 1 : NULL;
+    if(mode == SORT_AUTHOR)
+        return 1 + collation_key(text_out, entry->author, 0x40);
+    else if(mode == SORT_PATH)
+        return 1 + collation_key(text_out, entry->file_name, entry->file_name_len);
+    return 1 + collation_key(text_out, entry->name, 0x40);
 }
 
-typedef int (*sort_comparator)(const void *, const void *);
-static int compare_entries_by_name(const void * a, const void * b)
+// Returns the entry ids in the order of mode, NULL without enough memory
+static u32 * build_sort_order(const Entry_List_s * list, SortMode mode)
 {
-    const Entry_s * const entry_a = (const Entry_s *)a;
-    const Entry_s * const entry_b = (const Entry_s *)b;
-    const int base = compare_entries_base(entry_a, entry_b);
-    if(base)
-        return base;
+    const u32 count = list->entries_count;
+    u32 * const offsets = malloc((count + 1) * sizeof(u32));
+    u32 * order = malloc(count * sizeof(u32));
+    u8 * keys = NULL;
+    if(offsets == NULL || order == NULL)
+        goto fail;
+
+    u32 keys_size = 0;
+    for(u32 i = 0; i < count; ++i)
+    {
+        offsets[i] = keys_size;
+        keys_size += entry_sort_key(NULL, list->entries[i], mode);
+    }
+    offsets[count] = keys_size;
+
+    keys = malloc(keys_size);
+    if(keys == NULL)
+        goto fail;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        entry_sort_key(keys + offsets[i], list->entries[i], mode);
+        order[i] = i;
+    }
+
+    if(!collation_sort(order, count, keys, offsets))
+        goto fail;
 
-    return memcmp(entry_a->name, entry_b->name, 0x40 * sizeof(u16));
+    for(u32 i = 0; i < count; ++i)
+        order[i] = list->entries[order[i]]->id;
+
+    free(keys);
+    free(offsets);
+    return order;
+
+    fail:
+    free(keys);
+    free(order);
+    free(offsets);
+    return NULL;
 }
-static int compare_entries_by_author(const void * a, const void * b)
+
+// Moves every entry once to where ids puts it
+static bool apply_sort_order(Entry_List_s * list, const u32 * ids)
 {
-    const Entry_s * const entry_a = (const Entry_s *)a;
-    const Entry_s * const entry_b = (const Entry_s *)b;
-    const int base = compare_entries_base(entry_a, entry_b);
-    if(base)
-        return base;
+    const u32 count = list->entries_count;
+    u32 * positions = malloc(count * sizeof(u32));
+    u32 * order = malloc(count * sizeof(u32));
+    if(positions == NULL || order == NULL)
+    {
+        free(order);
+        free(positions);
+        return false;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+        positions[list->entries[i]->id] = i;
+    for(u32 i = 0; i < count; ++i)
+        order[i] = positions[ids[i]];
+    free(positions);
 
-    return memcmp(entry_a->author, entry_b->author, 0x40 * sizeof(u16));
+    // order[i] is where the entry that goes at i is now, follow each cycle of that with a single spare entry
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(order[i] == i)
+            continue;
+
+        Entry_s * const held = list->entries[i];
+        u32 j = i;
+        while(order[j] != i)
+        {
+            const u32 next = order[j];
+            list->entries[j] = list->entries[next];
+            order[j] = j;
+            j = next;
+        }
+        list->entries[j] = held;
+        order[j] = j;
+    }
+
+    free(order);
+    return true;
+}
+
+// entries hidden by a search go back after the visible ones, in the order they were in
+static void show_hidden_entries(Entry_List_s * list)
+{
+    list->entries_count += list->hidden_count;
+    list->hidden_count = 0;
+}
+
+// Moves the entries matching the search to the front, keeping their order, and hides the rest
+static void apply_search_matches(Entry_List_s * list)
+{
+    const u32 count = list->entries_count;
+    u32 * ids = malloc(count * sizeof(u32));
+    if(ids == NULL)
+    {
+        DEBUG("Not enough memory to filter the list\n");
+        return;
+    }
+
+    u32 matched = 0;
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(list->search_matches[list->entries[i]->id])
+            ids[matched++] = list->entries[i]->id;
+    }
+    for(u32 i = 0, j = matched; i < count; ++i)
+    {
+        if(!list->search_matches[list->entries[i]->id])
+            ids[j++] = list->entries[i]->id;
+    }
+
+    if(apply_sort_order(list, ids))
+    {
+        list->entries_count = matched;
+        list->hidden_count = count - matched;
+    }
+    free(ids);
 }
-static int compare_entries_by_filename(const void * a, const void * b)
+
+static void sort_list(Entry_List_s * list, SortMode mode)
 {
-    const Entry_s * const entry_a = (const Entry_s *)a;
-    const Entry_s * const entry_b = (const Entry_s *)b;
-    const int base = compare_entries_base(entry_a, entry_b);
-    if(base)
-        return base;
+    show_hidden_entries(list);
+    if(list->entries == NULL || list->entries_count < 2)
+        return;
+
+    if(list->sort_orders[mode] == NULL)
+        list->sort_orders[mode] = build_sort_order(list, mode);
+
+    if(list->sort_orders[mode] == NULL || !apply_sort_order(list, list->sort_orders[mode]))
+        DEBUG("Not enough memory to sort the list\n");
+
+    if(list->search_matches != NULL)
+        apply_search_matches(list);
+}
+
+// what the search looks through: the name, author and file name, folded like the sort keys
+static u32 entry_search_text(u8 * out, const Entry_s * entry)
+{
+    u32 len = collation_key(out, entry->name, 0x40);
+    if(out != NULL)
+        out[len] = SEARCH_FIELD_SEPARATOR;
+    len++;
+
+    len += collation_key(out != NULL ? out + len : NULL, entry->author, 0x40);
+    if(out != NULL)
+        out[len] = SEARCH_FIELD_SEPARATOR;
+    len++;
+
+    return len + collation_key(out != NULL ? out + len : NULL, entry->file_name, entry->file_name_len);
+}
+
+// texts are laid out by entry id, so the index doesn't care how the list is sorted
+static bool build_search_index(Entry_List_s * list)
+{
+    const u32 count = list->entries_count + list->hidden_count;
+    u32 * text_offsets = calloc(count + 1, sizeof(u32));
+    if(text_offsets == NULL)
+        return false;
+
+    for(u32 i = 0; i < count; ++i)
+        text_offsets[list->entries[i]->id + 1] = entry_search_text(NULL, list->entries[i]);
+    for(u32 i = 0; i < count; ++i)
+        text_offsets[i + 1] += text_offsets[i];
+
+    u8 * texts = malloc(text_offsets[count]);
+    if(texts == NULL)
+    {
+        free(text_offsets);
+        return false;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+        entry_search_text(texts + text_offsets[list->entries[i]->id], list->entries[i]);
+
+    return search_index_build(&list->search_index, texts, text_offsets, count);
+}
+
+bool list_search(Entry_List_s * list, const u16 * query)
+{
+    u8 folded[0x40 * COLLATION_MAX_BYTES_PER_UNIT];
+    const u32 query_len = collation_key(folded, query, 0x40);
+    if(query_len == 0)
+    {
+        list_clear_search(list);
+        return true;
+    }
+
+    if(list->entries == NULL || (list->search_index.texts == NULL && !build_search_index(list)))
+        return false;
+
+    u8 * matches = malloc(list->entries_count + list->hidden_count);
+    if(matches == NULL)
+        return false;
+
+    if(search_index_query(&list->search_index, folded, query_len, matches) == 0)
+    {
+        free(matches);
+        return false;
+    }
+
+    free(list->search_matches);
+    list->search_matches = matches;
+    // start again from the sorted list, so the matches keep its order
+    if(list->current_sort != SORT_NONE)
+    {
+        sort_list(list, list->current_sort);
+    }
+    else
+    {
+        show_hidden_entries(list);
+        apply_search_matches(list);
+    }
+    return true;
+}
+
+void list_clear_search(Entry_List_s * list)
+{
+    if(list->search_matches == NULL)
+        return;
+
+    free(list->search_matches);
+    list->search_matches = NULL;
+    // puts the entries that were hidden back where they belong
+    if(list->current_sort != SORT_NONE)
+        sort_list(list, list->current_sort);
+    else
+        show_hidden_entries(list);
+}
+
+bool list_show_groups(Entry_List_s * list, const u32 * groups, int groups_count)
+{
+    list_clear_search(list);
+    const u32 count = list->entries_count;
+    if(list->entries == NULL || groups_count <= 0)
+        return false;
+
+    u8 * matches = calloc(count, 1);
+    u32 * ids = malloc(count * sizeof(u32));
+    // where every group starts in ids, by the order its first entry comes in
+    u32 * ranks = calloc(groups_count + 1, sizeof(u32));
+    u32 * starts = calloc(groups_count + 1, sizeof(u32));
+    bool shown = false;
+    if(matches == NULL || ids == NULL || ranks == NULL || starts == NULL)
+    {
+        DEBUG("Not enough memory to group the list\n");
+        goto end;
+    }
+
+    u32 ranked = 0;
+    for(u32 i = 0; i < count; ++i)
+    {
+        const u32 group = groups[list->entries[i]->id];
+        if(group == 0)
+            continue;
+        if(ranks[group] == 0)
+            ranks[group] = ++ranked;
+        starts[ranks[group]]++;
+    }
+    // starts[r] becomes the amount of grouped entries before rank r + 1
+    for(u32 r = 1; r <= ranked; ++r)
+        starts[r] += starts[r - 1];
+    const u32 matched = starts[ranked];
+
+    for(u32 i = 0, j = matched; i < count; ++i)
+    {
+        const u32 id = list->entries[i]->id;
+        const u32 group = groups[id];
+        if(group == 0)
+        {
+            ids[j++] = id;
+            continue;
+        }
+        ids[starts[ranks[group] - 1]++] = id;
+        matches[id] = 1;
+    }
+
+    if(!apply_sort_order(list, ids))
+        goto end;
+
+    list->entries_count = matched;
+    list->hidden_count = count - matched;
+    list->search_matches = matches;
+    matches = NULL;
+    // the groups are only together in this order
+    list->current_sort = SORT_NONE;
+    shown = true;
 
-    return memcmp(entry_a->path, entry_b->path, 0x106 * sizeof(u16));
+    end:
+    free(starts);
+    free(ranks);
+    free(ids);
+    free(matches);
+    return shown;
 }
 
-static void sort_list(Entry_List_s * list, sort_comparator compare_entries)
+// everything here refers to entries by id, so it has to go when entries come and go
+static void clear_list_caches(Entry_List_s * list)
 {
-    if(list->entries != NULL && list->entries != NULL)
-        qsort(list->entries, list->entries_count, sizeof(Entry_s), compare_entries); //alphabet sort
+    for(int i = 0; i < SORT_MODES_AMOUNT; ++i)
+    {
+        free(list->sort_orders[i]);
+        list->sort_orders[i] = NULL;
+    }
+
+    free(list->search_matches);
+    list->search_matches = NULL;
+    show_hidden_entries(list);
+    search_index_free(&list->search_index);
 }
 
 void sort_by_name(Entry_List_s * list)
 {
-    sort_list(list, compare_entries_by_name);
+    TRACE_SPAN("sort_by_name");
+    sort_list(list, SORT_NAME);
     list->current_sort = SORT_NAME;
 }
 void sort_by_author(Entry_List_s * list)
 {
-    sort_list(list, compare_entries_by_author);
+    sort_list(list, SORT_AUTHOR);
     list->current_sort = SORT_AUTHOR;
 }
 void sort_by_filename(Entry_List_s * list)
 {
-    sort_list(list, compare_entries_by_filename);
+    sort_list(list, SORT_PATH);
     list->current_sort = SORT_PATH;
 }
 
 #define LOADING_DIR_ENTRIES_COUNT 16
 static FS_DirectoryEntry loading_dir_entries[LOADING_DIR_ENTRIES_COUNT];
+void list_init_capacity(Entry_List_s * list, const int init_capacity)
+{
+    list->entries = malloc(init_capacity * sizeof(Entry_s *));
+    list->entries_capacity = init_capacity;
+}
+
+// Returns a record of size bytes, NULL without enough memory
+static void * pool_take(Entry_Pool_s * pool, size_t size, int block_size)
+{
+    void * record = pool->free_records;
+    if(record != NULL)
+    {
+        memcpy(&pool->free_records, record, sizeof(void *));
+        return record;
+    }
+
+    const int index = pool->used % block_size;
+    if(index == 0)
+    {
+        void ** const new_blocks = realloc(pool->blocks, (pool->blocks_count + 1) * sizeof(void *));
+        if(new_blocks == NULL)
+            return NULL;
+        pool->blocks = new_blocks;
+
+        void * const block = malloc(block_size * size);
+        if(block == NULL)
+            return NULL;
+        pool->blocks[pool->blocks_count++] = block;
+    }
+
+    pool->used++;
+    return (u8 *)pool->blocks[pool->blocks_count - 1] + index * size;
+}
+
+// records are only aligned to what they hold, the link is copied in and out
+static void pool_give_back(Entry_Pool_s * pool, void * record)
+{
+    memcpy(record, &pool->free_records, sizeof(void *));
+    pool->free_records = record;
+}
+
+static void pool_free(Entry_Pool_s * pool)
+{
+    for(int i = 0; i < pool->blocks_count; ++i)
+        free(pool->blocks[i]);
+    free(pool->blocks);
+    memset(pool, 0, sizeof(Entry_Pool_s));
+}
+
+// Appends a zeroed entry with the next id, leaving the caches alone. Only the
+// array of pointers grows, by doubling since it's a fraction of the entries' size
+static ssize_t new_entry(Entry_List_s * list, bool keep_desc)
+{
+    const int count = list->entries_count + list->hidden_count;
+    if(count == list->entries_capacity)
+    {
+        const int next_capacity = list->entries_capacity * 2;
+        Entry_s ** const new_list = realloc(list->entries, next_capacity * sizeof(Entry_s *));
+        if(new_list == NULL)
+        {
+            return -1;
+        }
+
+        list->entries = new_list;
+        list->entries_capacity = next_capacity;
+    }
+
+    Entry_s * const entry = pool_take(&list->entry_pool, sizeof(Entry_s), ENTRY_BLOCK_SIZE);
+    if(entry == NULL)
+        return -1;
+
+    static const u16 no_file_name[1] = {0};
+    memset(entry, 0, sizeof(Entry_s));
+    entry->prefix = list->prefix;
+    entry->file_name = no_file_name;
+    entry->id = count;
+    if(keep_desc && !list_keep_desc(list, entry))
+    {
+        pool_give_back(&list->entry_pool, entry);
+        return -1;
+    }
+
+    list->entries[count] = entry;
+    return list->entries_count++;
+}
+
+ssize_t list_add_entry(Entry_List_s * list)
+{
+    clear_list_caches(list);
+    return new_entry(list, true);
+}
+
+bool list_keep_desc(Entry_List_s * list, Entry_s * entry)
+{
+    if(entry->desc != NULL)
+        return true;
+
+    Entry_Cold_s * const cold = pool_take(&list->cold_pool, sizeof(Entry_Cold_s), ENTRY_COLD_BLOCK_SIZE);
+    if(cold == NULL)
+        return false;
+
+    memset(cold, 0, sizeof(Entry_Cold_s));
+    entry->desc = cold->desc;
+    return true;
+}
+
+const u16 * list_entry_desc(Entry_List_s * list, const Entry_s * entry)
+{
+    static const u16 no_desc[1] = {0};
+    if(entry->desc != NULL)
+        return entry->desc;
+    if(entry->index_offset == 0 || list->loading_path == NULL)
+        return no_desc;
+
+    for(int i = 0; i < ENTRY_DESC_CACHE_SIZE; ++i)
+    {
+        if(list->desc_cache[i].entry == entry)
+            return list->desc_cache[i].desc;
+    }
+
+    Entry_Desc_Cache_s * const cached = &list->desc_cache[list->desc_cache_next];
+    list->desc_cache_next = (list->desc_cache_next + 1) % ENTRY_DESC_CACHE_SIZE;
+    cached->entry = entry;
+    // not being able to read it is remembered too, so it isn't tried again every frame
+    if(!entries_index_read_desc(list->loading_path, entry, cached->desc))
+        memset(cached->desc, 0, sizeof(cached->desc));
+    return cached->desc;
+}
+
+void parse_smdh(Icon_s * icon, Entry_s * entry, const u16 * fallback_name)
+{
+    if(icon == NULL)
+    {
+        memset(entry->name, 0, sizeof(entry->name));
+        memcpy(entry->name, fallback_name, strulen(fallback_name, 0x40) * sizeof(u16));
+        utf8_to_utf16(entry->desc, (u8 *)"No description", 0x100);
+        utf8_to_utf16(entry->author, (u8 *)"Unknown author", 0x80);
+        entry->placeholder_color = C2D_Color32(rand() % 255, rand() % 255, rand() % 255, 255);
+        return;
+    }
+
+    memcpy(entry->name, icon->name, 0x40 * sizeof(u16));
+    memcpy(entry->desc, icon->desc, 0x80 * sizeof(u16));
+    memcpy(entry->author, icon->author, 0x40 * sizeof(u16));
+    entry->placeholder_color = 0;
+}
+
 Result load_entries(const char * loading_path, Entry_List_s * list, const InstallType loading_screen)
 {
+    IOSTATS_PHASE("load_entries");
+    TRACE_SPAN("load_entries");
     Handle dir_handle;
-    Result res = FSUSER_OpenDirectory(&dir_handle, ArchiveSD, fsMakePath(PATH_ASCII, loading_path));
+    Result res = vfs_open_dir(&dir_handle, ArchiveSD, fsMakePath(PATH_ASCII, loading_path));
     if(R_FAILED(res))
     {
         DEBUG("Failed to open folder: %s\n", loading_path);
@@ -139,11 +812,19 @@ Result load_entries(const char * loading_path, Entry_List_s * list, const Instal
     }
 
     list_init_capacity(list, LOADING_DIR_ENTRIES_COUNT);
+    if(!list_set_prefix(list, loading_path))
+    {
+        vfs_close_dir(dir_handle);
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+
+    int stamps_capacity = list->entries_capacity;
+    Entry_Stamp_s * stamps = malloc(stamps_capacity * sizeof(Entry_Stamp_s));
 
     u32 entries_read = LOADING_DIR_ENTRIES_COUNT;
     while(entries_read == LOADING_DIR_ENTRIES_COUNT)
     {
-        res = FSDIR_Read(dir_handle, &entries_read, LOADING_DIR_ENTRIES_COUNT, loading_dir_entries);
+        res = vfs_read_dir(dir_handle, &entries_read, LOADING_DIR_ENTRIES_COUNT, loading_dir_entries);
         if(R_FAILED(res))
             break;
 
@@ -154,7 +835,13 @@ Result load_entries(const char * loading_path, Entry_List_s * list, const Instal
             if(!(dir_entry->attributes & FS_ATTRIBUTE_DIRECTORY) && !is_zip)
                 continue;
 
-            const ssize_t new_entry_index = list_add_entry(list);
+            // descriptions are given out below, once it's known whether they're kept
+            ssize_t new_entry_index = new_entry(list, false);
+            if(new_entry_index >= 0 && !list_set_file_name(list, list->entries[new_entry_index], dir_entry->name, strulen(dir_entry->name, 0x106)))
+            {
+                list_remove_entry(list, new_entry_index);
+                new_entry_index = -1;
+            }
             if(new_entry_index < 0)
             {
                 // out of memory: still allow use of currently loaded entries.
@@ -163,20 +850,47 @@ Result load_entries(const char * loading_path, Entry_List_s * list, const Instal
                 break;
             }
 
-            Entry_s * const current_entry = &list->entries[new_entry_index];
-            memset(current_entry, 0, sizeof(Entry_s));
-            struacat(current_entry->path, loading_path);
-            strucat(current_entry->path, dir_entry->name);
+            if(stamps != NULL && new_entry_index >= stamps_capacity)
+            {
+                stamps_capacity = list->entries_capacity;
+                Entry_Stamp_s * new_stamps = realloc(stamps, stamps_capacity * sizeof(Entry_Stamp_s));
+                if(new_stamps == NULL)
+                    free(stamps);
+                stamps = new_stamps;
+            }
+
+            Entry_s * const current_entry = list->entries[new_entry_index];
             current_entry->is_zip = is_zip;
+            if(stamps != NULL)
+                stamps[new_entry_index].size = is_zip ? dir_entry->fileSize : 0;
         }
     }
 
-    FSDIR_Close(dir_handle);
+    vfs_close_dir(dir_handle);
 
     list->loading_path = loading_path;
     const int loading_bar_ticks = list->entries_count / 10;
 
-    for(int i = 0, j = 0; i < list->entries_count; ++i)
+    // without room for the stamps, nothing can be checked against the index
+    Entries_Index_s index;
+    memset(&index, 0, sizeof(index));
+    // the icons are only packed along with an index to find them in
+    Icon_Pack_s pack;
+    memset(&pack, 0, sizeof(pack));
+    if(stamps != NULL)
+    {
+        entries_index_load(&index, loading_path);
+        icon_pack_open(&pack, loading_path, index.pack_id, list->entries_count);
+    }
+    // a big list only keeps the descriptions the index doesn't have
+    list->page_cold = stamps != NULL && list->entries_count > ENTRY_COLD_RESIDENT_MAX;
+
+    // what the index can't fill goes through the pipeline once it has been checked for everything
+    int * to_parse = malloc(list->entries_count * sizeof(int));
+    int to_parse_count = 0;
+
+    int i = 0;
+    for(int j = 0; i < list->entries_count; ++i)
     {
         // replaces (i % loading_bar_ticks) == 0
         if(++j >= loading_bar_ticks)
@@ -184,48 +898,344 @@ Result load_entries(const char * loading_path, Entry_List_s * list, const Instal
             j = 0;
             draw_loading_bar(i, list->entries_count, loading_screen);
         }
-        Entry_s * const current_entry = &list->entries[i];
+        Entry_s * const current_entry = list->entries[i];
+        const u16 * const file_name = current_entry->file_name;
+        if(!list->page_cold && !list_keep_desc(list, current_entry))
+            break;
+        if(stamps != NULL)
+        {
+            // folders have no size, and their own timestamp doesn't follow edits to the files inside
+            u16 stamp_path[ENTRY_PATH_SIZE];
+            const FS_Path stamp_fs_path = entry_path(current_entry, current_entry->is_zip ? NULL : "/info.smdh", stamp_path);
+            if(R_FAILED(vfs_get_mtime(ArchiveSD, stamp_fs_path, &stamps[i].mtime)))
+                stamps[i].mtime = 0;
+
+            if(entries_index_fill(&index, current_entry, &stamps[i]))
+            {
+                if(current_entry->pack_icon != ENTRY_NO_ICON && current_entry->pack_icon > pack.icons_count)
+                    current_entry->pack_icon = 0;
+                // an icon missing from the pack is read with the entries the index couldn't fill, to pack it
+                if(current_entry->pack_icon != 0 || pack.file == 0)
+                    continue;
+            }
+        }
+
+        if(!list_keep_desc(list, current_entry))
+            break;
+        if(to_parse != NULL)
+        {
+            to_parse[to_parse_count++] = i;
+            continue;
+        }
+
         char * buf = NULL;
         u32 buflen = load_data("/info.smdh", current_entry, &buf);
-        parse_smdh(buflen == sizeof(Icon_s) ? (Icon_s *)buf : NULL, current_entry, current_entry->path + strlen(loading_path));
+        parse_smdh(buflen == sizeof(Icon_s) ? (Icon_s *)buf : NULL, current_entry, file_name);
         free(buf);
     }
 
+    // out of memory for descriptions: like above, the entries that got one are still usable
+    while(list->entries_count > i)
+        list_remove_entry(list, list->entries_count - 1);
+
+    if(to_parse_count != 0)
+        smdh_pipeline_run(list, to_parse, to_parse_count, loading_screen, pack.file != 0 ? &pack : NULL);
+    free(to_parse);
+
+    // without the icons written, the index mustn't point at them
+    if(R_FAILED(icon_pack_commit(&pack)))
+    {
+        vfs_close(pack.file);
+        pack.file = 0;
+        pack.id = 0;
+    }
+    list->icon_pack = pack.file;
+
+    if(stamps != NULL && (to_parse_count != 0 || !entries_index_up_to_date(&index, list->entries_count)))
+        entries_index_save(loading_path, list, stamps, &index, pack.id);
+    entries_index_free(&index);
+    free(stamps);
+
+    iostats_report("load_entries");
     return res;
 }
 
-void list_init_capacity(Entry_List_s * list, const int init_capacity)
+bool list_set_prefix(Entry_List_s * list, const char * path)
 {
-    list->entries = malloc(init_capacity * sizeof(Entry_s));
-    list->entries_capacity = init_capacity;
+    if(list->prefix == NULL)
+        list->prefix = malloc(sizeof(Entry_Prefix_s));
+    if(list->prefix == NULL)
+        return false;
+
+    memset(list->prefix, 0, sizeof(Entry_Prefix_s));
+    utf8_to_utf16(list->prefix->path, (const u8 *)path, 0x105);
+    list->prefix->len = strulen(list->prefix->path, 0x105);
+    return true;
 }
 
-#define LIST_CAPACITY_THRESHOLD 512
-ssize_t list_add_entry(Entry_List_s * list)
+bool list_set_file_name(Entry_List_s * list, Entry_s * entry, const u16 * file_name, size_t len)
 {
-    if(list->entries_count == list->entries_capacity)
+    // with the terminator
+    const int units = len + 1;
+    if(list->name_blocks_count == 0 || list->name_block_used + units > ENTRY_NAMES_BLOCK_SIZE)
     {
-        int next_capacity = list->entries_capacity;
-        // expand by doubling until we hit LIST_CAPACITY_THRESHOLD
-        // then simply increment by that, to have less extra space leftover
-        if(next_capacity < LIST_CAPACITY_THRESHOLD)
+        u16 ** const new_blocks = realloc(list->name_blocks, (list->name_blocks_count + 1) * sizeof(u16 *));
+        if(new_blocks == NULL)
+            return false;
+        list->name_blocks = new_blocks;
+
+        u16 * const block = malloc(ENTRY_NAMES_BLOCK_SIZE * sizeof(u16));
+        if(block == NULL)
+            return false;
+        list->name_blocks[list->name_blocks_count++] = block;
+        list->name_block_used = 0;
+    }
+
+    u16 * const name = &list->name_blocks[list->name_blocks_count - 1][list->name_block_used];
+    memcpy(name, file_name, len * sizeof(u16));
+    name[len] = 0;
+    list->name_block_used += units;
+
+    entry->file_name = name;
+    entry->file_name_len = len;
+    return true;
+}
+
+// After entries came or went, the selection stays in range and on screen
+static void keep_selected_in_view(Entry_List_s * list)
+{
+    if(list->selected_entry >= list->entries_count)
+        list->selected_entry = list->entries_count - 1;
+    if(list->selected_entry < 0)
+        list->selected_entry = 0;
+
+    if(list->selected_entry < list->scroll)
+        list->scroll = list->selected_entry;
+    else if(list->selected_entry >= list->scroll + list->entries_loaded)
+        list->scroll = list->selected_entry - list->entries_loaded + 1;
+    if(list->scroll > list->entries_count - list->entries_loaded)
+        list->scroll = list->entries_count - list->entries_loaded;
+    if(list->scroll < 0)
+        list->scroll = 0;
+
+    list->previous_selected = list->selected_entry;
+    list->previous_scroll = list->scroll;
+}
+
+static int compare_sort_keys(const u8 * a, u32 a_len, const u8 * b, u32 b_len)
+{
+    const int diff = memcmp(a, b, min(a_len, b_len));
+    if(diff != 0)
+        return diff;
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+// Where a stable sort puts entry among the first count entries, which are sorted by mode: after those equal to it, since it's the last one loaded
+static int sorted_position(const Entry_List_s * list, const Entry_s * entry, int count, SortMode mode)
+{
+    static u8 key[1 + 0x106 * COLLATION_MAX_BYTES_PER_UNIT];
+    static u8 other_key[1 + 0x106 * COLLATION_MAX_BYTES_PER_UNIT];
+    const u32 key_len = entry_sort_key(key, entry, mode);
+
+    int low = 0, high = count;
+    while(low < high)
+    {
+        const int middle = low + (high - low) / 2;
+        const u32 other_len = entry_sort_key(other_key, list->entries[middle], mode);
+        if(compare_sort_keys(key, key_len, other_key, other_len) < 0)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+// What's left of path after the list's folder, NULL if it isn't in there
+static const u16 * file_name_in_list(const Entry_List_s * list, const u16 * path)
+{
+    if(list->prefix == NULL || memcmp(path, list->prefix->path, list->prefix->len * sizeof(u16)))
+        return NULL;
+    return path + list->prefix->len;
+}
+
+ssize_t list_insert_entry(Entry_List_s * list, const u16 * path, bool is_zip)
+{
+    // a list whose folder couldn't be read has nowhere to put it
+    const u16 * const file_name = file_name_in_list(list, path);
+    if(file_name == NULL)
+        return -1;
+    if(list->entries_capacity == 0)
+        list_init_capacity(list, LOADING_DIR_ENTRIES_COUNT);
+    if(list->entries == NULL)
+        return -1;
+
+    list_clear_search(list);
+    const ssize_t index = new_entry(list, true);
+    if(index < 0)
+        return -1;
+
+    Entry_s * const current_entry = list->entries[index];
+    if(!list_set_file_name(list, current_entry, file_name, strulen(file_name, 0x106 - list->prefix->len)))
+    {
+        list_remove_entry(list, index);
+        return -1;
+    }
+    current_entry->is_zip = is_zip;
+
+    char * buf = NULL;
+    u32 buflen = load_data("/info.smdh", current_entry, &buf);
+    parse_smdh(buflen == sizeof(Icon_s) ? (Icon_s *)buf : NULL, current_entry, current_entry->file_name);
+    free(buf);
+
+    // the order of the current sort can take the new id in where it goes, the rest is made again when needed
+    const SortMode mode = list->current_sort;
+    u32 * order = NULL;
+    if(mode != SORT_NONE)
+    {
+        order = list->sort_orders[mode];
+        list->sort_orders[mode] = NULL;
+    }
+    clear_list_caches(list);
+
+    const int position = mode != SORT_NONE ? sorted_position(list, current_entry, index, mode) : index;
+    if(position != index)
+    {
+        memmove(&list->entries[position + 1], &list->entries[position], (index - position) * sizeof(Entry_s *));
+        list->entries[position] = current_entry;
+    }
+
+    if(order != NULL)
+    {
+        u32 * const new_order = realloc(order, list->entries_count * sizeof(u32));
+        if(new_order != NULL)
         {
-            next_capacity *= 2;
+            memmove(&new_order[position + 1], &new_order[position], (index - position) * sizeof(u32));
+            new_order[position] = list->entries[position]->id;
+            list->sort_orders[mode] = new_order;
         }
         else
         {
-            next_capacity += LIST_CAPACITY_THRESHOLD;
+            free(order);
         }
+    }
 
-        Entry_s * const new_list = realloc(list->entries, next_capacity * sizeof(Entry_s));
-        if(new_list == NULL)
+    if(list->entries_count > 1 && position <= list->selected_entry)
+        list->selected_entry++;
+    keep_selected_in_view(list);
+
+    return position;
+}
+
+void list_remove_entry(Entry_List_s * list, int index)
+{
+    const int count = list->entries_count + list->hidden_count;
+    if(index < 0 || index >= count)
+        return;
+
+    Entry_s * const entry = list->entries[index];
+    const u32 id = entry->id;
+    const u32 last_id = count - 1;
+
+    if(entry->in_shuffle)
+        list->shuffle_count--;
+
+    for(int i = 0; i < ENTRY_DESC_CACHE_SIZE; ++i)
+    {
+        if(list->desc_cache[i].entry == entry)
+            list->desc_cache[i].entry = NULL;
+    }
+
+    drop_icon(list, entry);
+    // desc is at the start of the record
+    if(entry->desc != NULL)
+        pool_give_back(&list->cold_pool, entry->desc);
+    pool_give_back(&list->entry_pool, entry);
+
+    memmove(&list->entries[index], &list->entries[index + 1], (count - index - 1) * sizeof(Entry_s *));
+    // the record went back to the pool, nothing may reach it through the slot left over
+    list->entries[count - 1] = NULL;
+    if(index < list->entries_count)
+        list->entries_count--;
+    else
+        list->hidden_count--;
+
+    // ids have to stay from 0 to the amount of entries, the last one takes the removed one's
+    for(int i = 0; i < count - 1; ++i)
+    {
+        if(list->entries[i]->id == last_id)
         {
-            return -1;
+            list->entries[i]->id = id;
+            break;
         }
+    }
 
-        list->entries = new_list;
-        list->entries_capacity = next_capacity;
+    for(int i = 0; i < SORT_MODES_AMOUNT; ++i)
+    {
+        u32 * const order = list->sort_orders[i];
+        if(order == NULL)
+            continue;
+
+        int kept = 0;
+        for(int j = 0; j < count; ++j)
+        {
+            if(order[j] != id)
+                order[kept++] = order[j] == last_id ? id : order[j];
+        }
     }
 
-    return list->entries_count++;
+    if(list->search_matches != NULL)
+        list->search_matches[id] = list->search_matches[last_id];
+    search_index_free(&list->search_index);
+
+    if(index < list->selected_entry)
+        list->selected_entry--;
+    // the last entry a search or the duplicates showed is gone, an empty list couldn't get the others back
+    if(list->entries_count == 0 && list->hidden_count != 0)
+        list_clear_search(list);
+    keep_selected_in_view(list);
+}
+
+ssize_t list_find_entry(const Entry_List_s * list, const u16 * path)
+{
+    const u16 * const file_name = file_name_in_list(list, path);
+    if(file_name == NULL)
+        return -1;
+
+    const int count = list->entries_count + list->hidden_count;
+    const size_t len = strulen(file_name, 0x106 - list->prefix->len);
+    for(int i = 0; i < count; ++i)
+    {
+        const Entry_s * const entry = list->entries[i];
+        if(entry->file_name_len == len && !memcmp(entry->file_name, file_name, len * sizeof(u16)))
+            return i;
+    }
+    return -1;
+}
+
+void list_free_entries(Entry_List_s * list)
+{
+    clear_list_caches(list);
+    if(list->icons_info != NULL)
+        list_reset_icons(list);
+    if(list->icon_pack != 0)
+        vfs_close(list->icon_pack);
+    pool_free(&list->entry_pool);
+    pool_free(&list->cold_pool);
+    for(int i = 0; i < list->name_blocks_count; ++i)
+        free(list->name_blocks[i]);
+    free(list->name_blocks);
+    free(list->prefix);
+    free(list->entries);
+
+    list->page_cold = false;
+    memset(list->desc_cache, 0, sizeof(list->desc_cache));
+    list->desc_cache_next = 0;
+    list->name_blocks = NULL;
+    list->name_blocks_count = 0;
+    list->name_block_used = 0;
+    list->prefix = NULL;
+    list->icon_pack = 0;
+    list->entries = NULL;
+    list->entries_count = 0;
+    list->entries_capacity = 0;
 }
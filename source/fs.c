@@ -27,14 +27,18 @@
 #include <strings.h>
 
 #include "fs.h"
-#include "draw.h"
+#include "ui_feedback.h"
 #include "unicode.h"
 #include "ui_strings.h"
-#include "remote.h"
+#include "lz.h"
+#include "iostats.h"
+#include "trace.h"
 
 #include <archive.h>
 #include <archive_entry.h>
 
+#define FILE_COPY_CHUNK 0x40000
+
 FS_Archive ArchiveSD;
 FS_Archive ArchiveHomeExt;
 FS_Archive ArchiveThemeExt;
@@ -69,20 +73,23 @@ Result createExtSaveData(u32 extdataID)
 
 Result init_sd(void)
 {
+    TRACE_SPAN("init_sd");
     Result res;
-    if(R_FAILED(res = FSUSER_OpenArchive(&ArchiveSD, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, "")))) return res;
+    if(R_FAILED(res = vfs_open_archive(&ArchiveSD, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, "")))) return res;
+    iostats_name_archive(ArchiveSD, "sd");
     load_config();
 
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds"), FS_ATTRIBUTE_DIRECTORY);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/"  APP_TITLE), FS_ATTRIBUTE_DIRECTORY);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/"  APP_TITLE  "/cache"), FS_ATTRIBUTE_DIRECTORY);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/" APP_TITLE "/BadgeBackups"), FS_ATTRIBUTE_DIRECTORY);
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds"));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/"  APP_TITLE));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/"  APP_TITLE  "/cache"));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, "/3ds/" APP_TITLE "/BadgeBackups"));
 
     return 0;
 }
 
 Result open_archives(void)
 {
+    TRACE_SPAN("open_archives");
     romfsInit();
     u8 regionCode;
     u32 archive1;
@@ -117,31 +124,34 @@ Result open_archives(void)
             archive2 = 0x00;
     }
 
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_THEMES]), FS_ATTRIBUTE_DIRECTORY);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_SPLASHES]), FS_ATTRIBUTE_DIRECTORY);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_BADGES]), FS_ATTRIBUTE_DIRECTORY);
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_THEMES]));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_SPLASHES]));
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, main_paths[REMOTE_MODE_BADGES]));
 
     u32 homeMenuPath[3] = {MEDIATYPE_SD, archive2, 0};
     home.type = PATH_BINARY;
     home.size = 0xC;
     home.data = homeMenuPath;
-    if(R_FAILED(res = FSUSER_OpenArchive(&ArchiveHomeExt, ARCHIVE_EXTDATA, home))) return res;
+    if(R_FAILED(res = vfs_open_archive(&ArchiveHomeExt, ARCHIVE_EXTDATA, home))) return res;
+    iostats_name_archive(ArchiveHomeExt, "home_ext");
 
     u32 themePath[3] = {MEDIATYPE_SD, archive1, 0};
     theme.type = PATH_BINARY;
     theme.size = 0xC;
     theme.data = themePath;
-    if(R_FAILED(res = FSUSER_OpenArchive(&ArchiveThemeExt, ARCHIVE_EXTDATA, theme))) return res;
+    if(R_FAILED(res = vfs_open_archive(&ArchiveThemeExt, ARCHIVE_EXTDATA, theme))) return res;
+    iostats_name_archive(ArchiveThemeExt, "theme_ext");
 
     Handle test_handle;
-    if(R_FAILED(res = FSUSER_OpenFile(&test_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, "/ThemeManage.bin"), FS_OPEN_READ, 0))) return res;
-    FSFILE_Close(test_handle);
+    if(R_FAILED(res = vfs_open_file(&test_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, "/ThemeManage.bin"), FS_OPEN_READ))) return res;
+    vfs_close(test_handle);
 
     return 0;
 }
 
 Result open_badge_extdata()
 {
+    TRACE_SPAN("open_badge_extdata");
     Handle test_handle;
     FS_Path badge;
 
@@ -152,33 +162,34 @@ Result open_badge_extdata()
     badge.size = 0xC;
 
     badge.data = badgePath;
-    if(R_FAILED(res = FSUSER_OpenArchive(&ArchiveBadgeExt, ARCHIVE_EXTDATA, badge)))
+    if(R_FAILED(res = vfs_open_archive(&ArchiveBadgeExt, ARCHIVE_EXTDATA, badge)))
     {
         if (R_SUMMARY(res) == RS_NOTFOUND) 
         {
             DEBUG("Extdata not found - creating\n");
             createExtSaveData(0x000014d1);
-            FSUSER_OpenArchive(&ArchiveBadgeExt, ARCHIVE_EXTDATA, badge);
+            vfs_open_archive(&ArchiveBadgeExt, ARCHIVE_EXTDATA, badge);
         } else
         {
             DEBUG("Unknown extdata error\n");
             return res;
         }
     }
+    iostats_name_archive(ArchiveBadgeExt, "badge_ext");
 
-    if (R_FAILED(res = FSUSER_OpenFile(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ, 0)))
+    if (R_FAILED(res = vfs_open_file(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_READ)))
     {
         if (R_SUMMARY(res) == RS_NOTFOUND)
         {
-            FSUSER_CreateFile(ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), 0, BADGE_DATA_SIZE);
-            FSUSER_OpenFile(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_WRITE, 0);
-            FSFILE_Flush(test_handle);
+            vfs_create_file(ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), BADGE_DATA_SIZE);
+            vfs_open_file(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeData.dat"), FS_OPEN_WRITE);
+            vfs_flush(test_handle);
         }
         DEBUG("Error 0x%08ld opening BadgeData.dat, retrying\n", res);
     }
-    FSFILE_Close(test_handle);
+    vfs_close(test_handle);
 
-    if(R_FAILED(res = FSUSER_OpenFile(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), FS_OPEN_READ, 0)))
+    if(R_FAILED(res = vfs_open_file(&test_handle, ArchiveBadgeExt, fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), FS_OPEN_READ)))
     {
         DEBUG("Error 0x%08ld opening BadgeMngFile.dat, retrying\n", res);
         if (R_SUMMARY(res) == RS_NOTFOUND)
@@ -186,14 +197,14 @@ Result open_badge_extdata()
             remake_file(fsMakePath(PATH_ASCII, "/BadgeMngFile.dat"), ArchiveBadgeExt, BADGE_MNG_SIZE);
         }
     }
-    FSFILE_Close(test_handle);
+    vfs_close(test_handle);
 
     char tp_path[0x106] = {0};
     sprintf(tp_path, "%sThemePlaza Badges", main_paths[REMOTE_MODE_BADGES]);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, tp_path), FS_ATTRIBUTE_DIRECTORY);
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, tp_path));
     strcat(tp_path, "/_seticon.png");
 
-    if(R_FAILED(res = FSUSER_OpenFile(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, tp_path), FS_OPEN_READ, 0)))
+    if(R_FAILED(res = vfs_open_file(&test_handle, ArchiveSD, fsMakePath(PATH_ASCII, tp_path), FS_OPEN_READ)))
     {
         FILE *fp = fopen("romfs:/tp_set.png", "rb");
         fseek(fp, 0L, SEEK_END);
@@ -202,8 +213,7 @@ Result open_badge_extdata()
         fseek(fp, 0L, SEEK_SET);
         fread(icon_buf, 1, size, fp);
         fclose(fp);
-        remake_file(fsMakePath(PATH_ASCII, tp_path), ArchiveSD, size);
-        buf_to_file(size, fsMakePath(PATH_ASCII, tp_path), ArchiveSD, icon_buf);
+        rewrite_file(fsMakePath(PATH_ASCII, tp_path), ArchiveSD, size, icon_buf, size);
         DEBUG("res: 0x%08lx\n", res);
         free(icon_buf);
     }
@@ -215,10 +225,10 @@ Result close_archives(void)
 {
     Result res;
 
-    if(R_FAILED(res = FSUSER_CloseArchive(ArchiveSD))) return res;
-    if(R_FAILED(res = FSUSER_CloseArchive(ArchiveHomeExt))) return res;
-    if(R_FAILED(res = FSUSER_CloseArchive(ArchiveThemeExt))) return res;
-    if(R_FAILED(res = FSUSER_CloseArchive(ArchiveBadgeExt))) return res;
+    if(R_FAILED(res = vfs_close_archive(ArchiveSD))) return res;
+    if(R_FAILED(res = vfs_close_archive(ArchiveHomeExt))) return res;
+    if(R_FAILED(res = vfs_close_archive(ArchiveThemeExt))) return res;
+    if(R_FAILED(res = vfs_close_archive(ArchiveBadgeExt))) return res;
 
     return 0;
 }
@@ -236,16 +246,17 @@ Result load_parental_controls(Parental_Restrictions_s *restrictions)
 
 u32 file_to_buf(FS_Path path, FS_Archive archive, char ** buf)
 {
+    IOSTATS_SITE("file_to_buf");
     Handle file;
     Result res = 0;
-    if (R_FAILED(res = FSUSER_OpenFile(&file, archive, path, FS_OPEN_READ, 0)))
+    if (R_FAILED(res = vfs_open_file(&file, archive, path, FS_OPEN_READ)))
     {
         DEBUG("file_to_buf failed - 0x%08lx\n", res);
         return 0;
     }
 
     u64 size;
-    FSFILE_GetSize(file, &size);
+    vfs_get_size(file, &size);
     if(size != 0)
     {
         *buf = calloc(1, size);
@@ -254,9 +265,75 @@ u32 file_to_buf(FS_Path path, FS_Archive archive, char ** buf)
             DEBUG("Error allocating buffer - out of memory??\n");
             return 0;
         }
-        FSFILE_Read(file, NULL, 0, *buf, size);
+        vfs_read(file, NULL, 0, *buf, size);
+    }
+    vfs_close(file);
+    return (u32)size;
+}
+
+// Reads the file straight into buf when it's at most max_size bytes.
+// Returns the size of the file either way, 0 if it couldn't be read
+u32 file_to_given_buf(FS_Path path, FS_Archive archive, char * buf, u32 max_size)
+{
+    IOSTATS_SITE("file_to_given_buf");
+    Handle file;
+    Result res = 0;
+    if (R_FAILED(res = vfs_open_file(&file, archive, path, FS_OPEN_READ)))
+    {
+        DEBUG("file_to_given_buf failed - 0x%08lx\n", res);
+        return 0;
+    }
+
+    u64 size = 0;
+    vfs_get_size(file, &size);
+    if(size != 0 && size <= max_size && R_FAILED(vfs_read(file, NULL, 0, buf, size)))
+        size = 0;
+    vfs_close(file);
+    return (u32)size;
+}
+
+// Copies the file to dest at dest_offset in big chunks when it's at most max_size bytes.
+// Returns the size of the file either way, 0 if it couldn't be read or written
+u32 file_to_handle(FS_Path path, FS_Archive archive, Handle dest, u64 dest_offset, u32 max_size)
+{
+    IOSTATS_SITE("file_to_handle");
+    Handle file;
+    Result res = 0;
+    if (R_FAILED(res = vfs_open_file(&file, archive, path, FS_OPEN_READ)))
+    {
+        DEBUG("file_to_handle failed - 0x%08lx\n", res);
+        return 0;
+    }
+
+    u64 size = 0;
+    vfs_get_size(file, &size);
+    if(size != 0 && size <= max_size)
+    {
+        char * chunk = malloc(FILE_COPY_CHUNK);
+        if(chunk == NULL)
+        {
+            DEBUG("Error allocating buffer - out of memory??\n");
+            size = 0;
+        }
+
+        for(u32 copied = 0; chunk != NULL && copied < size;)
+        {
+            const u32 len = min(size - copied, FILE_COPY_CHUNK);
+            if(R_FAILED(vfs_read(file, NULL, copied, chunk, len)))
+            {
+                size = 0;
+                break;
+            }
+            copied += len;
+            if(R_FAILED(vfs_write(dest, NULL, dest_offset + copied - len, chunk, len, copied == size ? FS_WRITE_FLUSH : 0)))
+            {
+                size = 0;
+                break;
+            }
+        }
+        free(chunk);
     }
-    FSFILE_Close(file);
+    vfs_close(file);
     return (u32)size;
 }
 
@@ -339,8 +416,25 @@ u32 zip_memory_to_buf(const char * file_name, void * zip_memory, size_t zip_size
     return zip_to_buf(a, file_name, buf);
 }
 
-u32 zip_file_to_buf(const char * file_name, const u16 * zip_path, char ** buf)
+// zip is the already read central directory of the file at zip_path, or NULL if that couldn't be done
+u32 zip_opened_file_to_buf(const Zip_s * zip, const char * file_name, const u16 * zip_path, char ** buf)
 {
+    IOSTATS_SITE("zip_opened_file_to_buf");
+    // go straight to the member through the central directory when possible,
+    // libarchive has to go through every entry before it
+    if(zip != NULL)
+    {
+        const Zip_Entry_s * entry = zip_find(zip, file_name);
+        if(entry == NULL)
+        {
+            DEBUG("Couldn't find file in zip\n");
+            return 0;
+        }
+
+        if(zip_entry_supported(entry))
+            return zip_read(zip, entry, buf);
+    }
+
     ssize_t len = strulen(zip_path, 0x106);
     char * path = calloc(len, sizeof(u16));
     utf16_to_utf8((u8 *)path, zip_path, len * sizeof(u16));
@@ -362,193 +456,272 @@ u32 zip_file_to_buf(const char * file_name, const u16 * zip_path, char ** buf)
     return zip_to_buf(a, file_name, buf);
 }
 
+// Same as zip_opened_file_to_buf, but reads into buf when the file is at most max_size bytes.
+// Returns the size of the file either way, 0 if it couldn't be read
+u32 zip_opened_file_to_given_buf(const Zip_s * zip, const char * file_name, const u16 * zip_path, char * buf, u32 max_size)
+{
+    IOSTATS_SITE("zip_opened_file_to_given_buf");
+    const Zip_Entry_s * entry = zip != NULL ? zip_find(zip, file_name) : NULL;
+    if(entry != NULL && zip_entry_supported(entry))
+    {
+        if(entry->size > max_size)
+            return entry->size;
+        return zip_read_into(zip, entry, (u8 *)buf) ? entry->size : 0;
+    }
+    else if(zip != NULL && entry == NULL)
+    {
+        DEBUG("Couldn't find file in zip\n");
+        return 0;
+    }
+
+    char * file_buf = NULL;
+    u32 size = zip_opened_file_to_buf(zip, file_name, zip_path, &file_buf);
+    if(size <= max_size)
+        memcpy(buf, file_buf, size);
+    free(file_buf);
+    return size;
+}
+
+// Same as zip_opened_file_to_buf, but writes the file to dest at dest_offset in chunks when it's at most max_size bytes.
+// Returns the size of the file either way, 0 if it couldn't be read or written
+u32 zip_opened_file_to_handle(const Zip_s * zip, const char * file_name, const u16 * zip_path, Handle dest, u64 dest_offset, u32 max_size)
+{
+    IOSTATS_SITE("zip_opened_file_to_handle");
+    const Zip_Entry_s * entry = zip != NULL ? zip_find(zip, file_name) : NULL;
+    if(entry != NULL && zip_entry_supported(entry))
+    {
+        if(entry->size > max_size)
+            return entry->size;
+        return zip_copy_to_file(zip, entry, dest, dest_offset) ? entry->size : 0;
+    }
+    else if(zip != NULL && entry == NULL)
+    {
+        DEBUG("Couldn't find file in zip\n");
+        return 0;
+    }
+
+    char * file_buf = NULL;
+    u32 size = zip_opened_file_to_buf(zip, file_name, zip_path, &file_buf);
+    if(size != 0 && size <= max_size && R_FAILED(vfs_write(dest, NULL, dest_offset, file_buf, size, FS_WRITE_FLUSH)))
+        size = 0;
+    free(file_buf);
+    return size;
+}
+
+u32 zip_file_to_buf(const char * file_name, const u16 * zip_path, char ** buf)
+{
+    IOSTATS_SITE("zip_file_to_buf");
+    Zip_s zip;
+    if(R_FAILED(zip_open(&zip, ArchiveSD, fsMakePath(PATH_UTF16, zip_path))))
+        return zip_opened_file_to_buf(NULL, file_name, zip_path, buf);
+
+    u32 size = zip_opened_file_to_buf(&zip, file_name, zip_path, buf);
+    zip_close(&zip);
+    return size;
+}
+
 Result buf_to_file(u32 size, FS_Path path, FS_Archive archive, char * buf)
 {
+    IOSTATS_SITE("buf_to_file");
     Handle handle;
     Result res = 0;
-    if (R_FAILED(res = FSUSER_OpenFile(&handle, archive, path, FS_OPEN_WRITE, 0))) return res;
-    if (R_FAILED(res = FSFILE_Write(handle, NULL, 0, buf, size, FS_WRITE_FLUSH))) return res;
-    if (R_FAILED(res = FSFILE_Close(handle))) return res;
+    if (R_FAILED(res = vfs_open_file(&handle, archive, path, FS_OPEN_WRITE))) return res;
+    if (R_FAILED(res = vfs_write(handle, NULL, 0, buf, size, FS_WRITE_FLUSH))) return res;
+    if (R_FAILED(res = vfs_close(handle))) return res;
     return 0;
 }
 
 u32 decompress_lz_file(FS_Path file_name, FS_Archive archive, char ** buf)
 {
+    IOSTATS_SITE("decompress_lz_file");
     Handle handle;
     Result res = 0;
-    if (R_FAILED(res = FSUSER_OpenFile(&handle, archive, file_name, FS_OPEN_READ, 0))) {
+    if (R_FAILED(res = vfs_open_file(&handle, archive, file_name, FS_OPEN_READ))) {
         DEBUG("%lu\n", res);
         return 0;
     }
-    u64 size;
-    FSFILE_GetSize(handle, &size);
 
-    char * temp_buf = NULL;
-
-    if(size != 0)
+    u8 header[LZ11_HEADER_SIZE] = {0};
+    u32 read = 0;
+    vfs_read(handle, &read, 0, header, LZ11_HEADER_SIZE);
+    u32 output_size = read == LZ11_HEADER_SIZE ? lz11_decompressed_size(header) : 0;
+    if (output_size == 0)
     {
-        temp_buf = calloc(1, size);
-        FSFILE_Read(handle, NULL, 0, temp_buf, size);
+        vfs_close(handle);
+        return 0;
     }
-    FSFILE_Close(handle);
 
-    if (temp_buf[0] != 0x11) {
-        free(temp_buf);
+    // the compressed data is streamed in, only the output needs to fit in memory
+    *buf = malloc(output_size);
+    if (*buf == NULL)
+    {
+        DEBUG("Error allocating buffer - out of memory??\n");
+        vfs_close(handle);
         return 0;
     }
 
-    u32 output_size = temp_buf[1] | ((temp_buf[2] << 8) & 0xFF00) | ((temp_buf[3] << 16) & 0xFF0000);
-    printf("%ld\n", output_size);
+    u32 cur_written = lz11_decompress_file(handle, (u8 *)*buf, output_size);
+    vfs_close(handle);
 
+    if (cur_written != output_size)
+    {
+        free(*buf);
+        *buf = NULL;
+        return 0;
+    }
 
-    *buf = calloc(1, output_size);
+    return cur_written;
+}
 
-    u32 pos = 4;
-    u32 cur_written = 0;
-    u8 counter = 0;
-    u8 mask = 0;
+typedef struct {
+    u32 offset;
+    u32 passed;
+    u8 value;
+    bool found;
+} Lz_Byte_s;
 
-    while (cur_written < output_size)
+static bool take_lz_byte(void * userdata, const u8 * data, u32 size)
+{
+    Lz_Byte_s * byte = (Lz_Byte_s *)userdata;
+    if (byte->offset - byte->passed < size)
     {
-        if (counter == 0) // read mask
-        {
-            mask = temp_buf[pos++];
-            counter++;
-            continue;
-        }
-
-        if ((mask >> (8 - counter)) & 0x01) // compressed block
-        {
-            int len = 0;
-            int disp = 0;
-            switch (temp_buf[pos] >> 4)
-            {
-                case 0:
-                    len  = temp_buf[pos++] << 4;
-                    len |= temp_buf[pos] >> 4;
-                    len += 0x11;
-                    break;
-
-                case 1:
-                    len  = (temp_buf[pos++] & 0x0F) << 12;
-                    len |=  temp_buf[pos++] << 4;
-                    len |=  temp_buf[pos] >> 4;
-                    len += 0x111;
-                    break;
-
-                default:
-                    len  = (temp_buf[pos] >> 4) + 1;
-            }
+        byte->value = data[byte->offset - byte->passed];
+        byte->found = true;
+        return false;
+    }
 
-            disp  = (temp_buf[pos++] & 0x0F) << 8;
-            disp |=  temp_buf[pos++];
+    byte->passed += size;
+    return true;
+}
 
-            for (int i = 0; i < len; ++i)
-            {
-                *(*buf + cur_written + i) = *(*buf + cur_written - disp - 1 + i);
-            }
+// Reads the decompressed byte at offset, only decompressing the file up to the piece it's in
+bool read_lz_file_byte(FS_Path path, FS_Archive archive, u32 offset, u8 * value)
+{
+    IOSTATS_SITE("read_lz_file_byte");
+    Handle handle;
+    Result res = 0;
+    if (R_FAILED(res = vfs_open_file(&handle, archive, path, FS_OPEN_READ))) {
+        DEBUG("%lu\n", res);
+        return false;
+    }
 
-            cur_written += len;
-        }
-        else // byte literal
-        {
-            *(*buf + cur_written) = temp_buf[pos++];
-            cur_written++;
-        }
+    Lz_Byte_s byte = {.offset = offset};
+    lz11_decompress_file_stream(handle, take_lz_byte, &byte);
+    vfs_close(handle);
 
-        if (++counter > 8) counter = 0;
+    *value = byte.value;
+    return byte.found;
+}
 
+u32 patch_lz_file(FS_Path path, FS_Archive archive, u32 compressed_size, u32 offset, u8 value)
+{
+    IOSTATS_SITE("patch_lz_file");
+    Handle handle;
+    Result res = 0;
+    if (R_FAILED(res = vfs_open_file(&handle, archive, path, FS_OPEN_READ | FS_OPEN_WRITE))) {
+        DEBUG("%lu\n", res);
+        return 0;
     }
 
+    u32 new_size = lz11_patch_file(handle, compressed_size, offset, value);
+    vfs_close(handle);
 
-    free(temp_buf);
-
-    return cur_written;
+    return new_size;
 }
 
-// This is an awful algorithm to "compress" LZ11 data.
-// We do this instead of actual LZ11 compression because of time -
-// LZ11 requires a lot of mem searching which is painfully slow on 3DS.
-// This process is nearly instant but means the resulting file is actually larger
-// than the input file. I don't think this is a problem as the only file we compress like this
-// is the theme data installed to extdata in some rare cases, which means only 1 file at most
-// is ever compressed like this. I don't think 400 KB is that big a sacrifice for probably
-// half a minute or so of time save - I may change my mind on this in the future, especially
-// if i figure out a dynamic programming algorithm which ends up being significantly
-// faster. Otherwise, I think this is probably a fine implementation.
-
-u32 compress_lz_file_fast(FS_Path path, FS_Archive archive, char * in_buf, u32 size)
+u32 compress_lz_file(FS_Path path, FS_Archive archive, char * in_buf, u32 size)
 {
-    char * output_buf = calloc(1, size * 2);
-    u32 output_size = 0;
-    u32 mask_pos = 0;
-    u32 bytes_processed = 0;
-    u8 counter = 0;
-
+    IOSTATS_SITE("compress_lz_file");
+    char * output_buf = malloc(lz11_compress_bound(size));
     if (output_buf == NULL) return 0;
 
-    // Set header data for the LZ11 file - 0x11 is version (LZ11), next 3 bytes are size
-    output_buf[0] = 0x11;
-    output_buf[3] = (size & 0xFF0000) >> 16;
-    output_buf[2] = (size & 0xFF00) >> 8;
-    output_buf[1] = (size & 0xFF);
+    u32 output_size = lz11_compress((u8 *)in_buf, size, (u8 *)output_buf, LZ11_LEVEL_DEFAULT);
+    if (output_size != 0)
+        buf_to_file(output_size, path, archive, output_buf);
+    free(output_buf);
 
-    output_size += 4;
+    return output_size;
+}
 
-    while (bytes_processed < size)
+// Deletes the file if it's there and creates it with size bytes. Nothing is written to it,
+// so only use this when all of it gets written right after
+Result create_file_sized(FS_Path path, FS_Archive archive, u32 size)
+{
+    IOSTATS_SITE("create_file_sized");
+    Result res = vfs_create_file(archive, path, size);
+    if (R_FAILED(res))
     {
-        if (counter == 0)
-        {
-            mask_pos = output_size++;
-            output_buf[mask_pos] = 0;
-        }
+        vfs_delete_file(archive, path);
+        res = vfs_create_file(archive, path, size);
+    }
+    return res;
+}
 
-        output_buf[output_size++] = in_buf[bytes_processed++];
+// Truncate and write: recreates the file with file_size bytes, writes the first size bytes
+// from buf and zeroes the rest, so every byte of the file is written once
+Result rewrite_file(FS_Path path, FS_Archive archive, u32 file_size, const char * buf, u32 size)
+{
+    IOSTATS_SITE("rewrite_file");
+    Result res = 0;
+    if (R_FAILED(res = create_file_sized(path, archive, file_size))) return res;
 
-        if (++counter == 8) counter = 0;
-    }
+    Handle handle;
+    if (R_FAILED(res = vfs_open_file(&handle, archive, path, FS_OPEN_WRITE))) return res;
 
-    buf_to_file(output_size, path, archive, output_buf);
-    free(output_buf);
+    if (size > file_size) size = file_size;
+    if (size != 0)
+        res = vfs_write(handle, NULL, 0, buf, size, size == file_size ? FS_WRITE_FLUSH : 0);
+    if (R_SUCCEEDED(res) && size < file_size)
+    {
+        res = zero_handle_range(handle, size, file_size - size);
+        if (R_SUCCEEDED(res))
+            res = vfs_flush(handle);
+    }
 
-    return output_size;
+    vfs_close(handle);
+    return res;
 }
 
+// Recreates the file with size zeroed bytes
 void remake_file(FS_Path path, FS_Archive archive, u32 size)
 {
-    Handle handle;
-    if (R_SUCCEEDED(FSUSER_OpenFile(&handle, archive, path, FS_OPEN_READ, 0)))
+    IOSTATS_SITE("remake_file");
+    Result res = rewrite_file(path, archive, size, NULL, 0);
+    DEBUG("Remake file res: 0x%08lx\n", res);
+}
+
+Result zero_handle_range(Handle handle, u64 offset, u64 size)
+{
+    IOSTATS_SITE("zero_handle_range");
+    if (size == 0) return 0;
+
+    const u32 chunk_size = size < FILE_COPY_CHUNK ? size : FILE_COPY_CHUNK;
+    char * zero_buf = calloc(1, chunk_size);
+    if (zero_buf == NULL)
     {
-        FSFILE_Close(handle);
-        FSUSER_DeleteFile(archive, path);
+        DEBUG("Error allocating buffer - out of memory??\n");
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
     }
-    Result res = FSUSER_CreateFile(archive, path, 0, size);
-    DEBUG("Remake file res: 0x%08lx\n", res);
-    char * buf = calloc(size, 1);
-    if (buf == NULL)
+
+    Result res = 0;
+    while (size > 0 && R_SUCCEEDED(res))
     {
-        DEBUG("out of memory - not overwriting file?\n");
-    } else {
-        buf_to_file(size, path, archive, buf);
-        free(buf);
+        const u32 len = size < chunk_size ? size : chunk_size;
+        res = vfs_write(handle, NULL, offset, zero_buf, len, 0);
+        offset += len;
+        size -= len;
     }
+
+    free(zero_buf);
+    return res;
 }
 
 Result zero_handle_memeasy(Handle handle)
 {
+    IOSTATS_SITE("zero_handle_memeasy");
     u64 size = 0;
-    u64 cur = 0;
-    FSFILE_GetSize(handle, &size);
-    char *zero_buf = calloc(1, 0x10000);
-    while (size > 0x10000)
-    {
-        FSFILE_Write(handle, NULL, cur, &zero_buf, 0x10000, 0);
-        cur += 0x10000;
-        size -= 0x10000;
-    }
-    FSFILE_Write(handle, NULL, cur, &zero_buf, size, 0);
-    free(zero_buf);
-    return 0;
+    vfs_get_size(handle, &size);
+    return zero_handle_range(handle, 0, size);
 }
 
 static SwkbdCallbackResult fat32filter(void * user, const char ** ppMessage, const char * text, size_t textlen)
@@ -619,7 +792,7 @@ renamed:
 
     // check if file already exists, and if it does, prompt the user
     // to overwrite or change name (or exit)
-    Result res = FSUSER_CreateFile(ArchiveSD, path, 0, size);
+    Result res = vfs_create_file(ArchiveSD, path, size);
     if (R_FAILED(res))
     {
         if (res == (long)0xC82044BE)
@@ -673,6 +846,42 @@ renamed:
     }
 
     DEBUG("Saving to SD: %s\n", path_to_file);
-    remake_file(path, ArchiveSD, size);
-    buf_to_file(size, path, ArchiveSD, buf);
+    if(R_SUCCEEDED(rewrite_file(path, ArchiveSD, size, buf, size)))
+        note_saved_entry(mode, utf16path, true);
+}
+
+static Saved_Entry_s * saved_entries = NULL;
+static int saved_entries_count = 0;
+static bool saved_entries_lost = false;
+
+void note_saved_entry(RemoteMode mode, const u16 * path, bool is_zip)
+{
+    // badges don't have a list
+    if(mode == REMOTE_MODE_BADGES)
+        return;
+
+    Saved_Entry_s * const new_entries = realloc(saved_entries, (saved_entries_count + 1) * sizeof(Saved_Entry_s));
+    if(new_entries == NULL)
+    {
+        saved_entries_lost = true;
+        return;
+    }
+    saved_entries = new_entries;
+
+    Saved_Entry_s * const saved = &saved_entries[saved_entries_count++];
+    memset(saved, 0, sizeof(Saved_Entry_s));
+    saved->mode = mode;
+    saved->is_zip = is_zip;
+    memcpy(saved->path, path, strulen(path, 0x105) * sizeof(u16));
+}
+
+bool take_saved_entries(Saved_Entry_s ** entries, int * count)
+{
+    const bool complete = !saved_entries_lost;
+    *entries = saved_entries;
+    *count = saved_entries_count;
+    saved_entries = NULL;
+    saved_entries_count = 0;
+    saved_entries_lost = false;
+    return complete;
 }
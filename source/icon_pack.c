@@ -0,0 +1,130 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "icon_pack.h"
+#include "fs.h"
+#include "cache.h"
+#include "vfs.h"
+#include "trace.h"
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 icons_count;
+    u32 id;
+} Icon_Pack_Header_s;
+
+static u64 icon_offset(u32 position)
+{
+    return sizeof(Icon_Pack_Header_s) + (u64)position * ICON_PACK_ICON_SIZE;
+}
+
+void icon_pack_open(Icon_Pack_s * pack, const char * loading_path, u32 id, u32 entries_count)
+{
+    TRACE_SPAN("icon_pack_open");
+    memset(pack, 0, sizeof(Icon_Pack_s));
+    LightLock_Init(&pack->lock);
+
+    char pack_path[CACHE_PATH_SIZE];
+    cache_file_path(pack_path, "icons", loading_path);
+    if(R_FAILED(vfs_open_file(&pack->file, ArchiveSD, fsMakePath(PATH_ASCII, pack_path), FS_OPEN_READ | FS_OPEN_WRITE | FS_OPEN_CREATE)))
+    {
+        DEBUG("Failed to open icon pack %s\n", pack_path);
+        pack->file = 0;
+        return;
+    }
+    write_batch_begin(&pack->batch, pack->file);
+
+    Icon_Pack_Header_s header;
+    u32 read = 0;
+    u64 size = 0;
+    if(id != 0 && R_SUCCEEDED(vfs_read(pack->file, &read, 0, &header, sizeof(header))) && read == sizeof(header)
+        && header.magic == ICON_PACK_MAGIC && header.version == ICON_PACK_VERSION && header.id == id
+        && R_SUCCEEDED(vfs_get_size(pack->file, &size)) && size >= icon_offset(header.icons_count)
+        && header.icons_count <= entries_count * 2 + ICON_PACK_SLACK)
+    {
+        pack->id = id;
+        pack->icons_count = header.icons_count;
+        return;
+    }
+
+    // the icons of the entries still there are packed again as they're read
+    DEBUG("Starting over icon pack %s\n", pack_path);
+    pack->id = (u32)svcGetSystemTick() | 1;
+    pack->changed = true;
+    vfs_set_size(pack->file, sizeof(Icon_Pack_Header_s));
+}
+
+u32 icon_pack_reserve(Icon_Pack_s * pack, u32 count)
+{
+    const u32 first = pack->icons_count;
+    pack->icons_count += count;
+    if(count != 0)
+        pack->changed = true;
+    return first;
+}
+
+void icon_pack_write(Icon_Pack_s * pack, u32 position, const u16 * icon)
+{
+    LightLock_Lock(&pack->lock);
+    write_batch_write(&pack->batch, icon_offset(position), icon, ICON_PACK_ICON_SIZE);
+    LightLock_Unlock(&pack->lock);
+}
+
+Result icon_pack_commit(Icon_Pack_s * pack)
+{
+    if(pack->file == 0)
+        return 0;
+    if(!pack->changed)
+    {
+        write_batch_abort(&pack->batch);
+        return 0;
+    }
+
+    TRACE_SPAN("icon_pack_commit");
+    const Icon_Pack_Header_s header = {
+        .magic = ICON_PACK_MAGIC,
+        .version = ICON_PACK_VERSION,
+        .icons_count = pack->icons_count,
+        .id = pack->id,
+    };
+    // places of entries without an icon aren't written, the file still has to cover them
+    vfs_set_size(pack->file, icon_offset(pack->icons_count));
+    write_batch_write(&pack->batch, 0, &header, sizeof(header));
+    const Result res = write_batch_commit(&pack->batch);
+    if(R_FAILED(res))
+        DEBUG("Failed to write icon pack: 0x%08lx\n", res);
+    pack->changed = false;
+    return res;
+}
+
+u32 icon_pack_read(Handle file, u32 position, u32 count, u16 * buf)
+{
+    u32 read = 0;
+    if(R_FAILED(vfs_read(file, &read, icon_offset(position), buf, count * ICON_PACK_ICON_SIZE)))
+        return 0;
+    return read / ICON_PACK_ICON_SIZE;
+}
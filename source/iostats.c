@@ -0,0 +1,355 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "iostats.h"
+
+#ifdef IOSTATS
+
+#include <jansson.h>
+
+#include "fs.h"
+
+#ifdef __3DS__
+#define IOSTATS_TICKS_PER_US (SYSCLOCK_ARM11 / 1000000)
+typedef LightLock IoStats_Lock;
+#define iostats_lock_init(lock) LightLock_Init(lock)
+#define iostats_lock(lock) LightLock_Lock(lock)
+#define iostats_unlock(lock) LightLock_Unlock(lock)
+#else
+#include <pthread.h>
+#include <time.h>
+#define IOSTATS_TICKS_PER_US 1000
+typedef pthread_mutex_t IoStats_Lock;
+#define iostats_lock_init(lock) pthread_mutex_init(lock, NULL)
+#define iostats_lock(lock) pthread_mutex_lock(lock)
+#define iostats_unlock(lock) pthread_mutex_unlock(lock)
+#endif
+
+#define IOSTATS_MAX_RECORDS 128
+#define IOSTATS_MAX_HANDLES 32
+#define IOSTATS_MAX_ARCHIVES 8
+#define IOSTATS_BUCKETS 8
+
+// upper bounds of the latency buckets in microseconds, the last one takes the rest
+static const u32 bucket_bounds_us[IOSTATS_BUCKETS - 1] = {16, 64, 256, 1024, 4096, 16384, 65536};
+
+static const char * const op_names[IOSTATS_OP_AMOUNT] = {
+    "open",
+    "read",
+    "write",
+    "create",
+    "delete",
+    "read_dir",
+};
+
+typedef struct {
+    const char * phase;
+    const char * site;
+    FS_Archive archive;
+    IoStats_Op op;
+    u32 count;
+    u64 bytes;
+    u64 ticks;
+    u64 max_ticks;
+    u32 buckets[IOSTATS_BUCKETS];
+} IoStats_Record_s;
+
+typedef struct {
+    Handle handle;
+    FS_Archive archive;
+} IoStats_Handle_s;
+
+typedef struct {
+    FS_Archive archive;
+    const char * name;
+} IoStats_Archive_s;
+
+static IoStats_Record_s records[IOSTATS_MAX_RECORDS];
+static u32 records_count;
+static u32 dropped;
+static IoStats_Handle_s handles[IOSTATS_MAX_HANDLES];
+static IoStats_Archive_s archives[IOSTATS_MAX_ARCHIVES];
+static bool reporting;
+
+static IoStats_Lock lock;
+static bool lock_ready;
+
+static __thread const char * current_phase;
+static __thread const char * current_site;
+
+static void ensure_lock(void)
+{
+    // the first I/O happens from the main thread, before any worker is started
+    if(!lock_ready)
+    {
+        iostats_lock_init(&lock);
+        lock_ready = true;
+    }
+}
+
+const char * iostats_enter_phase(const char * phase)
+{
+    const char * previous = current_phase;
+    current_phase = phase;
+    return previous;
+}
+
+void iostats_leave_phase(const char ** previous)
+{
+    current_phase = *previous;
+}
+
+// the outermost site wins, helpers calling each other count as the one the caller used
+const char * iostats_enter_site(const char * site)
+{
+    const char * previous = current_site;
+    if(previous == NULL)
+        current_site = site;
+    return previous;
+}
+
+void iostats_leave_site(const char ** previous)
+{
+    current_site = *previous;
+}
+
+void iostats_name_archive(FS_Archive archive, const char * name)
+{
+    ensure_lock();
+    iostats_lock(&lock);
+    for(u32 i = 0; i < IOSTATS_MAX_ARCHIVES; ++i)
+    {
+        if(archives[i].name == NULL || archives[i].archive == archive)
+        {
+            archives[i].archive = archive;
+            archives[i].name = name;
+            break;
+        }
+    }
+    iostats_unlock(&lock);
+}
+
+void iostats_track_handle(Handle handle, FS_Archive archive)
+{
+    ensure_lock();
+    iostats_lock(&lock);
+    for(u32 i = 0; i < IOSTATS_MAX_HANDLES; ++i)
+    {
+        if(handles[i].handle == 0)
+        {
+            handles[i].handle = handle;
+            handles[i].archive = archive;
+            break;
+        }
+    }
+    iostats_unlock(&lock);
+}
+
+void iostats_untrack_handle(Handle handle)
+{
+    ensure_lock();
+    iostats_lock(&lock);
+    for(u32 i = 0; i < IOSTATS_MAX_HANDLES; ++i)
+    {
+        if(handles[i].handle == handle)
+        {
+            handles[i].handle = 0;
+            break;
+        }
+    }
+    iostats_unlock(&lock);
+}
+
+u64 iostats_now(void)
+{
+#ifdef __3DS__
+    return svcGetSystemTick();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static void record_locked(IoStats_Op op, FS_Archive archive, u32 bytes, u64 ticks)
+{
+    const char * const site = current_site != NULL ? current_site : "direct";
+    IoStats_Record_s * record = NULL;
+    for(u32 i = 0; i < records_count; ++i)
+    {
+        IoStats_Record_s * const current = &records[i];
+        if(current->op == op && current->archive == archive && current->site == site && current->phase == current_phase)
+        {
+            record = current;
+            break;
+        }
+    }
+
+    if(record == NULL)
+    {
+        if(records_count == IOSTATS_MAX_RECORDS)
+        {
+            dropped++;
+            return;
+        }
+
+        record = &records[records_count++];
+        memset(record, 0, sizeof(IoStats_Record_s));
+        record->phase = current_phase;
+        record->site = site;
+        record->archive = archive;
+        record->op = op;
+    }
+
+    const u64 us = ticks / IOSTATS_TICKS_PER_US;
+    u32 bucket = 0;
+    while(bucket < IOSTATS_BUCKETS - 1 && us >= bucket_bounds_us[bucket])
+        bucket++;
+
+    record->count++;
+    record->bytes += bytes;
+    record->ticks += ticks;
+    if(ticks > record->max_ticks)
+        record->max_ticks = ticks;
+    record->buckets[bucket]++;
+}
+
+void iostats_record(IoStats_Op op, FS_Archive archive, u32 bytes, u64 start)
+{
+    const u64 ticks = iostats_now() - start;
+    ensure_lock();
+    iostats_lock(&lock);
+    if(!reporting)
+        record_locked(op, archive, bytes, ticks);
+    iostats_unlock(&lock);
+}
+
+void iostats_record_handle(IoStats_Op op, Handle handle, u32 bytes, u64 start)
+{
+    const u64 ticks = iostats_now() - start;
+    ensure_lock();
+    iostats_lock(&lock);
+    if(!reporting)
+    {
+        FS_Archive archive = 0;
+        for(u32 i = 0; i < IOSTATS_MAX_HANDLES; ++i)
+        {
+            if(handles[i].handle == handle)
+            {
+                archive = handles[i].archive;
+                break;
+            }
+        }
+        record_locked(op, archive, bytes, ticks);
+    }
+    iostats_unlock(&lock);
+}
+
+static const char * archive_name(FS_Archive archive)
+{
+    for(u32 i = 0; i < IOSTATS_MAX_ARCHIVES && archives[i].name != NULL; ++i)
+    {
+        if(archives[i].archive == archive)
+            return archives[i].name;
+    }
+    return "unknown";
+}
+
+static void save_json(json_t * root, const char * what)
+{
+    char * json = json_dumps(root, JSON_INDENT(2));
+    if(json == NULL)
+        return;
+
+    char path[0x80] = {0};
+    snprintf(path, sizeof(path), "/3ds/" APP_TITLE "/iostats_%s.json", what);
+    const u32 size = strlen(json);
+    rewrite_file(fsMakePath(PATH_ASCII, path), ArchiveSD, size, json, size);
+    free(json);
+}
+
+void iostats_report(const char * what)
+{
+    ensure_lock();
+    iostats_lock(&lock);
+    reporting = true;
+
+    json_t * root = json_object();
+    json_t * json_records = json_array();
+    json_t * json_bounds = json_array();
+    json_object_set_new(root, "what", json_string(what));
+    for(u32 i = 0; i < IOSTATS_BUCKETS - 1; ++i)
+        json_array_append_new(json_bounds, json_integer(bucket_bounds_us[i]));
+    json_object_set_new(root, "bucket_bounds_us", json_bounds);
+    json_object_set_new(root, "dropped", json_integer(dropped));
+
+    DEBUG("I/O stats for %s (%lu records, %lu dropped):\n", what, records_count, dropped);
+    for(u32 i = 0; i < records_count; ++i)
+    {
+        const IoStats_Record_s * const record = &records[i];
+        const char * const phase = record->phase != NULL ? record->phase : "none";
+        const u64 total_us = record->ticks / IOSTATS_TICKS_PER_US;
+        const u64 max_us = record->max_ticks / IOSTATS_TICKS_PER_US;
+
+        DEBUG("%-16s %-24s %-10s %-8s %6lu ops %10llu bytes %10llu us (max %llu us) [",
+            phase, record->site, archive_name(record->archive), op_names[record->op],
+            record->count, record->bytes, total_us, max_us);
+        json_t * json_buckets = json_array();
+        for(u32 j = 0; j < IOSTATS_BUCKETS; ++j)
+        {
+            DEBUG(j ? " %lu" : "%lu", record->buckets[j]);
+            json_array_append_new(json_buckets, json_integer(record->buckets[j]));
+        }
+        DEBUG("]\n");
+
+        json_t * json_record = json_object();
+        json_object_set_new(json_record, "phase", json_string(phase));
+        json_object_set_new(json_record, "site", json_string(record->site));
+        json_object_set_new(json_record, "archive", json_string(archive_name(record->archive)));
+        json_object_set_new(json_record, "op", json_string(op_names[record->op]));
+        json_object_set_new(json_record, "count", json_integer(record->count));
+        json_object_set_new(json_record, "bytes", json_integer(record->bytes));
+        json_object_set_new(json_record, "total_us", json_integer(total_us));
+        json_object_set_new(json_record, "max_us", json_integer(max_us));
+        json_object_set_new(json_record, "buckets", json_buckets);
+        json_array_append_new(json_records, json_record);
+    }
+    json_object_set_new(root, "records", json_records);
+
+    records_count = 0;
+    dropped = 0;
+    iostats_unlock(&lock);
+
+    // still reporting, so writing the report doesn't count itself
+    save_json(root, what);
+    json_decref(root);
+
+    iostats_lock(&lock);
+    reporting = false;
+    iostats_unlock(&lock);
+}
+
+#endif
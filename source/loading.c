@@ -31,38 +31,53 @@
 #include "draw.h"
 #include "conversion.h"
 #include "ui_strings.h"
+#include "trace.h"
+#include "icon_pack.h"
 
 #include <png.h>
 
-void copy_texture_data(C3D_Tex * texture, const u16 * src, const Entry_Icon_s * current_icon)
+// Icon prefetching, all in milliseconds
+#define PREFETCH_HORIZON_MS 1000 // icons are loaded for where a moving scroll gets to within that long
+#define PREFETCH_IDLE_MS 500 // a scroll that didn't move for that long has stopped
+#define PREFETCH_IDLE_MS_PER_ENTRY ((u32)(FASTSCROLL_WAIT / 1000000)) // a held D-pad's pace, the slowest a scroll is expected to go
+#define PREFETCH_TURN_MS 300 // for a moving scroll to turn around, before it gets to what's behind it
+
+void copy_texture_data(C3D_Tex * texture, const u16 * src, const Entry_Icon_s * current_icon, Texture_Range_s * dirty)
 {
     // pointer to rgb565, offset by the number of rows and columns specified by current_icon
     // (reminder that this is z order curve storage)
-    u16 * dest = ((u16 *)texture->data) + (current_icon->y * texture->width) + (current_icon->x * 8);
+    u16 * const first = ((u16 *)texture->data) + (current_icon->y * texture->width) + (current_icon->x * 8);
+    u16 * dest = first;
     for (int j = 0; j < 48; j += 8)
     {
         memcpy(dest, src, 48 * 8 * sizeof(u16));
         src += 48 * 8;
         dest += texture->width * 8;
     }
-    GSPGPU_InvalidateDataCache(texture->data, texture->size);
+
+    // from the first row of tiles to the end of the last one
+    const u32 start = (u8 *)first - (u8 *)texture->data;
+    const u32 end = (u8 *)(dest - texture->width * 8 + 48 * 8) - (u8 *)texture->data;
+    if(dirty->start == dirty->end)
+    {
+        dirty->start = start;
+        dirty->end = end;
+    }
+    else
+    {
+        dirty->start = min(dirty->start, start);
+        dirty->end = max(dirty->end, end);
+    }
 }
 
-void parse_smdh(Icon_s * icon, Entry_s * entry, const u16 * fallback_name)
+void flush_texture_data(C3D_Tex * texture, Texture_Range_s * dirty)
 {
-    if(icon == NULL)
-    {
-        memcpy(entry->name, fallback_name, 0x80);
-        utf8_to_utf16(entry->desc, (u8 *)"No description", 0x100);
-        utf8_to_utf16(entry->author, (u8 *)"Unknown author", 0x80);
-        entry->placeholder_color = C2D_Color32(rand() % 255, rand() % 255, rand() % 255, 255);
+    if(dirty->start == dirty->end)
         return;
-    }
 
-    memcpy(entry->name, icon->name, 0x40 * sizeof(u16));
-    memcpy(entry->desc, icon->desc, 0x80 * sizeof(u16));
-    memcpy(entry->author, icon->author, 0x40 * sizeof(u16));
-    entry->placeholder_color = 0;
+    GSPGPU_InvalidateDataCache((u8 *)texture->data + dirty->start, dirty->end - dirty->start);
+    dirty->start = 0;
+    dirty->end = 0;
 }
 
 static Icon_s * load_entry_icon(const Entry_s * entry)
@@ -78,68 +93,188 @@ static Icon_s * load_entry_icon(const Entry_s * entry)
     return (Icon_s *)info_buffer;
 }
 
-void load_icons_first(Entry_List_s * list, bool silent)
+// Reads count icons one after the other in the pack, from pack_icon's on, at once.
+// Returns the buffer they're in, NULL unless every one of them could be read
+static u16 * read_packed_icons(Handle pack, u32 pack_icon, int count)
 {
-    if(list == NULL || list->entries == NULL) return;
+    u16 * const icons = malloc(count * ICON_PACK_ICON_SIZE);
+    if(icons != NULL && icon_pack_read(pack, pack_icon - 1, count, icons) != (u32)count)
+    {
+        free(icons);
+        return NULL;
+    }
+    return icons;
+}
 
-    if(!silent)
-        draw_install(INSTALL_LOADING_ICONS);
+static bool icon_packed(Handle pack, u32 pack_icon)
+{
+    return pack != 0 && pack_icon != 0 && pack_icon != ENTRY_NO_ICON;
+}
+
+// The entry's icon out of the pack if it's there, out of its info.smdh if not.
+// Returns what to free once the icon is copied, pixels is NULL without one
+static void * read_icon(Handle pack, const Entry_s * entry, const u16 ** pixels)
+{
+    *pixels = NULL;
+    if(entry->pack_icon == ENTRY_NO_ICON)
+        return NULL;
+
+    if(icon_packed(pack, entry->pack_icon))
+    {
+        u16 * const icon = read_packed_icons(pack, entry->pack_icon, 1);
+        if(icon != NULL)
+        {
+            *pixels = icon;
+            return icon;
+        }
+    }
 
-    int starti = 0, endi = 0;
+    Icon_s * const smdh = load_entry_icon(entry);
+    if(smdh != NULL)
+        *pixels = smdh->big_icon;
+    return smdh;
+}
+
+static int wrap_index(const Entry_List_s * list, int index)
+{
+    index %= list->entries_count;
+    return index < 0 ? index + list->entries_count : index;
+}
 
-    if(list->entries_count <= list->entries_loaded * ICONS_OFFSET_AMOUNT)
+// The entries whose icons are wanted, soonest shown first: the visible ones, then those ahead of the scroll and behind it
+// in the order the scroll gets to them. Going by how fast it's moving, icons are loaded up to PREFETCH_HORIZON_MS ahead.
+// Everything is, if the atlas can hold the whole list. plan needs room for icons_count
+static int plan_icons(const Entry_List_s * list, Entry_s ** plan)
+{
+    const int visible = min(list->entries_loaded, list->entries_count);
+    int planned = 0;
+    for(int i = 0; i < visible; ++i)
+        plan[planned++] = list->entries[wrap_index(list, list->scroll + i)];
+
+    const bool moving = list->scroll_direction != 0;
+    const int rest = min(list->entries_count, list->icons_count) - visible;
+    int ahead_max, behind_max;
+    if(list->entries_count <= list->icons_count)
     {
-        DEBUG("small load\n");
-        // if the list is one that doesnt need swapping, load everything at once
-        endi = list->entries_count;
+        behind_max = rest / 2;
+        ahead_max = rest - behind_max;
     }
     else
     {
-        DEBUG("extended load\n");
-        // otherwise, load around to prepare for swapping
-        starti = list->scroll - list->entries_loaded * ICONS_VISIBLE;
-        endi = starti + list->entries_loaded * ICONS_OFFSET_AMOUNT;
+        behind_max = list->entries_loaded * ICONS_VISIBLE;
+        ahead_max = list->entries_loaded * (ICONS_OFFSET_AMOUNT - ICONS_UNDER);
+        if(moving)
+            ahead_max = max(ahead_max, min(rest - behind_max, (int)(PREFETCH_HORIZON_MS / list->scroll_ms_per_entry)));
     }
 
-    for(int entry_i = starti, icon_i = 0; entry_i < endi; ++entry_i, ++icon_i)
+    // the list wraps around, so does what's ahead of it
+    const bool up = list->scroll_direction < 0;
+    const u32 ahead_ms = moving ? list->scroll_ms_per_entry : PREFETCH_IDLE_MS_PER_ENTRY;
+    const u32 behind_wait_ms = moving ? PREFETCH_TURN_MS : 0;
+    int ahead = 0, behind = 0;
+    while(ahead < ahead_max || behind < behind_max)
     {
-        if(!silent)
-            draw_loading_bar(icon_i, endi-starti, INSTALL_LOADING_ICONS);
+        const u32 ahead_time = (ahead + 1) * ahead_ms;
+        const u32 behind_time = (behind + 1) * PREFETCH_IDLE_MS_PER_ENTRY + behind_wait_ms;
+        int offset;
+        if(ahead < ahead_max && (behind == behind_max || ahead_time <= behind_time))
+            offset = up ? list->scroll - 1 - ahead++ : list->scroll + visible + ahead++;
+        else
+            offset = up ? list->scroll + visible + behind++ : list->scroll - 1 - behind++;
+        plan[planned++] = list->entries[wrap_index(list, offset)];
+    }
+    return planned;
+}
 
-        int offset = entry_i;
-        if(offset < 0)
-            offset += list->entries_count;
-        if(offset >= list->entries_count)
-            offset -= list->entries_count;
+// Keeps the planned icons in the atlas, the first ones the longest
+static void use_icons(Entry_List_s * list, Entry_s * const * plan, int count)
+{
+    for(int i = count - 1; i >= 0; --i)
+        list_use_icon(list, plan[i]);
+}
 
-        Entry_s * const current_entry = &list->entries[offset];
-        Icon_s * const smdh = load_entry_icon(current_entry);
-        if(smdh != NULL)
-        {
-            if(current_entry->placeholder_color == 0)
-                parse_smdh(smdh, current_entry, current_entry->path + strlen(list->loading_path));
-            copy_texture_data(&list->icons_texture, smdh->big_icon, &list->icons_info[icon_i]);
-            free(smdh);
-        }
-    }
+// The slot's icon info while it has the owner it had at that many claims, NULL if the list was
+// reloaded or the slot given to another entry since
+static Entry_Icon_s * claimed_icon(Entry_List_s * list, int slot, u16 claims)
+{
+    if(list->icons_info == NULL || slot >= list->icons_count || list->icons_info[slot].claims != claims)
+        return NULL;
+    return &list->icons_info[slot];
 }
 
-static void reverse(Entry_Icon_s a[], int sz) {
-    int i, j;
-    Entry_Icon_s tmp;
-    for (i = 0, j = sz; i < j; i++, j--) {
-        memcpy(&tmp, &a[i], sizeof(Entry_Icon_s));
-        memcpy(&a[i], &a[j], sizeof(Entry_Icon_s));
-        memcpy(&a[j], &tmp, sizeof(Entry_Icon_s));
-    }
+static void publish_icon(Entry_List_s * list, int slot, u16 claims, const u16 * pixels)
+{
+    Entry_Icon_s * const icon = claimed_icon(list, slot, claims);
+    if(icon == NULL)
+        return;
+
+    if(pixels != NULL)
+        copy_texture_data(&list->icons_texture, pixels, icon, &list->icons_dirty);
+    icon->ready = true;
+    icon->requested = false;
 }
 
-static void rotate(Entry_Icon_s array[], int size, int amt) {
-    if (amt < 0)
-        amt = size + amt;
-    reverse(array, size-amt-1);
-    reverse(array+size-amt, amt-1);
-    reverse(array, size-1);
+static int compare_pack_icons(const void * a, const void * b)
+{
+    const u32 a_icon = (*(Entry_s * const *)a)->pack_icon;
+    const u32 b_icon = (*(Entry_s * const *)b)->pack_icon;
+    return (a_icon > b_icon) - (a_icon < b_icon);
+}
+
+void load_icons_first(Entry_List_s * list, bool silent)
+{
+    TRACE_SPAN("load_icons_first");
+    if(list == NULL || list->entries == NULL || list->icons_count == 0) return;
+
+    Entry_s ** const plan = malloc(list->icons_count * sizeof(Entry_s *));
+    if(plan == NULL) return;
+
+    int planned = plan_icons(list, plan);
+    use_icons(list, plan, planned);
+    int missing = 0;
+    for(int i = 0; i < planned; ++i)
+    {
+        const int slot = plan[i]->icon_slot - 1;
+        if(slot < 0 || !list->icons_info[slot].ready)
+            plan[missing++] = plan[i];
+    }
+
+    if(!silent && missing != 0)
+        draw_install(INSTALL_LOADING_ICONS);
+
+    // they're all loaded before anything is shown, so in the order of the pack, reading those one after the other together
+    qsort(plan, missing, sizeof(Entry_s *), compare_pack_icons);
+    for(int i = 0; i < missing;)
+    {
+        if(!silent)
+            draw_loading_bar(i, missing, INSTALL_LOADING_ICONS);
+
+        const u32 first_icon = plan[i]->pack_icon;
+        int run = 1;
+        if(icon_packed(list->icon_pack, first_icon))
+        {
+            while(run < ICON_PACK_READ_MAX && i + run < missing && plan[i + run]->pack_icon == first_icon + run)
+                run++;
+        }
+        u16 * const icons = run > 1 ? read_packed_icons(list->icon_pack, first_icon, run) : NULL;
+
+        for(int j = 0; j < run; ++j, ++i)
+        {
+            Entry_s * const entry = plan[i];
+            const int slot = entry->icon_slot != 0 ? entry->icon_slot - 1 : list_claim_icon(list, entry);
+            const u16 * pixels = NULL;
+            void * data = NULL;
+            if(icons != NULL)
+                pixels = icons + j * ICON_PACK_ICON_SIZE / sizeof(u16);
+            else
+                data = read_icon(list->icon_pack, entry, &pixels);
+            publish_icon(list, slot, list->icons_info[slot].claims, pixels);
+            free(data);
+        }
+        free(icons);
+    }
+    flush_texture_data(&list->icons_texture, &list->icons_dirty);
+    free(plan);
 }
 
 void handle_scrolling(Entry_List_s * list)
@@ -194,118 +329,245 @@ void handle_scrolling(Entry_List_s * list)
     //----------------------------------------------------------------
 }
 
-static bool load_icons(Entry_List_s * current_list, Handle mutex)
+// Follows where the scroll is going and how fast, from how far it moved since it last did
+static void track_scroll(Entry_List_s * list)
 {
-    if(current_list == NULL || current_list->entries == NULL)
-        return false;
-
-    handle_scrolling(current_list);
-
-    if(current_list->entries_count <= current_list->entries_loaded * ICONS_OFFSET_AMOUNT || current_list->previous_scroll == current_list->scroll)
-        return false; // return if the list is one that doesnt need swapping, or if nothing changed
+    const u64 now = svcGetSystemTick();
+    const u32 elapsed_ms = (now - list->scroll_moved_tick) / CPU_TICKS_PER_MSEC;
+    list->scroll_moved_tick = now;
 
-    #define SIGN(x) (x > 0 ? 1 : ((x < 0) ? -1 : 0))
+    int delta = list->scroll - list->previous_scroll;
+    // going past either end lands on the other one
+    if(abs(delta) > list->entries_count / 2)
+        delta -= delta > 0 ? list->entries_count : -list->entries_count;
 
-    int delta = current_list->scroll - current_list->previous_scroll;
-    if(abs(delta) >= current_list->entries_count - current_list->entries_loaded * (ICONS_OFFSET_AMOUNT-1))
-        delta = -SIGN(delta) * (current_list->entries_count - abs(delta));
-
-    int starti = current_list->scroll;
-    int endi = starti + abs(delta);
-
-    if(delta < 0)
+    const int direction = delta > 0 ? 1 : -1;
+    if(delta == 0 || abs(delta) > list->entries_loaded * ICONS_OFFSET_AMOUNT)
     {
-        endi -= abs(delta) + 1;
-        starti += abs(delta) - 1;
+        // a jump, there's no telling where it goes next
+        list->scroll_direction = 0;
+        return;
     }
 
-    int ctr = 0;
-    Entry_s ** const entries = calloc(abs(delta), sizeof(Entry_s *));
-    int * const indexes = calloc(abs(delta), sizeof(int));
-    bool released = false;
+    const u32 ms_per_entry = max(1, min(PREFETCH_IDLE_MS_PER_ENTRY, elapsed_ms / abs(delta)));
+    if(list->scroll_direction == direction)
+        list->scroll_ms_per_entry = (list->scroll_ms_per_entry * 3 + ms_per_entry) / 4;
+    else
+        list->scroll_ms_per_entry = ms_per_entry;
+    list->scroll_direction = direction;
+}
 
-    Entry_Icon_s * const icons = current_list->icons_info;
+void icon_loader_init(Icon_Loader_s * loader)
+{
+    memset(loader, 0, sizeof(Icon_Loader_s));
+    LightEvent_Init(&loader->request_added, RESET_ONESHOT);
+}
 
-    for(int i = starti; i != endi; i++, ctr++)
+// Takes back what the icon thread answered, putting the icons it read in their list's atlas.
+// The GPU is made to see them once per list they went to
+static void take_results(Icon_Loader_s * loader)
+{
+    Entry_List_s * published = NULL;
+    const u32 added = __atomic_load_n(&loader->results_added, __ATOMIC_ACQUIRE);
+    while(loader->results_taken != added)
     {
-        int index = 0;
-        int offset = i;
-
-        rotate(icons, ICONS_OFFSET_AMOUNT * current_list->entries_loaded, -SIGN(delta));
+        Icon_Result_s * const result = &loader->results[loader->results_taken % ICON_QUEUE_SIZE];
+        if(result->list != published)
+        {
+            if(published != NULL)
+                flush_texture_data(&published->icons_texture, &published->icons_dirty);
+            published = result->list;
+        }
 
-        if(delta > 0)
+        if(!result->skipped)
         {
-            index = current_list->entries_loaded * ICONS_OFFSET_AMOUNT - delta + i - starti;
-            offset += current_list->entries_loaded * ICONS_UNDER - delta;
+            publish_icon(result->list, result->slot, result->claims, result->pixels);
         }
         else
         {
-            index = 0 - delta - 1 + i - starti;
-            offset -= current_list->entries_loaded * ICONS_VISIBLE;
-            i -= 2; //i-- twice to counter the i++, needed only for this case
+            // asked for again if it's still wanted
+            Entry_Icon_s * const icon = claimed_icon(result->list, result->slot, result->claims);
+            if(icon != NULL)
+                icon->requested = false;
         }
+        free(result->data);
+        __atomic_store_n(&loader->results_taken, loader->results_taken + 1, __ATOMIC_RELEASE);
+    }
 
-        if(offset < 0)
-            offset += current_list->entries_count;
-        if(offset >= current_list->entries_count)
-            offset -= current_list->entries_count;
+    if(published != NULL)
+        flush_texture_data(&published->icons_texture, &published->icons_dirty);
+}
 
-        entries[ctr] = &current_list->entries[offset];
-        indexes[ctr] = index;
-    }
+void update_icons(Entry_List_s * list, Icon_Loader_s * loader)
+{
+    take_results(loader);
+
+    if(list == NULL || list->entries == NULL || list->icons_count == 0)
+        return;
 
-    #undef SIGN
+    handle_scrolling(list);
 
-    if(abs(delta) <= current_list->entries_loaded)
+    if(list->entries_count <= list->icons_count)
     {
-        svcReleaseMutex(mutex);
-        released = true;
+        // the atlas holds the whole list
+        list->previous_scroll = list->scroll;
+        return;
     }
 
-    svcSleepThread(1e7);
-    starti = 0;
-    endi = abs(delta);
-    for(int i = starti; i < endi; i++)
+    if(list->previous_scroll != list->scroll)
+    {
+        track_scroll(list);
+        __atomic_store_n(&loader->generation, loader->generation + 1, __ATOMIC_RELEASE);
+    }
+    else if(list->scroll_direction != 0 && (svcGetSystemTick() - list->scroll_moved_tick) / CPU_TICKS_PER_MSEC > PREFETCH_IDLE_MS)
     {
-        Entry_s * const current_entry = entries[i];
-        const int index = indexes[i];
-        const Entry_Icon_s * const current_icon = &icons[index];
+        list->scroll_direction = 0;
+    }
+    list->previous_scroll = list->scroll;
 
-        Icon_s * const smdh = load_entry_icon(current_entry);
-        if(smdh != NULL)
-        {
-            if(current_entry->placeholder_color == 0)
-                parse_smdh(smdh, current_entry, current_entry->path + strlen(current_list->loading_path));
-            copy_texture_data(&current_list->icons_texture, smdh->big_icon, current_icon);
-            free(smdh);
-        }
+    if(loader->plan_capacity < list->icons_count)
+    {
+        Entry_s ** const plan = realloc(loader->plan, list->icons_count * sizeof(Entry_s *));
+        if(plan == NULL)
+            return;
+        loader->plan = plan;
+        loader->plan_capacity = list->icons_count;
+    }
+
+    const int planned = plan_icons(list, loader->plan);
+    use_icons(list, loader->plan, planned);
 
-        if(!released && i > endi/2)
+    // every request gets a result, so keeping both rings from filling up only takes counting what wasn't taken back
+    bool added = false;
+    for(int i = 0; i < planned && loader->requests_added - loader->results_taken < ICON_QUEUE_SIZE; i++)
+    {
+        Entry_s * const entry = loader->plan[i];
+        int slot = entry->icon_slot - 1;
+        if(slot >= 0 && (list->icons_info[slot].ready || list->icons_info[slot].requested))
+            continue;
+
+        if(slot < 0)
+            slot = list_claim_icon(list, entry);
+        if(slot < 0)
+            continue;
+
+        Entry_Icon_s * const icon = &list->icons_info[slot];
+        if(entry->pack_icon == ENTRY_NO_ICON)
         {
-            svcReleaseMutex(mutex);
-            released = true;
+            // nothing to read
+            publish_icon(list, slot, icon->claims, NULL);
+            continue;
         }
+
+        icon->requested = true;
+        loader->requests[loader->requests_added % ICON_QUEUE_SIZE] = (Icon_Request_s){
+            .list = list,
+            .slot = slot,
+            .claims = icon->claims,
+            .generation = loader->generation,
+            .prefix = entry->prefix,
+            .file_name = entry->file_name,
+            .file_name_len = entry->file_name_len,
+            .is_zip = entry->is_zip,
+            .pack = list->icon_pack,
+            .pack_icon = entry->pack_icon,
+        };
+        __atomic_store_n(&loader->requests_added, loader->requests_added + 1, __ATOMIC_RELEASE);
+        added = true;
     }
 
-    free(entries);
-    free(indexes);
+    if(added)
+        LightEvent_Signal(&loader->request_added);
+}
+
+void icon_loader_drain(Icon_Loader_s * loader)
+{
+    take_results(loader);
 
-    current_list->previous_scroll = current_list->scroll;
+    // what wasn't read is asked for again once the thread is back
+    for(u32 i = loader->requests_taken; i != loader->requests_added; i++)
+    {
+        const Icon_Request_s * const request = &loader->requests[i % ICON_QUEUE_SIZE];
+        Entry_Icon_s * const icon = claimed_icon(request->list, request->slot, request->claims);
+        if(icon != NULL)
+            icon->requested = false;
+    }
+    loader->requests_taken = loader->requests_added;
+    loader->results_added = loader->requests_added;
+    loader->results_taken = loader->requests_added;
 
-    return released;
+    free(loader->plan);
+    loader->plan = NULL;
+    loader->plan_capacity = 0;
 }
 
+// Reads the icons asked for in order, only the file names and folders are used so the list can change meanwhile.
+// Requests from before the scroll last moved are answered without reading anything, the main loop asks again for what it still wants.
+// Requests waiting for icons one after the other in the pack are answered with a single read
 void load_icons_thread(void * void_arg)
 {
     Thread_Arg_s * arg = (Thread_Arg_s *)void_arg;
-    Handle mutex = *(Handle *)arg->thread_arg[1];
-    do {
-        svcWaitSynchronization(mutex, U64_MAX);
-        Entry_List_s * const current_list = *(Entry_List_s ** volatile)arg->thread_arg[0];
-        const bool released = load_icons(current_list, mutex);
-        if(!released)
-            svcReleaseMutex(mutex);
-    } while(arg->run_thread);
+    Icon_Loader_s * const loader = (Icon_Loader_s *)arg->thread_arg[0];
+    while(arg->run_thread)
+    {
+        const u32 taken = loader->requests_taken;
+        const u32 added = __atomic_load_n(&loader->requests_added, __ATOMIC_ACQUIRE);
+        if(taken == added)
+        {
+            LightEvent_Wait(&loader->request_added);
+            continue;
+        }
+
+        // the main loop doesn't reuse a request's place before its result is taken back, so they're read where they are
+        const Icon_Request_s * const first = &loader->requests[taken % ICON_QUEUE_SIZE];
+        const bool skipped = first->generation != __atomic_load_n(&loader->generation, __ATOMIC_ACQUIRE);
+        u32 run = 1;
+        if(!skipped && icon_packed(first->pack, first->pack_icon))
+        {
+            for(; run < ICON_PACK_READ_MAX && taken + run != added; run++)
+            {
+                const Icon_Request_s * const next = &loader->requests[(taken + run) % ICON_QUEUE_SIZE];
+                if(next->pack != first->pack || next->pack_icon != first->pack_icon + run)
+                    break;
+            }
+        }
+        u16 * const icons = run > 1 ? read_packed_icons(first->pack, first->pack_icon, run) : NULL;
+
+        for(u32 i = 0; i < run; i++)
+        {
+            const Icon_Request_s * const request = &loader->requests[(taken + i) % ICON_QUEUE_SIZE];
+            Icon_Result_s * const result = &loader->results[(loader->results_added + i) % ICON_QUEUE_SIZE];
+            result->list = request->list;
+            result->slot = request->slot;
+            result->claims = request->claims;
+            result->pixels = NULL;
+            result->data = NULL;
+            result->skipped = skipped;
+            if(skipped)
+                continue;
+
+            if(icons != NULL)
+            {
+                // all of them are taken back together, the last frees the buffer
+                result->pixels = icons + i * ICON_PACK_ICON_SIZE / sizeof(u16);
+                if(i == run - 1)
+                    result->data = icons;
+                continue;
+            }
+
+            const Entry_s entry = {
+                .prefix = request->prefix,
+                .file_name = request->file_name,
+                .file_name_len = request->file_name_len,
+                .is_zip = request->is_zip,
+                .pack_icon = request->pack_icon,
+            };
+            result->data = read_icon(request->pack, &entry, &result->pixels);
+        }
+
+        __atomic_store_n(&loader->requests_taken, taken + run, __ATOMIC_RELEASE);
+        __atomic_store_n(&loader->results_added, loader->results_added + run, __ATOMIC_RELEASE);
+    }
 }
 
 bool load_preview_from_buffer(char * row_pointers, u32 size, C2D_Image * preview_image, int * preview_offset, int height)
@@ -346,17 +608,16 @@ bool load_preview_from_buffer(char * row_pointers, u32 size, C2D_Image * preview
     return true;
 }
 
-static u16 previous_path_preview[0x106] = {0};
-bool load_preview(const Entry_List_s * list, C2D_Image * preview_image, int * preview_offset)
+static u16 previous_path_preview[ENTRY_PATH_SIZE] = {0};
+bool load_preview(Entry_Session_s * session, C2D_Image * preview_image, int * preview_offset)
 {
-    if(list->entries == NULL) return false;
-
-    const Entry_s * entry = &list->entries[list->selected_entry];
+    u16 path[ENTRY_PATH_SIZE] = {0};
+    entry_path(session->entry, NULL, path);
 
-    if(!memcmp(&previous_path_preview, &entry->path, 0x106 * sizeof(u16))) return true;
+    if(!memcmp(previous_path_preview, path, sizeof(path))) return true;
 
     char * preview_buffer = NULL;
-    u32 size = load_data("/preview.png", entry, &preview_buffer);
+    u32 size = entry_session_load(session, "/preview.png", &preview_buffer);
     u32 height = 480;
 
     if(size)
@@ -378,7 +639,7 @@ bool load_preview(const Entry_List_s * list, C2D_Image * preview_image, int * pr
         bool found_splash = false;
 
         // try to assembly a preview from the splash screens
-        size = load_data("/splash.bin", entry, &preview_buffer);
+        size = entry_session_load(session, "/splash.bin", &preview_buffer);
         if (size)
         {
             found_splash = true;
@@ -388,7 +649,7 @@ bool load_preview(const Entry_List_s * list, C2D_Image * preview_image, int * pr
             free(preview_buffer);
         }
 
-        size = load_data("/splashbottom.bin", entry, &preview_buffer);
+        size = entry_session_load(session, "/splashbottom.bin", &preview_buffer);
         if (size)
         {
             found_splash = true;
@@ -426,7 +687,7 @@ bool load_preview(const Entry_List_s * list, C2D_Image * preview_image, int * pr
     if(ret)
     {
         // mark the new preview as loaded for optimisation
-        memcpy(&previous_path_preview, &entry->path, 0x106 * sizeof(u16));
+        memcpy(previous_path_preview, path, sizeof(path));
     }
 
     return ret;
@@ -441,9 +702,9 @@ void free_preview(C2D_Image preview)
 }
 
 // Initialize the audio struct
-Result load_audio(const Entry_s * entry, audio_s * audio) 
+Result load_audio(Entry_Session_s * session, audio_s * audio) 
 {
-    audio->music_size = load_data("/bgm.bcstm", entry, &audio->music_buf);
+    audio->music_size = entry_session_load(session, "/bgm.bcstm", &audio->music_buf);
     if (audio->music_size == 0) {
         free(audio);
         DEBUG("<load_audio> File not found!\n");
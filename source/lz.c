@@ -0,0 +1,749 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "lz.h"
+#include "vfs.h"
+
+#define LZ11_WINDOW_SIZE 0x1000
+#define LZ11_WINDOW_MASK (LZ11_WINDOW_SIZE - 1)
+#define LZ11_MIN_MATCH 3
+#define LZ11_MAX_MATCH 0x10110
+
+#define LZ11_HASH_BITS 12
+#define LZ11_HASH_SIZE (1 << LZ11_HASH_BITS)
+#define LZ11_NIL 0xFFFFFFFF
+
+// Matches are found through hash chains over the last LZ11_WINDOW_SIZE bytes:
+// head holds the most recent position for each 3 byte hash, prev links every
+// position in the window to the previous one with the same hash.
+// The memory used is fixed no matter the size of the input.
+typedef struct {
+    u32 head[LZ11_HASH_SIZE];
+    u32 prev[LZ11_WINDOW_SIZE];
+} Lz11_Matcher_s;
+
+typedef struct {
+    u8 * out;
+    u32 pos;
+    u32 flag_pos;
+    u8 flag_bit;
+} Lz11_Writer_s;
+
+static const u16 chain_limits[LZ11_LEVEL_BEST + 1] = {
+    1, 4, 8, 16, 32, 64, 128, 256, 1024, 4096,
+};
+
+static inline u32 hash3(const u8 * p)
+{
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761U) >> (32 - LZ11_HASH_BITS);
+}
+
+static inline void insert_position(Lz11_Matcher_s * matcher, const u8 * in, u32 pos)
+{
+    const u32 h = hash3(in + pos);
+    matcher->prev[pos & LZ11_WINDOW_MASK] = matcher->head[h];
+    matcher->head[h] = pos;
+}
+
+static u32 find_match(const Lz11_Matcher_s * matcher, const u8 * in, u32 size, u32 pos, u32 max_chain, u32 * distance)
+{
+    const u32 max_len = min(size - pos, LZ11_MAX_MATCH);
+    if(max_len < LZ11_MIN_MATCH)
+        return 0;
+
+    u32 best_len = 0;
+    u32 candidate = matcher->head[hash3(in + pos)];
+    while(candidate != LZ11_NIL && candidate < pos && pos - candidate <= LZ11_WINDOW_SIZE && max_chain--)
+    {
+        const u8 * a = in + candidate;
+        const u8 * b = in + pos;
+        // cheap rejection: the byte that would make this match longer than the best so far
+        if(a[best_len] == b[best_len] && a[0] == b[0] && a[1] == b[1] && a[2] == b[2])
+        {
+            u32 len = LZ11_MIN_MATCH;
+            while(len < max_len && a[len] == b[len])
+                len++;
+
+            if(len > best_len)
+            {
+                best_len = len;
+                *distance = pos - candidate;
+                if(len == max_len)
+                    break;
+            }
+        }
+
+        const u32 next = matcher->prev[candidate & LZ11_WINDOW_MASK];
+        if(next >= candidate) // slot was reused by a newer position, the chain ends here
+            break;
+        candidate = next;
+    }
+
+    return best_len >= LZ11_MIN_MATCH ? best_len : 0;
+}
+
+static inline void start_token(Lz11_Writer_s * writer)
+{
+    if(writer->flag_bit == 0)
+    {
+        writer->flag_pos = writer->pos++;
+        writer->out[writer->flag_pos] = 0;
+        writer->flag_bit = 8;
+    }
+    writer->flag_bit--;
+}
+
+static inline void write_literal(Lz11_Writer_s * writer, u8 byte)
+{
+    start_token(writer);
+    writer->out[writer->pos++] = byte;
+}
+
+static void write_match(Lz11_Writer_s * writer, u32 len, u32 distance)
+{
+    start_token(writer);
+    writer->out[writer->flag_pos] |= 1 << writer->flag_bit;
+
+    const u32 disp = distance - 1;
+    u8 * out = writer->out;
+    if(len <= 0x10)
+    {
+        out[writer->pos++] = ((len - 1) << 4) | (disp >> 8);
+    }
+    else if(len <= 0x110)
+    {
+        len -= 0x11;
+        out[writer->pos++] = len >> 4;
+        out[writer->pos++] = ((len & 0x0F) << 4) | (disp >> 8);
+    }
+    else
+    {
+        len -= 0x111;
+        out[writer->pos++] = 0x10 | (len >> 12);
+        out[writer->pos++] = (len >> 4) & 0xFF;
+        out[writer->pos++] = ((len & 0x0F) << 4) | (disp >> 8);
+    }
+    out[writer->pos++] = disp & 0xFF;
+}
+
+// worst case is every byte being a literal, plus one flag byte per 8 of them
+u32 lz11_compress_bound(u32 size)
+{
+    return LZ11_HEADER_SIZE + size + (size + 7) / 8;
+}
+
+// Appends the tokens for in to writer, without a header
+static bool encode(const u8 * in, u32 size, Lz11_Writer_s * writer, int level)
+{
+    level = max(LZ11_LEVEL_FASTEST, min(level, LZ11_LEVEL_BEST));
+    const u32 max_chain = chain_limits[level];
+    const bool lazy = level >= 4;
+
+    Lz11_Matcher_s * matcher = malloc(sizeof(Lz11_Matcher_s));
+    if(matcher == NULL)
+    {
+        DEBUG("Error allocating lz11 matcher - out of memory??\n");
+        return false;
+    }
+    memset(matcher->head, 0xFF, sizeof(matcher->head));
+
+    u32 pos = 0;
+    while(pos < size)
+    {
+        u32 distance = 0;
+        u32 len = find_match(matcher, in, size, pos, max_chain, &distance);
+
+        // lazy evaluation: if the next position has a longer match, emit a literal instead
+        if(lazy && len != 0 && len < 0x20 && pos + 1 < size)
+        {
+            insert_position(matcher, in, pos);
+            u32 next_distance = 0;
+            const u32 next_len = find_match(matcher, in, size, pos + 1, max_chain, &next_distance);
+            if(next_len > len)
+            {
+                write_literal(writer, in[pos]);
+                pos++;
+                continue;
+            }
+            // pos is already inserted, skip it below
+            write_match(writer, len, distance);
+            for(u32 i = 1; i < len && pos + i + 2 < size; i++)
+                insert_position(matcher, in, pos + i);
+            pos += len;
+            continue;
+        }
+
+        if(len != 0)
+        {
+            write_match(writer, len, distance);
+            for(u32 i = 0; i < len && pos + i + 2 < size; i++)
+                insert_position(matcher, in, pos + i);
+            pos += len;
+        }
+        else
+        {
+            if(pos + 2 < size)
+                insert_position(matcher, in, pos);
+            write_literal(writer, in[pos]);
+            pos++;
+        }
+    }
+
+    free(matcher);
+    return true;
+}
+
+static void write_header(u8 * out, u32 size)
+{
+    out[0] = LZ11_MAGIC;
+    out[1] = size & 0xFF;
+    out[2] = (size >> 8) & 0xFF;
+    out[3] = (size >> 16) & 0xFF;
+}
+
+// out must be at least lz11_compress_bound(size) bytes. Returns the compressed size, 0 on failure
+u32 lz11_compress(const u8 * in, u32 size, u8 * out, int level)
+{
+    if(size > LZ11_MAX_SIZE)
+        return 0;
+
+    write_header(out, size);
+    Lz11_Writer_s writer = {
+        .out = out,
+        .pos = LZ11_HEADER_SIZE,
+    };
+    if(!encode(in, size, &writer, level))
+        return 0;
+
+    return writer.pos;
+}
+
+
+#define LZ11_READ_CHUNK 0x4000
+#define LZ11_STREAM_CHUNK 0x4000
+
+// Compressed data is pulled in LZ11_READ_CHUNK sized reads when coming from a file,
+// or used in place when it's already in memory (chunk is NULL then)
+typedef struct {
+    Handle handle;
+    u64 offset;
+    const u8 * data;
+    u32 pos;
+    u32 len;
+    u8 * chunk;
+} Lz11_Reader_s;
+
+// Decompressed data goes to buf. Without an output callback buf is the whole destination,
+// otherwise it's a window that gets handed to the callback each time it fills up, keeping
+// the last LZ11_WINDOW_SIZE bytes around for back references
+typedef struct {
+    u8 * buf;
+    u32 size;
+    u32 pos;
+    u32 flushed;
+    Lz11_Output_cb output;
+    void * userdata;
+} Lz11_Window_s;
+
+static bool refill(Lz11_Reader_s * reader)
+{
+    if(reader->chunk == NULL)
+        return false;
+
+    u32 read = 0;
+    if(R_FAILED(vfs_read(reader->handle, &read, reader->offset, reader->chunk, LZ11_READ_CHUNK)) || read == 0)
+        return false;
+
+    reader->offset += read;
+    reader->data = reader->chunk;
+    reader->pos = 0;
+    reader->len = read;
+    return true;
+}
+
+static inline bool read_byte(Lz11_Reader_s * reader, u8 * byte)
+{
+    if(reader->pos == reader->len && !refill(reader))
+        return false;
+
+    *byte = reader->data[reader->pos++];
+    return true;
+}
+
+static u32 read_header(Lz11_Reader_s * reader)
+{
+    u8 header[LZ11_HEADER_SIZE];
+    for(u32 i = 0; i < LZ11_HEADER_SIZE; i++)
+    {
+        if(!read_byte(reader, &header[i]))
+            return 0;
+    }
+
+    return lz11_decompressed_size(header);
+}
+
+static bool window_flush(Lz11_Window_s * window)
+{
+    if(window->output == NULL)
+        return false;
+    if(!window->output(window->userdata, window->buf + window->flushed, window->pos - window->flushed))
+        return false;
+
+    memmove(window->buf, window->buf + window->pos - LZ11_WINDOW_SIZE, LZ11_WINDOW_SIZE);
+    window->pos = LZ11_WINDOW_SIZE;
+    window->flushed = LZ11_WINDOW_SIZE;
+    return true;
+}
+
+static inline void copy_match(u8 * dst, u32 len, u32 distance)
+{
+    const u8 * src = dst - distance;
+    if(distance >= len && len > 0x10)
+    {
+        memcpy(dst, src, len);
+    }
+    else
+    {
+        for(u32 i = 0; i < len; i++)
+            dst[i] = src[i];
+    }
+}
+
+// Copies a word at a time, rounding len up to a multiple of 4: the caller makes sure there's
+// room for the extra bytes, which are overwritten by whatever gets decoded next.
+// With distance >= 4 every word read has already been written, even when the match overlaps itself
+static inline void copy_match_words(u8 * dst, u32 len, u32 distance)
+{
+    const u8 * src = dst - distance;
+    for(u32 i = 0; i < len; i += sizeof(u32))
+        memcpy(dst + i, src + i, sizeof(u32));
+}
+
+// The hot loop works on local copies of the reader and window positions: the output is
+// written through a u8 pointer, which would otherwise force them to be reloaded after every byte
+#define DECODE_READ(byte) do { \
+        if(near_end && in_pos == in_len) \
+        { \
+            reader->pos = in_pos; \
+            if(!refill(reader)) \
+                goto truncated; \
+            in = reader->data; \
+            in_pos = 0; \
+            in_len = reader->len; \
+        } \
+        (byte) = in[in_pos++]; \
+    } while(0)
+
+#define DECODE_SPACE() do { \
+        if(out_pos == out_end) \
+        { \
+            window->pos = out_pos; \
+            if(!window_flush(window)) \
+                return 0; \
+            out_pos = window->pos; \
+        } \
+    } while(0)
+
+static u32 decode(Lz11_Reader_s * reader, Lz11_Window_s * window, u32 size)
+{
+    const u8 * in = reader->data;
+    u32 in_pos = reader->pos;
+    u32 in_len = reader->len;
+    u8 * out = window->buf;
+    u32 out_pos = window->pos;
+    const u32 out_end = window->size;
+
+    u32 written = 0;
+    u8 flags = 0;
+    u8 flag_bit = 0;
+    bool near_end = true;
+
+    while(written < size)
+    {
+        if(flag_bit == 0)
+        {
+            // a whole group is at most 1 + 8 * 4 bytes, only check for the end of the chunk near it
+            near_end = in_len - in_pos < 1 + 8 * 4;
+            DECODE_READ(flags);
+            flag_bit = 8;
+        }
+        flag_bit--;
+
+        if(!(flags & (1 << flag_bit)))
+        {
+            DECODE_SPACE();
+            DECODE_READ(out[out_pos]);
+            out_pos++;
+            written++;
+            continue;
+        }
+
+        u8 b0, b1, b2, b3;
+        DECODE_READ(b0);
+        DECODE_READ(b1);
+
+        u32 len, distance;
+        switch(b0 >> 4)
+        {
+            case 0:
+                DECODE_READ(b2);
+                len = ((b0 << 4) | (b1 >> 4)) + 0x11;
+                distance = ((b1 & 0x0F) << 8) | b2;
+                break;
+            case 1:
+                DECODE_READ(b2);
+                DECODE_READ(b3);
+                len = (((b0 & 0x0F) << 12) | (b1 << 4) | (b2 >> 4)) + 0x111;
+                distance = ((b2 & 0x0F) << 8) | b3;
+                break;
+            default:
+                len = (b0 >> 4) + 1;
+                distance = ((b0 & 0x0F) << 8) | b1;
+                break;
+        }
+        distance += 1;
+
+        if(distance > written || len > size - written)
+        {
+            DEBUG("lz11: invalid back reference at 0x%lx\n", written);
+            return 0;
+        }
+
+        written += len;
+        if(distance >= sizeof(u32) && len <= 0x10 && len + sizeof(u32) <= out_end - out_pos)
+        {
+            copy_match_words(out + out_pos, len, distance);
+            out_pos += len;
+            continue;
+        }
+        if(len <= out_end - out_pos)
+        {
+            copy_match(out + out_pos, len, distance);
+            out_pos += len;
+            continue;
+        }
+
+        while(len != 0)
+        {
+            DECODE_SPACE();
+            const u32 chunk = min(len, out_end - out_pos);
+            copy_match(out + out_pos, chunk, distance);
+            out_pos += chunk;
+            len -= chunk;
+        }
+    }
+
+    window->pos = out_pos;
+    if(window->output != NULL && window->pos != window->flushed)
+    {
+        if(!window->output(window->userdata, window->buf + window->flushed, window->pos - window->flushed))
+            return 0;
+        window->flushed = window->pos;
+    }
+
+    return written;
+
+truncated:
+    DEBUG("lz11: data ended early at 0x%lx\n", written);
+    return 0;
+}
+
+#undef DECODE_READ
+#undef DECODE_SPACE
+
+// Returns the size stored in a 4 byte LZ11 header, 0 if it isn't one
+u32 lz11_decompressed_size(const u8 * header)
+{
+    if(header[0] != LZ11_MAGIC)
+        return 0;
+
+    return header[1] | (header[2] << 8) | (header[3] << 16);
+}
+
+// Decompresses the whole file into out, reading it in chunks instead of loading it first.
+// Both file functions return the decompressed size, 0 on malformed or truncated data
+u32 lz11_decompress_file(Handle handle, u8 * out, u32 out_size)
+{
+    Lz11_Reader_s reader = {
+        .handle = handle,
+        .chunk = malloc(LZ11_READ_CHUNK),
+    };
+    if(reader.chunk == NULL)
+        return 0;
+
+    u32 written = 0;
+    const u32 size = read_header(&reader);
+    if(size != 0 && size <= out_size)
+    {
+        Lz11_Window_s window = {
+            .buf = out,
+            .size = size,
+        };
+        written = decode(&reader, &window, size);
+    }
+
+    free(reader.chunk);
+    return written;
+}
+
+// Same as above but the output is handed out in pieces, so the whole of it never has to be in memory.
+// Also returns 0 when output stops it
+u32 lz11_decompress_file_stream(Handle handle, Lz11_Output_cb output, void * userdata)
+{
+    Lz11_Reader_s reader = {
+        .handle = handle,
+        .chunk = malloc(LZ11_READ_CHUNK),
+    };
+    Lz11_Window_s window = {
+        .buf = malloc(LZ11_WINDOW_SIZE + LZ11_STREAM_CHUNK),
+        .size = LZ11_WINDOW_SIZE + LZ11_STREAM_CHUNK,
+        .output = output,
+        .userdata = userdata,
+    };
+
+    u32 written = 0;
+    if(reader.chunk != NULL && window.buf != NULL)
+    {
+        const u32 size = read_header(&reader);
+        if(size != 0)
+            written = decode(&reader, &window, size);
+    }
+
+    free(window.buf);
+    free(reader.chunk);
+    return written;
+}
+
+static inline u32 reader_tell(const Lz11_Reader_s * reader)
+{
+    return reader->offset - reader->len + reader->pos;
+}
+
+// Moves the compressed bytes in [start, end) of the file by delta, going from the end when moving
+// forward so that nothing gets overwritten before it's read
+static bool move_tail(Handle handle, u32 start, u32 end, s32 delta, u8 * chunk)
+{
+    u32 done = 0;
+    while(done < end - start)
+    {
+        const u32 len = min(end - start - done, LZ11_READ_CHUNK);
+        const u32 from = delta > 0 ? end - done - len : start + done;
+
+        u32 read = 0;
+        if(R_FAILED(vfs_read(handle, &read, from, chunk, len)) || read != len)
+            return false;
+        if(R_FAILED(vfs_write(handle, NULL, from + delta, chunk, len, 0)))
+            return false;
+
+        done += len;
+    }
+
+    return true;
+}
+
+// Sets the decompressed byte at offset to value by editing the compressed file, and returns the new
+// compressed size, 0 on failure.
+// When that byte is a literal that nothing else copies it's overwritten on its own. Otherwise only the
+// groups of tokens up to where back references can no longer reach it are decompressed and encoded again,
+// and the rest of the compressed data is moved over as is
+u32 lz11_patch_file(Handle handle, u32 compressed_size, u32 offset, u8 value)
+{
+    Lz11_Reader_s reader = {
+        .handle = handle,
+        .chunk = malloc(LZ11_READ_CHUNK),
+    };
+    if(reader.chunk == NULL)
+        return 0;
+
+    u32 new_size = 0;
+    u8 * compressed = NULL;
+    u8 * prefix = NULL;
+    u8 * encoded = NULL;
+
+    const u32 size = read_header(&reader);
+    if(size == 0 || offset >= size)
+        goto end;
+
+    // tokens starting after this can't reach back to offset
+    const u32 reach_end = offset + LZ11_WINDOW_SIZE;
+    u32 out_pos = 0;
+    u32 literal_pos = 0;
+    u8 current = 0;
+    bool literal = false;
+    bool referenced = false;
+
+    while(out_pos < size && out_pos <= reach_end)
+    {
+        u8 flags;
+        if(!read_byte(&reader, &flags))
+            goto end;
+
+        for(int bit = 7; bit >= 0 && out_pos < size; bit--)
+        {
+            if(!(flags & (1 << bit)))
+            {
+                if(out_pos == offset)
+                {
+                    literal = true;
+                    literal_pos = reader_tell(&reader);
+                }
+                u8 byte;
+                if(!read_byte(&reader, &byte))
+                    goto end;
+                if(out_pos == offset)
+                    current = byte;
+                out_pos++;
+                continue;
+            }
+
+            u8 b[4];
+            if(!read_byte(&reader, &b[0]) || !read_byte(&reader, &b[1]))
+                goto end;
+
+            u32 len, distance;
+            switch(b[0] >> 4)
+            {
+                case 0:
+                    if(!read_byte(&reader, &b[2]))
+                        goto end;
+                    len = ((b[0] << 4) | (b[1] >> 4)) + 0x11;
+                    distance = ((b[1] & 0x0F) << 8) | b[2];
+                    break;
+                case 1:
+                    if(!read_byte(&reader, &b[2]) || !read_byte(&reader, &b[3]))
+                        goto end;
+                    len = (((b[0] & 0x0F) << 12) | (b[1] << 4) | (b[2] >> 4)) + 0x111;
+                    distance = ((b[2] & 0x0F) << 8) | b[3];
+                    break;
+                default:
+                    len = (b[0] >> 4) + 1;
+                    distance = ((b[0] & 0x0F) << 8) | b[1];
+                    break;
+            }
+            distance += 1;
+
+            if(distance > out_pos || len > size - out_pos)
+                goto end;
+
+            // either the byte is produced by this match, or this match copies it somewhere else
+            const u32 src = out_pos - distance;
+            if((out_pos <= offset && offset < out_pos + len) || (src <= offset && offset < src + len))
+                referenced = true;
+
+            out_pos += len;
+        }
+    }
+
+    if(literal && !referenced)
+    {
+        if(current != value && R_FAILED(vfs_write(handle, NULL, literal_pos, &value, 1, FS_WRITE_FLUSH)))
+            goto end;
+        new_size = compressed_size;
+        goto end;
+    }
+
+    // out_pos and prefix_end are now at the end of a group, so what follows can be kept as is
+    // as long as the new tokens also end on a group boundary
+    const u32 prefix_size = out_pos;
+    const u32 prefix_end = reader_tell(&reader);
+    const bool whole = out_pos == size;
+    if(prefix_end > compressed_size)
+        goto end;
+
+    compressed = malloc(prefix_end);
+    prefix = malloc(prefix_size);
+    encoded = malloc(lz11_compress_bound(prefix_size));
+    if(compressed == NULL || prefix == NULL || encoded == NULL)
+        goto end;
+
+    u32 read = 0;
+    if(R_FAILED(vfs_read(handle, &read, 0, compressed, prefix_end)) || read != prefix_end)
+        goto end;
+
+    Lz11_Reader_s prefix_reader = {
+        .data = compressed + LZ11_HEADER_SIZE,
+        .len = prefix_end - LZ11_HEADER_SIZE,
+    };
+    Lz11_Window_s prefix_window = {
+        .buf = prefix,
+        .size = prefix_size,
+    };
+    if(decode(&prefix_reader, &prefix_window, prefix_size) != prefix_size)
+        goto end;
+
+    if(prefix[offset] == value)
+    {
+        new_size = compressed_size;
+        goto end;
+    }
+    prefix[offset] = value;
+
+    // ending the prefix with a few literals changes the token count without changing the rest, and
+    // so does parsing it differently: try until it fills the last group exactly
+    static const int levels[] = {LZ11_LEVEL_DEFAULT, LZ11_LEVEL_FASTEST, LZ11_LEVEL_DEFAULT + 3};
+    const u32 max_tail = min(prefix_size, 32);
+    Lz11_Writer_s writer = {0};
+    bool aligned = false;
+    for(u32 i = 0; i < sizeof(levels) / sizeof(levels[0]) && !aligned; i++)
+    {
+        for(u32 tail = 0; tail <= max_tail && !aligned; tail++)
+        {
+            writer = (Lz11_Writer_s){
+                .out = encoded,
+                .pos = LZ11_HEADER_SIZE,
+            };
+            if(!encode(prefix, prefix_size - tail, &writer, levels[i]))
+                goto end;
+            for(u32 j = prefix_size - tail; j < prefix_size; j++)
+                write_literal(&writer, prefix[j]);
+
+            aligned = whole || writer.flag_bit == 0;
+        }
+    }
+    if(!aligned)
+        goto end;
+
+    const s32 delta = (s32)writer.pos - (s32)prefix_end;
+    u64 file_size = 0;
+    vfs_get_size(handle, &file_size);
+    if(compressed_size + delta > file_size)
+        goto end;
+
+    memcpy(encoded, compressed, LZ11_HEADER_SIZE);
+    if(delta != 0 && !move_tail(handle, prefix_end, compressed_size, delta, reader.chunk))
+        goto end;
+    if(R_FAILED(vfs_write(handle, NULL, 0, encoded, writer.pos, FS_WRITE_FLUSH)))
+        goto end;
+
+    new_size = compressed_size + delta;
+
+end:
+    free(encoded);
+    free(prefix);
+    free(compressed);
+    free(reader.chunk);
+    return new_size;
+}
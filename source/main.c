@@ -34,6 +34,8 @@
 #include "remote.h"
 #include "ui_strings.h"
 #include "badges.h"
+#include "duplicates.h"
+#include "trace.h"
 #include <time.h>
 
 bool quit = false;
@@ -46,12 +48,13 @@ u64 time_home_pressed = 0;
 
 static Thread iconLoadingThread = {0};
 static Thread_Arg_s iconLoadingThread_arg = {0};
-static Handle update_icons_mutex;
-static bool released = false;
+static Icon_Loader_s icon_loader;
 
 static Thread install_check_threads[MODE_AMOUNT] = {0};
 static Thread_Arg_s install_check_threads_arg[MODE_AMOUNT] = {0};
 
+static Duplicates_Job_s duplicates_jobs[MODE_AMOUNT] = {0};
+
 static Entry_List_s lists[MODE_AMOUNT] = {0};
 
 Language_s language = {0};
@@ -82,14 +85,21 @@ const int entry_size[MODE_AMOUNT] = {
 
 static void init_services(void)
 {
+    TRACE_SPAN("init_services");
     consoleDebugInit(debugDevice_SVC);
     cfguInit();
     ptmuInit();
     acInit();
-    dspfirm = !ndspInit();
+    {
+        TRACE_SPAN("ndsp_init");
+        dspfirm = !ndspInit();
+    }
     APT_GetAppCpuTimeLimit(&old_time_limit);
     APT_SetAppCpuTimeLimit(30);
-    httpcInit(0);
+    {
+        TRACE_SPAN("httpc_init");
+        httpcInit(0);
+    }
     init_sd();
     archive_result = open_archives();
     badge_archive_result = open_badge_extdata();
@@ -129,10 +139,48 @@ static void stop_install_check(void)
     }
 }
 
+// Returns whether the check had gone through the whole list already
+static bool stop_list_install_check(EntryMode mode)
+{
+    if(install_check_threads[mode] == NULL)
+        return true;
+
+    const bool finished = svcWaitSynchronization(threadGetHandle(install_check_threads[mode]), 0) == 0;
+    install_check_threads_arg[mode].run_thread = false;
+    threadJoin(install_check_threads[mode], U64_MAX);
+    threadFree(install_check_threads[mode]);
+    install_check_threads[mode] = NULL;
+    return finished;
+}
+
+static bool start_install_check(EntryMode mode)
+{
+    void (*install_check_function)(void *) = NULL;
+    if(mode == MODE_THEMES)
+        install_check_function = themes_check_installed;
+    else if(mode == MODE_SPLASHES)
+        install_check_function = splash_check_installed;
+
+    Thread_Arg_s * current_arg = &install_check_threads_arg[mode];
+    current_arg->run_thread = true;
+    current_arg->thread_arg = (void **)&lists[mode];
+
+    if(install_check_function == NULL)
+        return false;
+
+    install_check_threads[mode] = threadCreate(install_check_function, current_arg, __stacksize__, 0x3f, -2, false);
+    return true;
+}
+
+// the job works from a copy of the list, so it's started over whenever entries come and go
+static void restart_duplicates(EntryMode mode)
+{
+    duplicates_stop(&duplicates_jobs[mode]);
+    duplicates_start(&duplicates_jobs[mode], &lists[mode]);
+}
+
 static inline void wait_scroll(void)
 {
-    released = true;
-    svcReleaseMutex(update_icons_mutex);
     svcSleepThread(FASTSCROLL_WAIT);
 }
 
@@ -142,26 +190,29 @@ static void exit_thread(void)
     {
         DEBUG("exiting thread\n");
         iconLoadingThread_arg.run_thread = false;
-        svcReleaseMutex(update_icons_mutex);
-        svcWaitSynchronization(update_icons_mutex, U64_MAX);
+        LightEvent_Signal(&icon_loader.request_added);
         threadJoin(iconLoadingThread, U64_MAX);
         threadFree(iconLoadingThread);
         iconLoadingThread = NULL;
+        icon_loader_drain(&icon_loader);
     }
 }
 
 void free_lists(void)
 {
+    // what the icon thread answered is put in the lists' atlases
+    exit_thread();
     stop_install_check();
+    for(int i = 0; i < MODE_AMOUNT; i++)
+        duplicates_stop(&duplicates_jobs[i]);
     for(int i = 0; i < MODE_AMOUNT; i++)
     {
         Entry_List_s * const current_list = &lists[i];
         C3D_TexDelete(&current_list->icons_texture);
         free(current_list->icons_info);
-        free(current_list->entries);
+        list_free_entries(current_list);
         memset(current_list, 0, sizeof(Entry_List_s));
     }
-    exit_thread();
 }
 
 void exit_function(bool power_pressed)
@@ -171,7 +222,6 @@ void exit_function(bool power_pressed)
         stop_audio(&audio);
     }
     free_lists();
-    svcCloseHandle(update_icons_mutex);
     exit_screens();
     exit_services();
 
@@ -190,7 +240,7 @@ void exit_function(bool power_pressed)
 
 static void start_thread(void)
 {
-    if(iconLoadingThread_arg.run_thread)
+    if(iconLoadingThread_arg.run_thread && iconLoadingThread == NULL)
     {
         DEBUG("starting thread\n");
         iconLoadingThread = threadCreate(load_icons_thread, &iconLoadingThread_arg, __stacksize__, 0x38, -2, false);
@@ -211,9 +261,11 @@ static u32 next_or_equal_power_of_2(u32 v)
 
 static void load_lists(Entry_List_s * lists)
 {
+    TRACE_SPAN("load_lists");
     free_lists();
     for(int i = 0; i < MODE_AMOUNT; i++)
     {
+        TRACE_SPAN(i == MODE_THEMES ? "load_themes" : "load_splashes");
         InstallType loading_screen = INSTALL_NONE;
         if(i == MODE_THEMES)
             loading_screen = INSTALL_LOADING_THEMES;
@@ -234,20 +286,25 @@ static void load_lists(Entry_List_s * lists)
         // A texture must have power of 2 dimensions (not necessarily the same)
         // so, get the power of two greater than or equal to:
         // - the size of the largest length (row or column) of icons for the width
-        // - the size of all of those lengths to fit the total for the height
+        // - the size of all of those lengths to fit the total for the height, for every window the atlas keeps
         C3D_TexInit(&current_list->icons_texture,
             next_or_equal_power_of_2(x_component * current_list->entry_size),
-            next_or_equal_power_of_2(y_component * current_list->entry_size * ICONS_OFFSET_AMOUNT),
+            next_or_equal_power_of_2(y_component * current_list->entry_size * ICONS_OFFSET_AMOUNT * ICONS_ATLAS_WINDOWS),
             GPU_RGB565);
         C3D_TexSetFilter(&current_list->icons_texture, GPU_NEAREST, GPU_NEAREST);
 
+        // the atlas takes as many icons as the texture fits, rounding up to a power of 2 leaves room for more
+        const int columns = current_list->icons_texture.width / current_list->entry_size;
+        const int rows = current_list->icons_texture.height / current_list->entry_size;
         const float inv_width = 1.0f / current_list->icons_texture.width;
         const float inv_height = 1.0f / current_list->icons_texture.height;
-        current_list->icons_info = (Entry_Icon_s *)calloc(x_component * y_component * ICONS_OFFSET_AMOUNT, sizeof(Entry_Icon_s));
-        for(int j = 0; j < y_component * ICONS_OFFSET_AMOUNT; ++j)
+        current_list->icons_info = (Entry_Icon_s *)calloc(columns * rows, sizeof(Entry_Icon_s));
+        if(current_list->icons_info != NULL)
+            current_list->icons_count = columns * rows;
+        for(int j = 0; j < rows && current_list->icons_info != NULL; ++j)
         {
-            const int index = j * x_component;
-            for(int h = 0; h < x_component; ++h)
+            const int index = j * columns;
+            for(int h = 0; h < columns; ++h)
             {
                 Entry_Icon_s * const icon_info = &current_list->icons_info[index + h];
                 icon_info->x = h * current_list->entry_size;
@@ -260,11 +317,12 @@ static void load_lists(Entry_List_s * lists)
                 icon_info->subtex.bottom = icon_info->subtex.top - (icon_info->subtex.height * inv_height);
             }
         }
+        list_reset_icons(current_list);
 
         Result res = load_entries(main_paths[i], current_list, loading_screen);
         if(R_SUCCEEDED(res))
         {
-            if(current_list->entries_count > current_list->entries_loaded * ICONS_OFFSET_AMOUNT)
+            if(current_list->entries_count > current_list->icons_count)
                 iconLoadingThread_arg.run_thread = true;
 
             DEBUG("total: %i\n", current_list->entries_count);
@@ -272,29 +330,127 @@ static void load_lists(Entry_List_s * lists)
             sort_by_name(current_list);
             load_icons_first(current_list, false);
 
-            void (*install_check_function)(void *) = NULL;
-            if(i == MODE_THEMES)
-                install_check_function = themes_check_installed;
-            else if(i == MODE_SPLASHES)
-                install_check_function = splash_check_installed;
-
-            Thread_Arg_s * current_arg = &install_check_threads_arg[i];
-            current_arg->run_thread = true;
-            current_arg->thread_arg = (void **)current_list;
-
-            if(install_check_function != NULL)
+            if(start_install_check(i))
             {
-                install_check_threads[i] = threadCreate(install_check_function, current_arg, __stacksize__, 0x3f, -2, false);
+                TRACE_SPAN("install_check_wait");
                 svcSleepThread(1e8);
             }
+            duplicates_start(&duplicates_jobs[i], current_list);
         }
     }
     start_thread();
 }
 
+// The install checks read the entries, so they're stopped while entries come and go. The icon thread only
+// reads what it's asked for, from names that stay until the list is freed, and its answers for entries gone are left out
+static void pause_list_threads(EntryMode mode, bool * check_interrupted)
+{
+    if(!check_interrupted[mode])
+        check_interrupted[mode] = !stop_list_install_check(mode);
+}
+
+// restart_check holds the lists whose install check has to run again
+static void resume_list_threads(const bool * restart_check)
+{
+    for(int i = 0; i < MODE_AMOUNT; i++)
+    {
+        if(restart_check[i])
+            start_install_check(i);
+        if(lists[i].entries_count > lists[i].icons_count)
+            iconLoadingThread_arg.run_thread = true;
+    }
+    start_thread();
+}
+
+// Adds the entry at path, or reads it again if the list has it already. Returns false without enough memory
+static bool add_list_entry(Entry_List_s * list, const u16 * path, bool is_zip)
+{
+    if(list->icons_info == NULL)
+        return false;
+
+    // its icon goes with it, the one read again is loaded as a new entry's
+    const ssize_t existing = list_find_entry(list, path);
+    if(existing >= 0)
+        list_remove_entry(list, existing);
+
+    const bool added = list_insert_entry(list, path, is_zip) >= 0;
+    load_icons_first(list, true);
+    return added;
+}
+
+// Takes what was downloaded or dumped into the lists, only reading the folders again if that doesn't work out
+static void add_saved_entries(void)
+{
+    Saved_Entry_s * saved = NULL;
+    int saved_count = 0;
+    bool complete = take_saved_entries(&saved, &saved_count);
+
+    bool check_interrupted[MODE_AMOUNT] = {false};
+    bool changed[MODE_AMOUNT] = {false};
+    for(int i = 0; i < saved_count && complete; i++)
+    {
+        const EntryMode mode = (EntryMode)saved[i].mode;
+        pause_list_threads(mode, check_interrupted);
+        complete = add_list_entry(&lists[mode], saved[i].path, saved[i].is_zip);
+        changed[mode] = true;
+    }
+    free(saved);
+
+    if(!complete)
+    {
+        DEBUG("Couldn't add the saved entries, reloading\n");
+        load_lists(lists);
+        trace_report("reload_lists");
+        return;
+    }
+
+    if(saved_count == 0)
+        return;
+
+    // an entry read again comes back as not installed, even when it's the installed one
+    bool restart_check[MODE_AMOUNT];
+    for(int i = 0; i < MODE_AMOUNT; i++)
+        restart_check[i] = check_interrupted[i] || changed[i];
+    resume_list_threads(restart_check);
+    for(int i = 0; i < MODE_AMOUNT; i++)
+    {
+        if(changed[i])
+            restart_duplicates(i);
+    }
+}
+
+static void remove_list_entry(EntryMode mode, int index)
+{
+    Entry_List_s * const list = &lists[mode];
+    bool check_interrupted[MODE_AMOUNT] = {false};
+    pause_list_threads(mode, check_interrupted);
+
+    list_remove_entry(list, index);
+    load_icons_first(list, true);
+
+    resume_list_threads(check_interrupted);
+    restart_duplicates(mode);
+}
+
+static bool is_position(const char * text)
+{
+    if(*text == '\0')
+        return false;
+    for(; *text; ++text)
+    {
+        if(*text < '0' || *text > '9')
+            return false;
+    }
+    return true;
+}
+
 static SwkbdCallbackResult jump_menu_callback(void * entries_count, const char ** ppMessage, const char * text, size_t textlen)
 {
     (void)textlen;
+    // anything that isn't a position is searched for
+    if(!is_position(text))
+        return SWKBD_CALLBACK_OK;
+
     int typed_value = atoi(text);
     if(typed_value > *(int *)entries_count)
     {
@@ -309,19 +465,28 @@ static SwkbdCallbackResult jump_menu_callback(void * entries_count, const char *
     return SWKBD_CALLBACK_OK;
 }
 
+// a filtered list starts from the top, with its icons loaded like after sorting
+static void show_list_from_top(Entry_List_s * list)
+{
+    list->selected_entry = 0;
+    list->previous_selected = 0;
+    list->scroll = 0;
+    list->previous_scroll = 0;
+    load_icons_first(list, false);
+}
+
 static void jump_menu(Entry_List_s * list)
 {
     if(list == NULL) return;
 
-    char numbuf[64] = {0};
+    char numbuf[0x40 * 4 + 1] = {0};
 
     SwkbdState swkbd;
 
-    sprintf(numbuf, "%i", list->entries_count);
-    int max_chars = strlen(numbuf);
-    swkbdInit(&swkbd, SWKBD_TYPE_NUMPAD, 2, max_chars);
+    swkbdInit(&swkbd, SWKBD_TYPE_NORMAL, 2, 0x40);
 
-    sprintf(numbuf, "%i", list->selected_entry);
+    if(list->search_matches == NULL)
+        sprintf(numbuf, "%i", list->selected_entry);
     swkbdSetInitialText(&swkbd, numbuf);
 
     sprintf(numbuf, language.main.jump_q);
@@ -329,16 +494,51 @@ static void jump_menu(Entry_List_s * list)
 
     swkbdSetButton(&swkbd, SWKBD_BUTTON_LEFT, language.main.cancel, false);
     swkbdSetButton(&swkbd, SWKBD_BUTTON_RIGHT, language.main.jump, true);
-    swkbdSetValidation(&swkbd, SWKBD_NOTEMPTY_NOTBLANK, 0, max_chars);
+    swkbdSetValidation(&swkbd, SWKBD_ANYTHING, 0, 0);
     swkbdSetFilterCallback(&swkbd, jump_menu_callback, &list->entries_count);
 
     memset(numbuf, 0, sizeof(numbuf));
     SwkbdButton button = swkbdInputText(&swkbd, numbuf, sizeof(numbuf));
-    if(button == SWKBD_BUTTON_CONFIRM)
+    if(button != SWKBD_BUTTON_CONFIRM)
+        return;
+
+    if(is_position(numbuf))
     {
         list->selected_entry = atoi(numbuf) - 1;
         wait_scroll();
+        return;
     }
+
+    u16 query[0x41] = {0};
+    utf8_to_utf16(query, (u8 *)numbuf, 0x40);
+    if(!list_search(list, query))
+    {
+        throw_error(language.remote.no_results, ERROR_LEVEL_WARNING);
+        return;
+    }
+
+    show_list_from_top(list);
+}
+
+static void show_duplicates(Entry_List_s * list, const Duplicates_Job_s * job)
+{
+    if(job->thread != NULL && !job->done)
+    {
+        throw_error(language.main.duplicates_pending, ERROR_LEVEL_WARNING);
+        return;
+    }
+
+    u32 * groups = NULL;
+    const int groups_count = duplicates_group(job, list, &groups);
+    const bool shown = list_show_groups(list, groups, groups_count);
+    free(groups);
+    if(!shown)
+    {
+        throw_error(language.main.no_duplicates, ERROR_LEVEL_WARNING);
+        return;
+    }
+
+    show_list_from_top(list);
 }
 
 static void change_selected(Entry_List_s * list, int change_value)
@@ -356,7 +556,7 @@ static void change_selected(Entry_List_s * list, int change_value)
 
 static void toggle_shuffle(Entry_List_s * list)
 {
-    Entry_s * current_entry = &list->entries[list->selected_entry];
+    Entry_s * current_entry = list->entries[list->selected_entry];
     if(current_entry->in_shuffle)
     {
         if(current_entry->no_bgm_shuffle)
@@ -385,12 +585,11 @@ int main(void)
     language = init_strings(lang);
     init_screens();
 
-    svcCreateMutex(&update_icons_mutex, true);
+    icon_loader_init(&icon_loader);
 
     static Entry_List_s * current_list = NULL;
     void * iconLoadingThread_args_void[] = {
-        &current_list,
-        &update_icons_mutex,
+        &icon_loader,
     };
     iconLoadingThread_arg.thread_arg = iconLoadingThread_args_void;
     iconLoadingThread_arg.run_thread = false;
@@ -401,6 +600,7 @@ int main(void)
     #else
     load_lists(lists);
     #endif
+    trace_report("startup");
 
     EntryMode current_mode = MODE_THEMES;
 
@@ -464,18 +664,12 @@ int main(void)
             }
             else
             {
-                if(!released)
-                {
-                    svcReleaseMutex(update_icons_mutex);
-                    released = true;
-                }
-                svcWaitSynchronization(update_icons_mutex, U64_MAX);
+                update_icons(current_list, &icon_loader);
             }
 
             draw_interface(current_list, instructions, draw_mode);
 
             svcSleepThread(1e7);
-            released = false;
         }
 
         if (home_displayed)
@@ -522,6 +716,8 @@ int main(void)
                     }
                 }
             }
+            // nothing to act on, even when the last entry was just deleted
+            continue;
         }
         else if(!install_mode && !extra_mode)
         {
@@ -547,7 +743,7 @@ int main(void)
                     {
                         if(init_qr())
                         {
-                            load_lists(lists);
+                            add_saved_entries();
                         }
                     }
                     else
@@ -570,7 +766,12 @@ int main(void)
                 toggle_preview:
                 if(!preview_mode)
                 {
-                    preview_mode = load_preview(current_list, &preview, &preview_offset);
+                    if(current_list->entries == NULL)
+                        continue;
+
+                    Entry_Session_s session;
+                    entry_session_open(&session, current_list->entries[current_list->selected_entry]);
+                    preview_mode = load_preview(&session, &preview, &preview_offset);
                     if(preview_mode)
                     {
                         end_frame();
@@ -579,11 +780,12 @@ int main(void)
                         if(current_mode == MODE_THEMES && dspfirm)
                         {
                             audio = calloc(1, sizeof(audio_s));
-                            Result r = load_audio(&current_list->entries[current_list->selected_entry], audio);
+                            Result r = load_audio(&session, audio);
                             if (R_SUCCEEDED(r)) play_audio(audio);
                             else audio = NULL;
                         }
                     }
+                    entry_session_close(&session);
                 }
                 else
                 {
@@ -607,7 +809,10 @@ int main(void)
         }
 
         int selected_entry = current_list->selected_entry;
-        Entry_s * current_entry = &current_list->entries[selected_entry];
+        // a list that failed to load has no entries array at all
+        Entry_s * current_entry = NULL;
+        if(current_list->entries != NULL && current_list->entries_count != 0)
+            current_entry = current_list->entries[selected_entry];
 
         if(preview_mode || current_list->entries == NULL)
             goto touch;
@@ -661,10 +866,10 @@ int main(void)
                 draw_install(INSTALL_BGM);
                 if(R_SUCCEEDED(bgm_install(current_entry)))
                 {
-                    for(int i = 0; i < current_list->entries_count; i++)
+                    for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
                     {
             #define BETWEEN(min, x, max) (min < x && x < max)
-                        Entry_s * theme = &current_list->entries[i];
+                        Entry_s * theme = current_list->entries[i];
                         if(theme == current_entry)
                             theme->installed = true;
                         else
@@ -682,10 +887,10 @@ int main(void)
                 draw_install(INSTALL_SINGLE);
                 if(R_SUCCEEDED(theme_install(current_entry)))
                 {
-                    for(int i = 0; i < current_list->entries_count; i++)
+                    for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
 
                     {
-                        Entry_s * theme = &current_list->entries[i];
+                        Entry_s * theme = current_list->entries[i];
                         if(theme == current_entry)
                             theme->installed = true;
                         else
@@ -703,9 +908,9 @@ int main(void)
                 draw_install(INSTALL_NO_BGM);
                 if(R_SUCCEEDED(no_bgm_install(current_entry)))
                 {
-                    for(int i = 0; i < current_list->entries_count; i++)
+                    for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
                     {
-                        Entry_s * theme = &current_list->entries[i];
+                        Entry_s * theme = current_list->entries[i];
                         if(theme == current_entry)
                             theme->installed = true;
                         else
@@ -735,9 +940,9 @@ int main(void)
                     if(R_FAILED(res)) DEBUG("shuffle install result: %lx\n", res);
                     else
                     {
-                        for(int i = 0; i < current_list->entries_count; i++)
+                        for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
                         {
-                            Entry_s * theme = &current_list->entries[i];
+                            Entry_s * theme = current_list->entries[i];
                             if(theme->in_shuffle)
                             {
                                 theme->in_shuffle = false;
@@ -811,7 +1016,7 @@ int main(void)
                     if(themeplaza_browser((RemoteMode) current_mode))
                     {
                         current_mode = MODE_THEMES;
-                        load_lists(lists);
+                        add_saved_entries();
                     }
                     extra_mode = false;
                     draw_mode = DRAW_MODE_LIST;
@@ -841,6 +1046,7 @@ int main(void)
                     draw_mode = DRAW_MODE_LIST;
                     draw_install(INSTALL_BADGES);
                     install_badges();
+                    trace_report("install_badges");
                 }
                 else if (kDown & KEY_R)
                 {
@@ -880,6 +1086,13 @@ int main(void)
                     draw_mode = DRAW_MODE_LIST;
                     extra_index = 1;
                 }
+                else if(kDown & KEY_DRIGHT)
+                {
+                    show_duplicates(current_list, &duplicates_jobs[current_mode]);
+                    extra_mode = false;
+                    draw_mode = DRAW_MODE_LIST;
+                    extra_index = 1;
+                }
                 else if (kDown & KEY_B)
                 {
                     extra_index = 1;
@@ -892,8 +1105,9 @@ int main(void)
                     dump_single:
                     draw_install(INSTALL_DUMPING_THEME);
                     Result res = dump_current_theme();
+                    trace_report("dump_current_theme");
                     if (R_FAILED(res)) DEBUG("Dump theme result: %lx\n", res);
-                    else load_lists(lists);
+                    else add_saved_entries();
                     extra_mode = false;
                     draw_mode = DRAW_MODE_LIST;
                     extra_index = 1;
@@ -902,8 +1116,9 @@ int main(void)
                 {
                     draw_install(INSTALL_DUMPING_ALL_THEMES);
                     Result res = dump_all_themes();
+                    trace_report("dump_all_themes");
                     if (R_FAILED(res)) DEBUG("Dump all themes result: %lx\n", res);
-                    else load_lists(lists);
+                    else add_saved_entries();
                     extra_mode = false;
                     draw_mode = DRAW_MODE_LIST;
                     extra_index = 1;
@@ -912,6 +1127,7 @@ int main(void)
                 {
                     draw_install(INSTALL_DUMPING_BADGES);
                     extract_badges();
+                    trace_report("extract_badges");
                     extra_mode = false;
                     draw_mode = DRAW_MODE_LIST;
                     extra_index = 1;
@@ -937,9 +1153,10 @@ int main(void)
                 case MODE_SPLASHES:
                     draw_install(INSTALL_SPLASH);
                     splash_install(current_entry);
-                    for(int i = 0; i < current_list->entries_count; i++)
+                    trace_report("splash_install");
+                    for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
                     {
-                        Entry_s * splash = &current_list->entries[i];
+                        Entry_s * splash = current_list->entries[i];
                         if(splash == current_entry)
                             splash->installed = true;
                         else
@@ -979,7 +1196,7 @@ int main(void)
             {
                 draw_install(INSTALL_ENTRY_DELETE);
                 delete_entry(current_entry, current_entry->is_zip);
-                load_lists(lists);
+                remove_list_entry(current_mode, current_list->selected_entry);
             }
         }
 
@@ -1064,9 +1281,10 @@ int main(void)
                         {
                             draw_install(INSTALL_SPLASH);
                             splash_install(current_entry);
-                            for(int i = 0; i < current_list->entries_count; i++)
+                            trace_report("splash_install");
+                            for(int i = 0; i < current_list->entries_count + current_list->hidden_count; i++)
                             {
-                                Entry_s * splash = &current_list->entries[i];
+                                Entry_s * splash = current_list->entries[i];
                                 if(splash == current_entry)
                                     splash->installed = true;
                                 else
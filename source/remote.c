@@ -36,6 +36,7 @@
 #include "urls.h"
 #include "conversion.h"
 #include "ui_strings.h"
+#include "trace.h"
 
 char *last_search = NULL;
 json_int_t last_page = 1;
@@ -56,6 +57,7 @@ static void free_icons(Entry_List_s * list)
 /* Unnecessary with ThemePlaza providing smdh files for badges
 static void load_remote_metadata(Entry_s * entry)
 {
+    TRACE_SPAN("load_remote_metadata");
     char *page_json = NULL;
     char *api_url = NULL;
     asprintf(&api_url, THEMEPLAZA_QUERY_ENTRY_INFO, entry->tp_download_id);
@@ -89,8 +91,9 @@ static void load_remote_metadata(Entry_s * entry)
     }
 }
 */ 
-static void load_remote_smdh(Entry_s * entry, C3D_Tex * into_tex, const Entry_Icon_s * icon_info, bool ignore_cache)
+static void load_remote_smdh(Entry_s * entry, C3D_Tex * into_tex, const Entry_Icon_s * icon_info, Texture_Range_s * dirty, bool ignore_cache)
 {
+    TRACE_SPAN("load_remote_smdh");
     bool not_cached = true;
     char * smdh_buf = NULL;
     u32 smdh_size = load_data("/info.smdh", entry, &smdh_buf);
@@ -127,15 +130,12 @@ static void load_remote_smdh(Entry_s * entry, C3D_Tex * into_tex, const Entry_Ic
 
     if(smdh_buf != NULL)
     {
-        copy_texture_data(into_tex, smdh->big_icon, icon_info);
+        copy_texture_data(into_tex, smdh->big_icon, icon_info, dirty);
         if (not_cached)
         {
-            FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_UTF16, entry->path), FS_ATTRIBUTE_DIRECTORY);
-            u16 path[0x107] = { 0 };
-            strucat(path, entry->path);
-            struacat(path, "/info.smdh");
-            remake_file(fsMakePath(PATH_UTF16, path), ArchiveSD, smdh_size);
-            buf_to_file(smdh_size, fsMakePath(PATH_UTF16, path), ArchiveSD, smdh_buf);
+            u16 path[ENTRY_PATH_SIZE];
+            FSUSER_CreateDirectory(ArchiveSD, entry_path(entry, NULL, path), FS_ATTRIBUTE_DIRECTORY);
+            rewrite_file(entry_path(entry, "/info.smdh", path), ArchiveSD, smdh_size, smdh_buf, smdh_size);
         }
         free(smdh_buf);
     }
@@ -143,30 +143,44 @@ static void load_remote_smdh(Entry_s * entry, C3D_Tex * into_tex, const Entry_Ic
 
 static void load_remote_entries(Entry_List_s * list, json_t * ids_array, bool ignore_cache, InstallType type)
 {
-    free(list->entries);
-    list->entries_count = json_array_size(ids_array);
-    list->entries = calloc(list->entries_count, sizeof(Entry_s));
-    list->entries_loaded = list->entries_count;
+    TRACE_SPAN("load_remote_entries");
+    list_free_entries(list);
+    const int entries_count = json_array_size(ids_array);
+    list_init_capacity(list, entries_count);
+    list->entries_loaded = entries_count;
+    if(!list_set_prefix(list, CACHE_PATH))
+        return;
 
     size_t i = 0;
     json_t * id = NULL;
     json_array_foreach(ids_array, i, id)
     {
-        draw_loading_bar(i, list->entries_count, type);
-        Entry_s * current_entry = &list->entries[i];
+        draw_loading_bar(i, entries_count, type);
+        const ssize_t new_entry_index = list_add_entry(list);
+        if(new_entry_index < 0)
+            break;
+
+        Entry_s * current_entry = list->entries[new_entry_index];
         current_entry->tp_download_id = json_integer_value(id);
 
-        char * entry_path = NULL;
-        asprintf(&entry_path, CACHE_PATH_FORMAT, current_entry->tp_download_id);
-        utf8_to_utf16(current_entry->path, (u8 *)entry_path, 0x106);
-        free(entry_path);
+        char name[0x20] = {0};
+        u16 file_name[0x20] = {0};
+        snprintf(name, sizeof(name), CACHE_NAME_FORMAT, current_entry->tp_download_id);
+        utf8_to_utf16(file_name, (u8 *)name, 0x1f);
+        if(!list_set_file_name(list, current_entry, file_name, strulen(file_name, 0x1f)))
+        {
+            list_remove_entry(list, new_entry_index);
+            break;
+        }
 
-        load_remote_smdh(current_entry, &list->icons_texture, &list->icons_info[i], ignore_cache);
+        load_remote_smdh(current_entry, &list->icons_texture, &list->icons_info[i], &list->icons_dirty, ignore_cache);
     }
+    flush_texture_data(&list->icons_texture, &list->icons_dirty);
 }
 
 static void load_remote_list(Entry_List_s * list, json_int_t page, RemoteMode mode, bool ignore_cache)
 {
+    TRACE_SPAN("load_remote_list");
     if (page > list->tp_page_count)
         page = 1;
     if (page <= 0)
@@ -235,13 +249,16 @@ static void load_remote_list(Entry_List_s * list, json_int_t page, RemoteMode mo
     free(page_json);
 }
 
-static u16 previous_path_preview[0x106];
+static u16 previous_path_preview[ENTRY_PATH_SIZE];
 
 static bool load_remote_preview(const Entry_s * entry, C2D_Image * preview_image, int * preview_offset, u32 height)
 {
+    TRACE_SPAN("load_remote_preview");
     bool not_cached = true;
 
-    if (!memcmp(&previous_path_preview, entry->path, 0x106 * sizeof(u16))) return true;
+    u16 path[ENTRY_PATH_SIZE] = { 0 };
+    entry_path(entry, NULL, path);
+    if (!memcmp(previous_path_preview, path, sizeof(path))) return true;
 
     char * preview_png = NULL;
     u32 preview_size = load_data("/preview.png", entry, &preview_png);
@@ -284,11 +301,7 @@ static bool load_remote_preview(const Entry_s * entry, C2D_Image * preview_image
 
     if (ret && not_cached) // only save the preview if it loaded correctly - isn't corrupted
     {
-        u16 path[0x107] = { 0 };
-        strucat(path, entry->path);
-        struacat(path, "/preview.png");
-        remake_file(fsMakePath(PATH_UTF16, path), ArchiveSD, preview_size);
-        buf_to_file(preview_size, fsMakePath(PATH_UTF16, path), ArchiveSD, preview_png);
+        rewrite_file(entry_path(entry, "/preview.png", path), ArchiveSD, preview_size, preview_png, preview_size);
     }
 
     free(preview_png);
@@ -296,11 +309,14 @@ static bool load_remote_preview(const Entry_s * entry, C2D_Image * preview_image
     return ret;
 }
 
-static u16 previous_path_bgm[0x106];
+static u16 previous_path_bgm[ENTRY_PATH_SIZE];
 
 static void load_remote_bgm(const Entry_s * entry)
 {
-    if (!memcmp(&previous_path_bgm, entry->path, 0x106 * sizeof(u16))) return;
+    TRACE_SPAN("load_remote_bgm");
+    u16 path[ENTRY_PATH_SIZE] = { 0 };
+    entry_path(entry, NULL, path);
+    if (!memcmp(previous_path_bgm, path, sizeof(path))) return;
 
     char * bgm_ogg = NULL;
     u32 bgm_size = load_data("/bgm.ogg", entry, &bgm_ogg);
@@ -323,13 +339,8 @@ static void load_remote_bgm(const Entry_s * entry)
         if (R_SUMMARY(res) == RS_NOTFOUND && R_MODULE(res) == RM_FILE_SERVER)
             return;
 
-        u16 path[0x107] = { 0 };
-        strucat(path, entry->path);
-        struacat(path, "/bgm.ogg");
-        remake_file(fsMakePath(PATH_UTF16, path), ArchiveSD, bgm_size);
-        buf_to_file(bgm_size, fsMakePath(PATH_UTF16, path), ArchiveSD, bgm_ogg);
-
-        memcpy(&previous_path_bgm, entry->path, 0x106 * sizeof(u16));
+        memcpy(previous_path_bgm, path, sizeof(path));
+        rewrite_file(entry_path(entry, "/bgm.ogg", path), ArchiveSD, bgm_size, bgm_ogg, bgm_size);
     }
 
     free(bgm_ogg);
@@ -337,6 +348,7 @@ static void load_remote_bgm(const Entry_s * entry)
 
 static void download_remote_entry(Entry_s * entry, RemoteMode mode)
 {
+    TRACE_SPAN("download_remote_entry");
     char * download_url = NULL;
     asprintf(&download_url, THEMEPLAZA_DOWNLOAD_FORMAT, entry->tp_download_id);
 
@@ -616,7 +628,7 @@ bool themeplaza_browser(RemoteMode mode)
         }
 
         int selected_entry = current_list->selected_entry;
-        Entry_s * current_entry = &current_list->entries[selected_entry];
+        Entry_s * current_entry = current_list->entries[selected_entry];
 
         if (kDown & KEY_Y)
         {
@@ -793,10 +805,11 @@ bool themeplaza_browser(RemoteMode mode)
     free_preview(preview);
 
     free_icons(current_list);
-    free(current_list->entries);
+    list_free_entries(current_list);
     free(current_list->tp_search);
     free(last_search);
 
+    trace_report("remote_browse");
     return downloaded;
 }
 
@@ -1136,6 +1149,7 @@ static int64_t curl_http_get(const char * url, char ** out_filename, char ** buf
 
 static Result http_get_with_not_found_flag(const char * url, char ** filename, char ** buf, u32 * size, InstallType install_type, const char * acceptable_mime_types, bool not_found_is_error)
 {
+    TRACE_SPAN("http_get");
     const char *zip_not_available = language.remote.zip_not_found;
     Result ret;
     httpcContext context;
@@ -0,0 +1,167 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "search_index.h"
+
+#define SEARCH_GRAM_SIZE 3
+
+static inline u32 gram_bucket(const u8 * gram)
+{
+    return ((gram[0] * 961) + (gram[1] * 31) + gram[2]) & (SEARCH_BUCKETS - 1);
+}
+
+static bool contains(const u8 * text, u32 text_len, const u8 * query, u32 query_len)
+{
+    if(query_len > text_len)
+        return false;
+
+    const u8 * const last = text + text_len - query_len;
+    for(const u8 * p = text; p <= last; ++p)
+    {
+        p = memchr(p, query[0], last - p + 1);
+        if(p == NULL)
+            return false;
+        if(!memcmp(p, query, query_len))
+            return true;
+    }
+
+    return false;
+}
+
+bool search_index_build(Search_Index_s * index, u8 * texts, u32 * text_offsets, u32 count)
+{
+    memset(index, 0, sizeof(Search_Index_s));
+    index->texts = texts;
+    index->text_offsets = text_offsets;
+    index->count = count;
+
+    // the last entry that went into each bucket, so an entry is listed once per bucket
+    u32 * last_added = malloc(SEARCH_BUCKETS * sizeof(u32));
+    index->bucket_starts = calloc(SEARCH_BUCKETS + 1, sizeof(u32));
+    if(last_added == NULL || index->bucket_starts == NULL)
+        goto fail;
+
+    memset(last_added, 0xFF, SEARCH_BUCKETS * sizeof(u32));
+    u32 postings_count = 0;
+    for(u32 i = 0; i < count; ++i)
+    {
+        for(u32 j = text_offsets[i]; j + SEARCH_GRAM_SIZE <= text_offsets[i + 1]; ++j)
+        {
+            const u32 bucket = gram_bucket(texts + j);
+            if(last_added[bucket] == i)
+                continue;
+            last_added[bucket] = i;
+            index->bucket_starts[bucket + 1]++;
+            postings_count++;
+        }
+    }
+
+    for(u32 b = 0; b < SEARCH_BUCKETS; ++b)
+        index->bucket_starts[b + 1] += index->bucket_starts[b];
+
+    index->postings = malloc(postings_count * sizeof(u32));
+    if(postings_count != 0 && index->postings == NULL)
+        goto fail;
+
+    // fill each bucket from its end, going through the entries backwards keeps them ascending
+    memset(last_added, 0xFF, SEARCH_BUCKETS * sizeof(u32));
+    for(u32 i = count; i-- > 0;)
+    {
+        for(u32 j = text_offsets[i]; j + SEARCH_GRAM_SIZE <= text_offsets[i + 1]; ++j)
+        {
+            const u32 bucket = gram_bucket(texts + j);
+            if(last_added[bucket] == i)
+                continue;
+            last_added[bucket] = i;
+            index->postings[--index->bucket_starts[bucket + 1]] = i;
+        }
+    }
+
+    // bucket_starts[b + 1] was walked back from the end of bucket b to its start
+    memmove(index->bucket_starts, index->bucket_starts + 1, SEARCH_BUCKETS * sizeof(u32));
+    index->bucket_starts[SEARCH_BUCKETS] = postings_count;
+
+    free(last_added);
+    return true;
+
+    fail:
+    free(last_added);
+    search_index_free(index);
+    return false;
+}
+
+u32 search_index_query(const Search_Index_s * index, const u8 * query, u32 query_len, u8 * matches)
+{
+    memset(matches, 0, index->count);
+    if(query_len == 0)
+        return 0;
+
+    u32 matched = 0;
+    if(query_len < SEARCH_GRAM_SIZE)
+    {
+        for(u32 i = 0; i < index->count; ++i)
+        {
+            const u32 start = index->text_offsets[i];
+            if(contains(index->texts + start, index->text_offsets[i + 1] - start, query, query_len))
+            {
+                matches[i] = 1;
+                matched++;
+            }
+        }
+        return matched;
+    }
+
+    // every match has all the trigrams of the query, so the smallest of their buckets holds them all
+    u32 rarest = gram_bucket(query);
+    for(u32 j = 1; j + SEARCH_GRAM_SIZE <= query_len; ++j)
+    {
+        const u32 bucket = gram_bucket(query + j);
+        if(index->bucket_starts[bucket + 1] - index->bucket_starts[bucket] < index->bucket_starts[rarest + 1] - index->bucket_starts[rarest])
+            rarest = bucket;
+    }
+
+    for(u32 p = index->bucket_starts[rarest]; p < index->bucket_starts[rarest + 1]; ++p)
+    {
+        const u32 i = index->postings[p];
+        const u32 start = index->text_offsets[i];
+        if(contains(index->texts + start, index->text_offsets[i + 1] - start, query, query_len))
+        {
+            matches[i] = 1;
+            matched++;
+        }
+    }
+
+    return matched;
+}
+
+void search_index_free(Search_Index_s * index)
+{
+    free(index->postings);
+    free(index->bucket_starts);
+    free(index->text_offsets);
+    free(index->texts);
+    memset(index, 0, sizeof(Search_Index_s));
+}
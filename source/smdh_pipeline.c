@@ -0,0 +1,174 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "smdh_pipeline.h"
+#include "loading.h"
+#include "ui_feedback.h"
+#include "trace.h"
+
+typedef struct {
+    int index;
+    u32 pack_position;
+    Zip_Entry_s member; // compressed_size is 0 when data is the file itself
+    char * data;
+    u32 data_size;
+} Smdh_Job_s;
+
+typedef struct {
+    Entry_List_s * list;
+    Icon_Pack_s * pack;
+
+    Smdh_Job_s jobs[SMDH_PIPELINE_SLOTS];
+    u32 jobs_taken; // both only ever go up, the slot is the count modulo SMDH_PIPELINE_SLOTS
+    u32 jobs_added;
+    bool reading_done;
+
+    LightLock lock;
+    CondVar job_added;
+    CondVar job_taken;
+} Smdh_Pipeline_s;
+
+static void parse_job(const Smdh_Pipeline_s * pipeline, Smdh_Job_s * job)
+{
+    Icon_s * icon = NULL;
+    Icon_s * inflated = NULL;
+    if(job->member.compressed_size != 0)
+    {
+        if(job->member.size == sizeof(Icon_s) && (inflated = malloc(sizeof(Icon_s))) != NULL
+            && zip_inflate(&job->member, (const u8 *)job->data, (u8 *)inflated))
+            icon = inflated;
+    }
+    else if(job->data_size == sizeof(Icon_s))
+    {
+        icon = (Icon_s *)job->data;
+    }
+
+    Entry_s * const entry = pipeline->list->entries[job->index];
+    parse_smdh(icon, entry, entry->file_name);
+    if(pipeline->pack != NULL)
+    {
+        if(icon != NULL)
+            icon_pack_write(pipeline->pack, job->pack_position, icon->big_icon);
+        entry->pack_icon = icon != NULL ? job->pack_position + 1 : ENTRY_NO_ICON;
+    }
+
+    free(inflated);
+    free(job->data);
+}
+
+static void smdh_worker(void * arg)
+{
+    Smdh_Pipeline_s * pipeline = (Smdh_Pipeline_s *)arg;
+    while(true)
+    {
+        LightLock_Lock(&pipeline->lock);
+        while(pipeline->jobs_taken == pipeline->jobs_added && !pipeline->reading_done)
+            CondVar_Wait(&pipeline->job_added, &pipeline->lock);
+
+        if(pipeline->jobs_taken == pipeline->jobs_added)
+        {
+            LightLock_Unlock(&pipeline->lock);
+            break;
+        }
+
+        Smdh_Job_s job = pipeline->jobs[pipeline->jobs_taken++ % SMDH_PIPELINE_SLOTS];
+        CondVar_Signal(&pipeline->job_taken);
+        LightLock_Unlock(&pipeline->lock);
+
+        parse_job(pipeline, &job);
+    }
+}
+
+static void add_job(Smdh_Pipeline_s * pipeline, const Smdh_Job_s * job)
+{
+    LightLock_Lock(&pipeline->lock);
+    while(pipeline->jobs_added - pipeline->jobs_taken == SMDH_PIPELINE_SLOTS)
+        CondVar_Wait(&pipeline->job_taken, &pipeline->lock);
+
+    pipeline->jobs[pipeline->jobs_added++ % SMDH_PIPELINE_SLOTS] = *job;
+    CondVar_Signal(&pipeline->job_added);
+    LightLock_Unlock(&pipeline->lock);
+}
+
+void smdh_pipeline_run(Entry_List_s * list, const int * indices, int count, InstallType loading_screen, Icon_Pack_s * pack)
+{
+    TRACE_SPAN("smdh_pipeline");
+    Smdh_Pipeline_s pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.list = list;
+    pipeline.pack = pack;
+    const u32 pack_first = pack != NULL ? icon_pack_reserve(pack, count) : 0;
+    LightLock_Init(&pipeline.lock);
+    CondVar_Init(&pipeline.job_added);
+    CondVar_Init(&pipeline.job_taken);
+
+    // a lower priority than the reader, so the worker sharing its core only runs while it waits on the SD
+    s32 priority = 0x30;
+    svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+
+    Thread workers[SMDH_PIPELINE_MAX_WORKERS];
+    int workers_count = 0;
+    for(int core = 0; core < SMDH_PIPELINE_MAX_WORKERS; ++core)
+    {
+        // fails on cores the app isn't allowed to use
+        Thread worker = threadCreate(smdh_worker, &pipeline, SMDH_PIPELINE_STACK_SIZE, priority + 1, core, false);
+        if(worker != NULL)
+            workers[workers_count++] = worker;
+    }
+    DEBUG("smdh pipeline: %i workers\n", workers_count);
+
+    const int loading_bar_ticks = count / 10;
+    for(int i = 0, j = 0; i < count; ++i)
+    {
+        if(++j >= loading_bar_ticks)
+        {
+            j = 0;
+            draw_loading_bar(i, count, loading_screen);
+        }
+
+        Smdh_Job_s job = {.index = indices[i], .pack_position = pack_first + i};
+        Entry_Session_s session;
+        entry_session_open(&session, list->entries[job.index]);
+        job.data_size = entry_session_load_deflated(&session, "/info.smdh", &job.data, &job.member);
+        entry_session_close(&session);
+
+        if(workers_count != 0)
+            add_job(&pipeline, &job);
+        else
+            parse_job(&pipeline, &job);
+    }
+
+    LightLock_Lock(&pipeline.lock);
+    pipeline.reading_done = true;
+    CondVar_Broadcast(&pipeline.job_added);
+    LightLock_Unlock(&pipeline.lock);
+
+    for(int i = 0; i < workers_count; ++i)
+    {
+        threadJoin(workers[i], U64_MAX);
+        threadFree(workers[i]);
+    }
+}
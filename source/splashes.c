@@ -28,6 +28,7 @@
 #include "fs.h"
 #include "draw.h"
 #include "ui_strings.h"
+#include "trace.h"
 
 void splash_delete(void)
 {
@@ -37,20 +38,23 @@ void splash_delete(void)
 
 void splash_install(const Entry_s * splash)
 {
+    TRACE_SPAN("splash_install");
     char *screen_buf = NULL;
 
-    u32 size = load_data("/splash.bin", splash, &screen_buf);
+    Entry_Session_s session;
+    entry_session_open(&session, splash);
+
+    u32 size = entry_session_load(&session, "/splash.bin", &screen_buf);
     if(size != 0)
     {
-        remake_file(fsMakePath(PATH_ASCII, "/luma/splash.bin"), ArchiveSD, size);
-        buf_to_file(size, fsMakePath(PATH_ASCII, "/luma/splash.bin"), ArchiveSD, screen_buf);
+        rewrite_file(fsMakePath(PATH_ASCII, "/luma/splash.bin"), ArchiveSD, size, screen_buf, size);
     }
 
-    u32 bottom_size = load_data("/splashbottom.bin", splash, &screen_buf);
+    u32 bottom_size = entry_session_load(&session, "/splashbottom.bin", &screen_buf);
+    entry_session_close(&session);
     if(bottom_size != 0)
     {
-        remake_file(fsMakePath(PATH_ASCII, "/luma/splashbottom.bin"), ArchiveSD, bottom_size);
-        buf_to_file(bottom_size, fsMakePath(PATH_ASCII, "/luma/splashbottom.bin"), ArchiveSD, screen_buf);
+        rewrite_file(fsMakePath(PATH_ASCII, "/luma/splashbottom.bin"), ArchiveSD, bottom_size, screen_buf, bottom_size);
     }
 
     if(size == 0 && bottom_size == 0)
@@ -103,9 +107,12 @@ void splash_check_installed(void * void_arg)
 
     for(int i = 0; i < list->entries_count && arg->run_thread; i++)
     {
-        Entry_s * splash = &list->entries[i];
-        top_size = load_data("/splash.bin", splash, &top_buf);
-        bottom_size = load_data("/splashbottom.bin", splash, &bottom_buf);
+        Entry_s * splash = list->entries[i];
+        Entry_Session_s session;
+        entry_session_open(&session, splash);
+        top_size = entry_session_load(&session, "/splash.bin", &top_buf);
+        bottom_size = entry_session_load(&session, "/splashbottom.bin", &bottom_buf);
+        entry_session_close(&session);
 
         if(!top_size && !bottom_size)
         {
@@ -27,19 +27,22 @@
 #include "themes.h"
 #include "unicode.h"
 #include "fs.h"
-#include "draw.h"
+#include "ui_feedback.h"
 #include "ui_strings.h"
+#include "iostats.h"
+#include "trace.h"
+#include "write_batch.h"
 
 #define BODY_CACHE_SIZE 0x150000
 #define BGM_MAX_SIZE 0x337000
 
 static Result install_theme_internal(const Entry_List_s * themes, int installmode)
 {
+    TRACE_SPAN("install_theme");
     Result res = 0;
     char * music = NULL;
     u32 music_size = 0;
     u32 shuffle_music_sizes[MAX_SHUFFLE_THEMES] = {0};
-    char * body = NULL;
     u32 body_size = 0;
     u32 shuffle_body_sizes[MAX_SHUFFLE_THEMES] = {0};
     bool mono_audio = false;
@@ -63,37 +66,59 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
         int shuffle_count = 0;
         draw_loading_bar(shuffle_count, themes->shuffle_count + 1, INSTALL_SHUFFLE);
         Handle body_cache_handle;
+        Write_Batch_s body_cache_batch;
 
         if(installmode & THEME_INSTALL_BODY)
         {
-            remake_file(fsMakePath(PATH_ASCII, "/BodyCache_rd.bin"), ArchiveThemeExt, BODY_CACHE_SIZE * MAX_SHUFFLE_THEMES);
-            FSUSER_OpenFile(&body_cache_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, "/BodyCache_rd.bin"), FS_OPEN_WRITE, 0);
+            IOSTATS_PHASE("shuffle_body_cache");
+            TRACE_SPAN("shuffle_body_cache");
+            // every slot gets written once, by its theme or zeroed after the loop
+            create_file_sized(fsMakePath(PATH_ASCII, "/BodyCache_rd.bin"), ArchiveThemeExt, BODY_CACHE_SIZE * MAX_SHUFFLE_THEMES);
+            vfs_open_file(&body_cache_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, "/BodyCache_rd.bin"), FS_OPEN_WRITE);
+            // one flush for all the slots once they're written
+            write_batch_begin(&body_cache_batch, body_cache_handle);
         }
 
-        for(int i = 0; i < themes->entries_count; i++)
+        // themes hidden by a search are still part of the shuffle
+        for(int i = 0; i < themes->entries_count + themes->hidden_count; i++)
         {
-            const Entry_s * current_theme = &themes->entries[i];
+            const Entry_s * current_theme = themes->entries[i];
 
             if(current_theme->in_shuffle)
             {
+                Entry_Session_s session;
+                entry_session_open(&session, current_theme);
+
                 if(installmode & THEME_INSTALL_BODY)
                 {
-                    body_size = load_data("/body_LZ.bin", current_theme, &body);
+                    IOSTATS_PHASE("shuffle_body");
+                    TRACE_SPAN("shuffle_body");
+                    // read straight into the padded buffer, no need for a copy of the body
+                    padded = calloc(BODY_CACHE_SIZE, sizeof(char));
+                    body_size = entry_session_load_into(&session, "/body_LZ.bin", padded, BODY_CACHE_SIZE);
                     if(body_size == 0)
                     {
-                        free(body);
+                        entry_session_close(&session);
+                        write_batch_abort(&body_cache_batch);
+                        vfs_close(body_cache_handle);
+                        free(padded);
                         DEBUG("body not found\n");
                         throw_error(language.themes.no_body_found, ERROR_LEVEL_WARNING);
                         return MAKERESULT(RL_PERMANENT, RS_CANCELED, RM_APPLICATION, RD_NOT_FOUND);
                     }
+                    if(body_size > BODY_CACHE_SIZE)
+                    {
+                        entry_session_close(&session);
+                        write_batch_abort(&body_cache_batch);
+                        vfs_close(body_cache_handle);
+                        free(padded);
+                        DEBUG("body too big\n");
+                        return MAKERESULT(RL_PERMANENT, RS_CANCELED, RM_APPLICATION, RD_TOO_LARGE);
+                    }
 
                     shuffle_body_sizes[shuffle_count] = body_size;
 
-                    padded = calloc(BODY_CACHE_SIZE, sizeof(char));
-                    memcpy(padded, body, body_size);
-                    free(body);
-
-                    FSFILE_Write(body_cache_handle, NULL, BODY_CACHE_SIZE * shuffle_count, padded, BODY_CACHE_SIZE, FS_WRITE_FLUSH);
+                    write_batch_write(&body_cache_batch, BODY_CACHE_SIZE * shuffle_count, padded, BODY_CACHE_SIZE);
 
                     free(padded);
                     padded = NULL;
@@ -101,28 +126,36 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
 
                 if(installmode & THEME_INSTALL_BGM)
                 {
+                    IOSTATS_PHASE("shuffle_bgm");
+                    TRACE_SPAN("shuffle_bgm");
                     char bgm_cache_path[26] = {0};
                     sprintf(bgm_cache_path, "/BgmCache_%.2i.bin", shuffle_count);
 
+                    padded = calloc(BGM_MAX_SIZE, sizeof(char));
                     if(current_theme->no_bgm_shuffle)
                     {
-                        music = NULL;
                         music_size = 0;
                     }
                     else
                     {
-                        music_size = load_data("/bgm.bcstm", current_theme, &music);
+                        music_size = entry_session_load_into(&session, "/bgm.bcstm", padded, BGM_MAX_SIZE);
 
                         if(music_size > BGM_MAX_SIZE)
                         {
-                            free(music);
+                            entry_session_close(&session);
+                            if(installmode & THEME_INSTALL_BODY)
+                            {
+                                write_batch_abort(&body_cache_batch);
+                                vfs_close(body_cache_handle);
+                            }
+                            free(padded);
                             DEBUG("bgm too big\n");
                             return MAKERESULT(RL_PERMANENT, RS_CANCELED, RM_APPLICATION, RD_TOO_LARGE);
                         }
 
-                        if (music_size > 0)
+                        if (music_size > 0x62)
                         {
-                            if (music[0x62] == 1)
+                            if (padded[0x62] == 1)
                             {
                                 mono_audio = true;
                             }
@@ -130,25 +163,12 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
                     }
 
                     shuffle_music_sizes[shuffle_count] = music_size;
-                    remake_file(fsMakePath(PATH_ASCII, bgm_cache_path), ArchiveThemeExt, BGM_MAX_SIZE);
-
-                    Handle bgm_cache_handle;
-                    FSUSER_OpenFile(&bgm_cache_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, bgm_cache_path), FS_OPEN_WRITE, 0);
-
-                    padded = calloc(BGM_MAX_SIZE, sizeof(char));
-                    if(!current_theme->no_bgm_shuffle && music_size)
-                    {
-                        memcpy(padded, music, music_size);
-                        free(music);
-                    }
-
-                    FSFILE_Write(bgm_cache_handle, NULL, 0, padded, BGM_MAX_SIZE, FS_WRITE_FLUSH);
-
-                    FSFILE_Close(bgm_cache_handle);
+                    rewrite_file(fsMakePath(PATH_ASCII, bgm_cache_path), ArchiveThemeExt, BGM_MAX_SIZE, padded, BGM_MAX_SIZE);
                     free(padded);
                     padded = NULL;
                 }
 
+                entry_session_close(&session);
                 shuffle_count++;
                 draw_loading_bar(shuffle_count, themes->shuffle_count + 1, INSTALL_SHUFFLE);
             }
@@ -156,46 +176,65 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
 
         if(installmode & THEME_INSTALL_BGM)
         {
-            char * blank = calloc(BGM_MAX_SIZE, sizeof(char));
+            IOSTATS_PHASE("shuffle_blank_bgm");
+            TRACE_SPAN("shuffle_blank_bgm");
             for(int i = shuffle_count; i < MAX_SHUFFLE_THEMES; i++)
             {
                 char bgm_cache_path[26] = {0};
                 sprintf(bgm_cache_path, "/BgmCache_%.2i.bin", i);
                 remake_file(fsMakePath(PATH_ASCII, bgm_cache_path), ArchiveThemeExt, BGM_MAX_SIZE);
-                buf_to_file(BGM_MAX_SIZE, fsMakePath(PATH_ASCII, bgm_cache_path), ArchiveThemeExt, blank);
             }
-            free(blank);
         }
 
         if(installmode & THEME_INSTALL_BODY)
         {
-            FSFILE_Close(body_cache_handle);
+            zero_handle_range(body_cache_handle, BODY_CACHE_SIZE * shuffle_count, BODY_CACHE_SIZE * (MAX_SHUFFLE_THEMES - shuffle_count));
+            write_batch_commit(&body_cache_batch);
+            vfs_close(body_cache_handle);
         }
     }
     else
     {
-        const Entry_s * current_theme = &themes->entries[themes->selected_entry];
+        const Entry_s * current_theme = themes->entries[themes->selected_entry];
+        Entry_Session_s session;
+        entry_session_open(&session, current_theme);
 
         if(installmode & THEME_INSTALL_BODY)
         {
-            body_size = load_data("/body_LZ.bin", current_theme, &body);
+            IOSTATS_PHASE("body");
+            TRACE_SPAN("body");
+            // the body goes from the entry to BodyCache.bin in chunks, without loading it whole
+            Handle body_cache_handle;
+            if(R_FAILED(res = vfs_open_file(&body_cache_handle, ArchiveThemeExt, fsMakePath(PATH_ASCII, "/BodyCache.bin"), FS_OPEN_WRITE)))
+            {
+                entry_session_close(&session);
+                return res;
+            }
+            body_size = entry_session_copy_to_file(&session, "/body_LZ.bin", body_cache_handle, 0, BODY_CACHE_SIZE);
+            vfs_close(body_cache_handle);
+
             if(body_size == 0)
             {
-                free(body);
+                entry_session_close(&session);
                 DEBUG("body not found\n");
                 throw_error(language.themes.no_body_found, ERROR_LEVEL_WARNING);
                 return MAKERESULT(RL_PERMANENT, RS_CANCELED, RM_APPLICATION, RD_NOT_FOUND);
             }
-
-            res = buf_to_file(body_size, fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, body); // Write body data to file
-            free(body);
-
-            if(R_FAILED(res)) return res;
+            if(body_size > BODY_CACHE_SIZE)
+            {
+                entry_session_close(&session);
+                DEBUG("body too big\n");
+                return MAKERESULT(RL_PERMANENT, RS_CANCELED, RM_APPLICATION, RD_TOO_LARGE);
+            }
         }
 
         if(installmode & THEME_INSTALL_BGM)
         {
-            music_size = load_data("/bgm.bcstm", current_theme, &music);
+            IOSTATS_PHASE("bgm");
+            TRACE_SPAN("bgm");
+            music = calloc(BGM_MAX_SIZE, sizeof(char));
+            music_size = entry_session_load_into(&session, "/bgm.bcstm", music, BGM_MAX_SIZE);
+            entry_session_close(&session);
             if (music_size > BGM_MAX_SIZE)
             {
                 free(music);
@@ -205,30 +244,63 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
 
             if (music_size != 0)
             {
-                if (music[0x62] == 1)
+                if (music_size > 0x62 && music[0x62] == 1)
                 {
                     mono_audio = true;
                 }
 
-                remake_file(fsMakePath(PATH_ASCII, "/BgmCache.bin"), ArchiveThemeExt, BGM_MAX_SIZE);
-                res = buf_to_file(music_size, fsMakePath(PATH_ASCII, "/BgmCache.bin"), ArchiveThemeExt, music);
+                res = rewrite_file(fsMakePath(PATH_ASCII, "/BgmCache.bin"), ArchiveThemeExt, BGM_MAX_SIZE, music, music_size);
                 free(music);
 
-                char * body_buf = NULL;
-                u32 uncompressed_size = decompress_lz_file(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, &body_buf);
-                if (body_buf != NULL && body_buf[5] != 1)
+                IOSTATS_PHASE("bgm_flag");
+                TRACE_SPAN("bgm_flag");
+                // the body has to have its BGM flag (offset 5 of the decompressed data) set,
+                // which usually only takes rewriting a few bytes of the compressed BodyCache.bin
+                u32 current_body_size = body_size;
+                if (!(installmode & THEME_INSTALL_BODY))
+                {
+                    char * thememanage_buf = NULL;
+                    if (file_to_buf(fsMakePath(PATH_ASCII, "/ThemeManage.bin"), ArchiveThemeExt, &thememanage_buf) != 0)
+                        current_body_size = ((ThemeManage_bin_s *)thememanage_buf)->body_size;
+                    free(thememanage_buf);
+                }
+
+                u32 patched_size = patch_lz_file(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, current_body_size, 5, 1);
+                if (patched_size != 0)
                 {
                     installmode |= THEME_INSTALL_BODY;
-                    body_buf[5] = 1;
-                    body_size = compress_lz_file_fast(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, body_buf, uncompressed_size);
+                    body_size = patched_size;
                 }
-                    
-                free(body_buf);
+                else
+                {
+                    // the whole body only has to be decompressed when the flag isn't there already
+                    u8 bgm_flag = 0;
+                    if (!read_lz_file_byte(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, 5, &bgm_flag) || bgm_flag != 1)
+                    {
+                        char * body_buf = NULL;
+                        u32 uncompressed_size = decompress_lz_file(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, &body_buf);
+                        if (body_buf != NULL && body_buf[5] != 1)
+                        {
+                            installmode |= THEME_INSTALL_BODY;
+                            body_buf[5] = 1;
+                            body_size = compress_lz_file(fsMakePath(PATH_ASCII, "/BodyCache.bin"), ArchiveThemeExt, body_buf, uncompressed_size);
+                        }
+
+                        free(body_buf);
+                    }
+                }
+            }
+            else
+            {
+                free(music);
             }
 
             if(R_FAILED(res)) return res;
         } else
         {
+            IOSTATS_PHASE("bgm");
+            TRACE_SPAN("bgm");
+            entry_session_close(&session);
             music = calloc(BGM_MAX_SIZE, 1);
             res = buf_to_file(BGM_MAX_SIZE, fsMakePath(PATH_ASCII, "/BgmCache.bin"), ArchiveThemeExt, music);
             free(music);
@@ -236,6 +308,8 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
     }
 
      //----------------------------------------
+    IOSTATS_PHASE("theme_manage");
+    TRACE_SPAN("theme_manage");
     char * thememanage_buf = NULL;
     file_to_buf(fsMakePath(PATH_ASCII, "/ThemeManage.bin"), ArchiveThemeExt, &thememanage_buf);
     ThemeManage_bin_s * theme_manage = (ThemeManage_bin_s *)thememanage_buf;
@@ -273,6 +347,8 @@ static Result install_theme_internal(const Entry_List_s * themes, int installmod
     //----------------------------------------
 
     //----------------------------------------
+    IOSTATS_PHASE("save_data");
+    TRACE_SPAN("save_data");
     char * savedata_buf = NULL;
     u32 savedata_size = file_to_buf(fsMakePath(PATH_ASCII, "/SaveData.dat"), ArchiveHomeExt, &savedata_buf);
     SaveData_dat_s * savedata = (SaveData_dat_s *)savedata_buf;
@@ -313,32 +389,44 @@ Result theme_install(Entry_s * theme)
 {
     Entry_List_s list = {0};
     list.entries_count = 1;
-    list.entries = theme;
+    list.entries = &theme;
     list.selected_entry = 0;
-    return install_theme_internal(&list, THEME_INSTALL_BODY | THEME_INSTALL_BGM);
+    const Result res = install_theme_internal(&list, THEME_INSTALL_BODY | THEME_INSTALL_BGM);
+    iostats_report("theme_install");
+    trace_report("theme_install");
+    return res;
 }
 
 Result bgm_install(Entry_s * theme)
 {
     Entry_List_s list = {0};
     list.entries_count = 1;
-    list.entries = theme;
+    list.entries = &theme;
     list.selected_entry = 0;
-    return install_theme_internal(&list, THEME_INSTALL_BGM);
+    const Result res = install_theme_internal(&list, THEME_INSTALL_BGM);
+    iostats_report("bgm_install");
+    trace_report("bgm_install");
+    return res;
 }
 
 Result no_bgm_install(Entry_s * theme)
 {
     Entry_List_s list = {0};
     list.entries_count = 1;
-    list.entries = theme;
+    list.entries = &theme;
     list.selected_entry = 0;
-    return install_theme_internal(&list, THEME_INSTALL_BODY);
+    const Result res = install_theme_internal(&list, THEME_INSTALL_BODY);
+    iostats_report("no_bgm_install");
+    trace_report("no_bgm_install");
+    return res;
 }
 
 Result shuffle_install(const Entry_List_s * themes)
 {
-    return install_theme_internal(themes, THEME_INSTALL_SHUFFLE | THEME_INSTALL_BODY | THEME_INSTALL_BGM);
+    const Result res = install_theme_internal(themes, THEME_INSTALL_SHUFFLE | THEME_INSTALL_BODY | THEME_INSTALL_BGM);
+    iostats_report("shuffle_install");
+    trace_report("shuffle_install");
+    return res;
 }
 
 static SwkbdCallbackResult
@@ -356,6 +444,7 @@ dir_name_callback(void * data, const char ** ppMessage, const char * text, size_
 
 Result dump_current_theme(void)
 {
+    TRACE_SPAN("dump_current_theme");
     const int max_chars = 255;
     char * output_dir = calloc(max_chars + 1, sizeof(char));
 
@@ -380,7 +469,7 @@ Result dump_current_theme(void)
     u16 path[0x107] = { 0 };
     struacat(path, main_paths[REMOTE_MODE_THEMES]);
     struacat(path, output_dir);
-    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_UTF16, path), FS_ATTRIBUTE_DIRECTORY);
+    vfs_create_dir(ArchiveSD, fsMakePath(PATH_UTF16, path));
 
     char * thememanage_buf = NULL;
     file_to_buf(fsMakePath(PATH_ASCII, "/ThemeManage.bin"), ArchiveThemeExt, &thememanage_buf);
@@ -394,16 +483,14 @@ Result dump_current_theme(void)
     u16 path_output[0x107] = { 0 };
     memcpy(path_output, path, 0x107);
     struacat(path_output, "/body_LZ.bin");
-    remake_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, theme_size);
-    buf_to_file(theme_size, fsMakePath(PATH_UTF16, path_output), ArchiveSD, temp_buf);
+    rewrite_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, theme_size, temp_buf, theme_size);
     free(temp_buf);
     temp_buf = NULL;
 
     file_to_buf(fsMakePath(PATH_ASCII, "/BgmCache.bin"), ArchiveThemeExt, &temp_buf);
     memcpy(path_output, path, 0x107);
     struacat(path_output, "/bgm.bcstm");
-    remake_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, bgm_size);
-    buf_to_file(bgm_size, fsMakePath(PATH_UTF16, path_output), ArchiveSD, temp_buf);
+    rewrite_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, bgm_size, temp_buf, bgm_size);
     free(temp_buf);
     temp_buf = NULL;
 
@@ -433,16 +520,17 @@ Result dump_current_theme(void)
     
     memcpy(path_output, path, 0x107);
     struacat(path_output, "/info.smdh");
-    remake_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, 0x36c0);
-    buf_to_file(0x36c0, fsMakePath(PATH_UTF16, path_output), ArchiveSD, smdh_file);
+    rewrite_file(fsMakePath(PATH_UTF16, path_output), ArchiveSD, 0x36c0, smdh_file, 0x36c0);
 
     free(smdh_file);
+    note_saved_entry(REMOTE_MODE_THEMES, path, false);
 
     return 0;
 }
 
 Result dump_all_themes(void)
 {
+    TRACE_SPAN("dump_all_themes");
     const u32 high_id = 0x0004008c;
     u32 low_id = 0;
     u8 regionCode, language;
@@ -542,7 +630,7 @@ Result dump_all_themes(void)
         ncch_path.data = archivePath;
 
         FS_Archive ncch_archive;
-        res = FSUSER_OpenArchive(&ncch_archive, ARCHIVE_SAVEDATA_AND_CONTENT, ncch_path);
+        res = vfs_open_archive(&ncch_archive, ARCHIVE_SAVEDATA_AND_CONTENT, ncch_path);
         if(R_FAILED(res))
         {
             free(contentInfos);
@@ -556,10 +644,10 @@ Result dump_all_themes(void)
         metadata_path.data = metadataPath;
 
         Handle metadata_fh;
-        res = FSUSER_OpenFile(&metadata_fh, ncch_archive, metadata_path, FS_OPEN_READ, 0);
+        res = vfs_open_file(&metadata_fh, ncch_archive, metadata_path, FS_OPEN_READ);
         if(R_FAILED(res))
         {
-            FSUSER_CloseArchive(ncch_archive);
+            vfs_close_archive(ncch_archive);
             free(contentInfos);
             break;
         }
@@ -567,8 +655,8 @@ Result dump_all_themes(void)
         res = romfsMountFromFile(metadata_fh, 0, "meta");
         if(R_FAILED(res))
         {
-            FSFILE_Close(metadata_fh);
-            FSUSER_CloseArchive(ncch_archive);
+            vfs_close(metadata_fh);
+            vfs_close_archive(ncch_archive);
             free(contentInfos);
             break;
         }
@@ -596,7 +684,7 @@ Result dump_all_themes(void)
                     metadataPath[1] = content->index;
 
                     Handle theme_fh;
-                    res = FSUSER_OpenFile(&theme_fh, ncch_archive, metadata_path, FS_OPEN_READ, 0);
+                    res = vfs_open_file(&theme_fh, ncch_archive, metadata_path, FS_OPEN_READ);
                     if(R_FAILED(res))
                     {
                         DEBUG("theme open romfs error: %08lx\n", res);
@@ -616,7 +704,7 @@ Result dump_all_themes(void)
                     char path[0x107] = { 0 };
                     sprintf(path, "%sDump-%02lx-%ld-%s", main_paths[REMOTE_MODE_THEMES], dlc_index, extra_index, themename);
                     DEBUG("theme folder to create: %s\n", path);
-                    FSUSER_CreateDirectory(ArchiveSD, fsMakePath(PATH_ASCII, path), FS_ATTRIBUTE_DIRECTORY);
+                    vfs_create_dir(ArchiveSD, fsMakePath(PATH_ASCII, path));
 
                     memset(smdh_data->name, 0, sizeof(smdh_data->name));
                     utf8_to_utf16(smdh_data->name, (u8 *)(content_data + 0), 0x40);
@@ -633,8 +721,7 @@ Result dump_all_themes(void)
 
                         char themepath[0x107] = {0};
                         sprintf(themepath, "%s/body_LZ.bin", path);
-                        remake_file(fsMakePath(PATH_ASCII, themepath), ArchiveSD, theme_size);
-                        buf_to_file(theme_size, fsMakePath(PATH_ASCII, themepath), ArchiveSD, theme_data);
+                        rewrite_file(fsMakePath(PATH_ASCII, themepath), ArchiveSD, theme_size, theme_data, theme_size);
                         free(theme_data);
                     }
 
@@ -650,8 +737,7 @@ Result dump_all_themes(void)
 
                         char bgmpath[0x107] = {0};
                         sprintf(bgmpath, "%s/bgm.bcstm", path);
-                        remake_file(fsMakePath(PATH_ASCII, bgmpath), ArchiveSD, bgm_size);
-                        buf_to_file(bgm_size, fsMakePath(PATH_ASCII, bgmpath), ArchiveSD, bgm_data);
+                        rewrite_file(fsMakePath(PATH_ASCII, bgmpath), ArchiveSD, bgm_size, bgm_data, bgm_size);
                         free(bgm_data);
                     }
 
@@ -662,9 +748,12 @@ Result dump_all_themes(void)
                     fread(smdh_data->big_icon, 1, sizeof(smdh_data->big_icon), iconfile);
                     fclose(iconfile);
 
+                    u16 folder_path[0x106] = {0};
+                    utf8_to_utf16(folder_path, (u8 *)path, 0x105);
+                    note_saved_entry(REMOTE_MODE_THEMES, folder_path, false);
+
                     strcat(path, "/info.smdh");
-                    remake_file(fsMakePath(PATH_ASCII, path), ArchiveSD, 0x36c0);
-                    buf_to_file(0x36c0, fsMakePath(PATH_ASCII, path), ArchiveSD, (char *)smdh_data);
+                    rewrite_file(fsMakePath(PATH_ASCII, path), ArchiveSD, 0x36c0, (char *)smdh_data, 0x36c0);
                 }
             }
 
@@ -676,7 +765,7 @@ Result dump_all_themes(void)
 
         romfsUnmount("meta");
         // don't need to close the file opened for the metadata, romfsUnmount took ownership
-        FSUSER_CloseArchive(ncch_archive);
+        vfs_close_archive(ncch_archive);
     }
 
     free(smdh_data);
@@ -739,7 +828,7 @@ void themes_check_installed(void * void_arg)
     int total_installed = 0;
     for(int i = 0; i < list->entries_count && total_installed < MAX_SHUFFLE_THEMES && arg->run_thread; i++)
     {
-        Entry_s * theme = &list->entries[i];
+        Entry_s * theme = list->entries[i];
         char * theme_body = NULL;
         u32 theme_body_size = load_data("/body_LZ.bin", theme, &theme_body);
         if(!theme_body_size) return;
@@ -0,0 +1,175 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "trace.h"
+
+#ifdef TRACE
+
+#include <jansson.h>
+
+#include "fs.h"
+
+#ifdef __3DS__
+#define TRACE_TICKS_PER_US (SYSCLOCK_ARM11 / 1000000)
+typedef LightLock Trace_Lock;
+#define trace_lock_init(lock) LightLock_Init(lock)
+#define trace_lock(lock) LightLock_Lock(lock)
+#define trace_unlock(lock) LightLock_Unlock(lock)
+#else
+#include <pthread.h>
+#include <time.h>
+#define TRACE_TICKS_PER_US 1000
+typedef pthread_mutex_t Trace_Lock;
+#define trace_lock_init(lock) pthread_mutex_init(lock, NULL)
+#define trace_lock(lock) pthread_mutex_lock(lock)
+#define trace_unlock(lock) pthread_mutex_unlock(lock)
+#endif
+
+#define TRACE_MAX_EVENTS 1024
+
+typedef struct {
+    const char * name;
+    u64 start;
+    u64 ticks;
+    u32 thread;
+} Trace_Event_s;
+
+static Trace_Event_s events[TRACE_MAX_EVENTS];
+static u32 events_first;
+static u32 events_count;
+static u32 overwritten;
+static u64 origin;
+static u32 threads_count;
+
+static Trace_Lock lock;
+static bool lock_ready;
+
+static __thread u32 current_thread;
+
+u64 trace_now(void)
+{
+#ifdef __3DS__
+    const u64 now = svcGetSystemTick();
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    const u64 now = (u64)time.tv_sec * 1000000000 + time.tv_nsec;
+#endif
+    // the first span starts on the main thread, before any worker is started
+    if(!lock_ready)
+    {
+        trace_lock_init(&lock);
+        lock_ready = true;
+        origin = now;
+    }
+    return now;
+}
+
+void trace_end_span(const Trace_Span_s * span)
+{
+    const u64 ticks = trace_now() - span->start;
+    trace_lock(&lock);
+    // threads are numbered in the order they first end a span, the main thread being 1
+    if(current_thread == 0)
+        current_thread = ++threads_count;
+
+    Trace_Event_s * event;
+    if(events_count == TRACE_MAX_EVENTS)
+    {
+        event = &events[events_first];
+        events_first = (events_first + 1) % TRACE_MAX_EVENTS;
+        overwritten++;
+    }
+    else
+    {
+        event = &events[(events_first + events_count) % TRACE_MAX_EVENTS];
+        events_count++;
+    }
+
+    event->name = span->name;
+    event->start = span->start;
+    event->ticks = ticks;
+    event->thread = current_thread;
+    trace_unlock(&lock);
+}
+
+static void save_json(json_t * root, const char * what)
+{
+    char * json = json_dumps(root, JSON_COMPACT);
+    if(json == NULL)
+        return;
+
+    char path[0x80] = {0};
+    snprintf(path, sizeof(path), "/3ds/" APP_TITLE "/trace_%s.json", what);
+    const u32 size = strlen(json);
+    rewrite_file(fsMakePath(PATH_ASCII, path), ArchiveSD, size, json, size);
+    free(json);
+}
+
+void trace_report(const char * what)
+{
+    if(!lock_ready)
+        return;
+
+    trace_lock(&lock);
+    json_t * root = json_object();
+    json_t * json_events = json_array();
+    json_t * json_other = json_object();
+    json_object_set_new(json_other, "what", json_string(what));
+    json_object_set_new(json_other, "overwritten", json_integer(overwritten));
+    json_object_set_new(root, "otherData", json_other);
+    json_object_set_new(root, "displayTimeUnit", json_string("ms"));
+
+    DEBUG("Trace for %s (%lu spans, %lu overwritten):\n", what, events_count, overwritten);
+    for(u32 i = 0; i < events_count; ++i)
+    {
+        const Trace_Event_s * const event = &events[(events_first + i) % TRACE_MAX_EVENTS];
+        const u64 start_us = (event->start - origin) / TRACE_TICKS_PER_US;
+        const u64 duration_us = event->ticks / TRACE_TICKS_PER_US;
+        DEBUG("%-24s thread %lu at %10llu us for %10llu us\n", event->name, event->thread, start_us, duration_us);
+
+        // complete events, with both their start and duration
+        json_t * json_event = json_object();
+        json_object_set_new(json_event, "name", json_string(event->name));
+        json_object_set_new(json_event, "ph", json_string("X"));
+        json_object_set_new(json_event, "ts", json_integer(start_us));
+        json_object_set_new(json_event, "dur", json_integer(duration_us));
+        json_object_set_new(json_event, "pid", json_integer(1));
+        json_object_set_new(json_event, "tid", json_integer(event->thread));
+        json_array_append_new(json_events, json_event);
+    }
+    json_object_set_new(root, "traceEvents", json_events);
+
+    events_first = 0;
+    events_count = 0;
+    overwritten = 0;
+    trace_unlock(&lock);
+
+    save_json(root, what);
+    json_decref(root);
+}
+
+#endif
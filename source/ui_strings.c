@@ -108,7 +108,7 @@ const Language_s language_english = {
                 },
                 {
                     "\uE07B Sort by filename",
-                    NULL
+                    "\uE07C Group duplicates"
                 },
                 {
                     NULL,
@@ -236,7 +236,7 @@ const Language_s language_english = {
     {
         .position_too_big = "The new position has to be\nsmaller or equal to the\nnumber of entries!",
         .position_zero = "The new position has to\nbe positive!",
-        .jump_q = "Where do you want to jump to?\nMay cause icons to reload.",
+        .jump_q = "Position to jump to, or text to search for.\nLeave empty to show everything.",
         .cancel = "Cancel",
         .jump = "Jump",
         .no_theme_extdata = "Theme extdata does not exist!\nSet a default theme from the home menu.",
@@ -248,6 +248,8 @@ const Language_s language_english = {
         .not_enough_themes = "You don't have enough themes selected.",
         .uninstall_confirm = "Are you sure you would like to delete\nthe installed splash?",
         .delete_confirm = "Are you sure you would like to delete this?",
+        .duplicates_pending = "Still looking for duplicates,\ntry again in a moment.",
+        .no_duplicates = "No duplicates found.",
     },
     .remote =
     {
@@ -517,7 +519,7 @@ const Language_s language_spanish = {
                 },
                 {
                     "\uE07B Ordenar por nombre de archivo",
-                    NULL
+                    "\uE07C Agrupar duplicados"
                 },
                 {
                     NULL,
@@ -645,7 +647,7 @@ const Language_s language_spanish = {
     {
         .position_too_big = "La nueva posición debe ser\nmenor o igual al\nnúmero de entradas.",
         .position_zero = "La nueva posición debe ser\npositiva.",
-        .jump_q = "¿A dónde quieres saltar?\nPuede hacer que los iconos se recarguen.",
+        .jump_q = "Posición a la que saltar, o texto a buscar.\nDéjalo vacío para mostrar todo.",
         .cancel = "Cancelar",
         .jump = "Saltar",
         .no_theme_extdata = "¡Los datos de tema extensos no existen!\nEstablece un tema predeterminado desde el menú principal.",
@@ -657,6 +659,8 @@ const Language_s language_spanish = {
         .not_enough_themes = "No tienes suficientes temas seleccionados.",
         .uninstall_confirm = "¿Estás seguro de que deseas eliminar\nel fondo instalado?",
         .delete_confirm = "¿Estás seguro de que deseas eliminar esto?",
+        .duplicates_pending = "Aún se están buscando duplicados,\ninténtalo de nuevo en un momento.",
+        .no_duplicates = "No se encontraron duplicados.",
     },
     .remote =
     {
@@ -927,7 +931,7 @@ const Language_s language_french = {
                 },
                 {
                     "\uE07B par nom de fichier",
-                    NULL
+                    "\uE07C Grouper les doublons"
                 },
                 {
                     NULL,
@@ -1055,7 +1059,7 @@ const Language_s language_french = {
     {
         .position_too_big = "La nouvelle position doit\nêtre + petite ou égale au\nnombre d'entrées!",
         .position_zero = "La nouvelle position\ndoit être positive!",
-        .jump_q = "Où voulez vous aller?\nCela actualisera les icônes.",
+        .jump_q = "Position où aller, ou texte à rechercher.\nLaissez vide pour tout afficher.",
         .cancel = "Annuler",
         .jump = "OK",
         .no_theme_extdata = "Les données additionnelles des thèmes\nn'existe pas! Changez de thème\ndepuis le menu home puis réessayez.",
@@ -1067,6 +1071,8 @@ const Language_s language_french = {
         .not_enough_themes = "Il n'y a pas assez de thèmes sélectionnés.",
         .uninstall_confirm = "Voulez-vous supprimer le splash\nactuellement installé?",
         .delete_confirm = "Voulez-vous supprimer ceci?",
+        .duplicates_pending = "Recherche des doublons en cours,\nréessayez dans un instant.",
+        .no_duplicates = "Aucun doublon trouvé.",
     },
     .remote =
     {
@@ -1336,7 +1342,7 @@ const Language_s language_portuguese = {
                 },
                 {
                     "\uE07B Classificar por arquivo",
-                    NULL
+                    "\uE07C Agrupar duplicados"
                 },
                 {
                     NULL,
@@ -1464,7 +1470,7 @@ const Language_s language_portuguese = {
     {
         .position_too_big = "A nova posição deve ser\nmenor ou igual ao\nnúmero de entradas!",
         .position_zero = "A nova posição precisa\nser positiva!",
-        .jump_q = "Para qual página deseja ir?\nPode causar recarregamento de ícones.",
+        .jump_q = "Posição para onde ir, ou texto a pesquisar.\nDeixe vazio para mostrar tudo.",
         .cancel = "Cancelar",
         .jump = "Ir",
         .no_theme_extdata = "O extdata do tema não existe!\nDefina um tema padrão no menu HOME.",
@@ -1476,6 +1482,8 @@ const Language_s language_portuguese = {
         .not_enough_themes = "Você não tem temas suficientes selecionados.",
         .uninstall_confirm = "Tem certeza de que deseja excluir\no splash instalado?",
         .delete_confirm = "Tem certeza de que deseja excluir isso?",
+        .duplicates_pending = "Ainda procurando duplicados,\ntente novamente em um momento.",
+        .no_duplicates = "Nenhum duplicado encontrado.",
     },
     .remote =
     {
@@ -1747,7 +1755,7 @@ const Language_s language_korean = {
                 },
                 {
                     "\uE07B Sort by filename",
-                    NULL
+                    "\uE07C Group duplicates"
                 },
                 {
                     NULL,
@@ -1875,7 +1883,7 @@ const Language_s language_korean = {
     {
         .position_too_big = "The new position has to be\nsmaller or equal to the\nnumber of entries!",
         .position_zero = "The new position has to\nbe positive!",
-        .jump_q = "Where do you want to jump to?\nMay cause icons to reload.",
+        .jump_q = "Position to jump to, or text to search for.\nLeave empty to show everything.",
         .cancel = "Cancel",
         .jump = "Jump",
         // Note to translator: This is a special case, please translate this string instead of the original one.
@@ -1888,6 +1896,8 @@ const Language_s language_korean = {
         .not_enough_themes = "You don't have enough themes selected.",
         .uninstall_confirm = "Are you sure you would like to delete\nthe installed splash?",
         .delete_confirm = "Are you sure you would like\nto delete this?",
+        .duplicates_pending = "Still looking for duplicates,\ntry again in a moment.",
+        .no_duplicates = "No duplicates found.",
     },
     .remote =
     {
@@ -2157,7 +2167,7 @@ const Language_s language_SChinese = {
                 },
                 {
                     "\uE07B 按文件名排序",
-                    NULL
+                    "\uE07C 归类重复项"
                 },
                 {
                     NULL,
@@ -2285,7 +2295,7 @@ const Language_s language_SChinese = {
     {
         .position_too_big = "跳转项必须小于或等于跳转项!",
         .position_zero = "跳转项必须可用!",
-        .jump_q = "请输入跳转项\n图标可能会重新加载",
+        .jump_q = "请输入跳转项或搜索内容\n留空以显示全部",
         .cancel = "取消",
         .jump = "跳转",
         .no_theme_extdata = "主题的追加数据不存在!\n请从Home菜单设置一个主题",
@@ -2297,6 +2307,8 @@ const Language_s language_SChinese = {
         .not_enough_themes = "你没有足够的主题可以选择",
         .uninstall_confirm = "真的要删除已安装的开机图画吗?",
         .delete_confirm = "真的要删除这个?",
+        .duplicates_pending = "仍在查找重复项,\n请稍后再试",
+        .no_duplicates = "没有找到重复项",
     },
     .remote =
     {
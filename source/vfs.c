@@ -0,0 +1,680 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "vfs.h"
+#include "iostats.h"
+
+#ifdef __3DS__
+
+Result vfs_open_archive(FS_Archive * archive, FS_ArchiveID id, FS_Path path)
+{
+    return FSUSER_OpenArchive(archive, id, path);
+}
+
+Result vfs_close_archive(FS_Archive archive)
+{
+    return FSUSER_CloseArchive(archive);
+}
+
+static Result backend_open_file(Handle * file, FS_Archive archive, FS_Path path, u32 flags)
+{
+    return FSUSER_OpenFile(file, archive, path, flags, 0);
+}
+
+static Result backend_close(Handle file)
+{
+    return FSFILE_Close(file);
+}
+
+static Result backend_read(Handle file, u32 * read, u64 offset, void * buf, u32 size)
+{
+    return FSFILE_Read(file, read, offset, buf, size);
+}
+
+static Result backend_write(Handle file, u32 * written, u64 offset, const void * buf, u32 size, u32 flags)
+{
+    return FSFILE_Write(file, written, offset, buf, size, flags);
+}
+
+Result vfs_flush(Handle file)
+{
+    return FSFILE_Flush(file);
+}
+
+Result vfs_get_size(Handle file, u64 * size)
+{
+    return FSFILE_GetSize(file, size);
+}
+
+Result vfs_set_size(Handle file, u64 size)
+{
+    return FSFILE_SetSize(file, size);
+}
+
+static Result backend_create_file(FS_Archive archive, FS_Path path, u64 size)
+{
+    return FSUSER_CreateFile(archive, path, 0, size);
+}
+
+static Result backend_delete_file(FS_Archive archive, FS_Path path)
+{
+    return FSUSER_DeleteFile(archive, path);
+}
+
+Result vfs_create_dir(FS_Archive archive, FS_Path path)
+{
+    return FSUSER_CreateDirectory(archive, path, FS_ATTRIBUTE_DIRECTORY);
+}
+
+Result vfs_delete_dir_recursively(FS_Archive archive, FS_Path path)
+{
+    return FSUSER_DeleteDirectoryRecursively(archive, path);
+}
+
+Result vfs_get_mtime(FS_Archive archive, FS_Path path, u64 * mtime)
+{
+    if(path.type != PATH_UTF16)
+        return MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_FS, RD_NOT_IMPLEMENTED);
+
+    return FSUSER_ControlArchive(archive, ARCHIVE_ACTION_GET_TIMESTAMP, (void *)path.data, path.size, mtime, sizeof(u64));
+}
+
+static Result backend_open_dir(Handle * dir, FS_Archive archive, FS_Path path)
+{
+    return FSUSER_OpenDirectory(dir, archive, path);
+}
+
+static Result backend_read_dir(Handle dir, u32 * read, u32 count, FS_DirectoryEntry * entries)
+{
+    return FSDIR_Read(dir, read, count, entries);
+}
+
+static Result backend_close_dir(Handle dir)
+{
+    return FSDIR_Close(dir);
+}
+
+#else
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// same codes fs:USER gives, the callers compare against some of them
+#define VFS_RES_NOT_FOUND       ((Result)0xC8804478)
+#define VFS_RES_ALREADY_EXISTS  ((Result)0xC82044BE)
+#define VFS_RES_DISK_FULL       ((Result)0xC86044D2)
+#define VFS_RES_FAILURE         MAKERESULT(RL_PERMANENT, RS_INTERNAL, RM_FS, RD_INVALID_RESULT_VALUE)
+#define VFS_RES_UNSUPPORTED     MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_FS, RD_NOT_IMPLEMENTED)
+#define VFS_RES_BAD_HANDLE      MAKERESULT(RL_PERMANENT, RS_INVALIDARG, RM_FS, RD_INVALID_HANDLE)
+
+#define VFS_MAX_ARCHIVES 8
+#define VFS_MAX_DIRS 16
+// keeps directory handles apart from file descriptors
+#define VFS_DIR_HANDLE_BASE 0x10000
+
+static char * archive_roots[VFS_MAX_ARCHIVES];
+static DIR * open_dirs[VFS_MAX_DIRS];
+
+static Result errno_result(int err)
+{
+    switch(err)
+    {
+        case ENOENT:
+        case ENOTDIR:
+            return VFS_RES_NOT_FOUND;
+        case EEXIST:
+        case ENOTEMPTY:
+            return VFS_RES_ALREADY_EXISTS;
+        case ENOSPC:
+            return VFS_RES_DISK_FULL;
+        default:
+            return VFS_RES_FAILURE;
+    }
+}
+
+static size_t utf16_to_host(char * out, size_t out_size, const u16 * in, size_t in_len)
+{
+    size_t pos = 0;
+    for(size_t i = 0; i < in_len && in[i] != 0; ++i)
+    {
+        u32 c = in[i];
+        if(c >= 0xD800 && c < 0xDC00 && i + 1 < in_len && in[i + 1] >= 0xDC00 && in[i + 1] < 0xE000)
+            c = 0x10000 + ((c - 0xD800) << 10) + (in[++i] - 0xDC00);
+
+        u8 bytes[4];
+        size_t count;
+        if(c < 0x80)
+        {
+            bytes[0] = c;
+            count = 1;
+        }
+        else if(c < 0x800)
+        {
+            bytes[0] = 0xC0 | (c >> 6);
+            bytes[1] = 0x80 | (c & 0x3F);
+            count = 2;
+        }
+        else if(c < 0x10000)
+        {
+            bytes[0] = 0xE0 | (c >> 12);
+            bytes[1] = 0x80 | ((c >> 6) & 0x3F);
+            bytes[2] = 0x80 | (c & 0x3F);
+            count = 3;
+        }
+        else
+        {
+            bytes[0] = 0xF0 | (c >> 18);
+            bytes[1] = 0x80 | ((c >> 12) & 0x3F);
+            bytes[2] = 0x80 | ((c >> 6) & 0x3F);
+            bytes[3] = 0x80 | (c & 0x3F);
+            count = 4;
+        }
+
+        if(pos + count >= out_size)
+            break;
+        memcpy(out + pos, bytes, count);
+        pos += count;
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+static void host_to_utf16(u16 * out, size_t out_len, const char * in)
+{
+    const u8 * s = (const u8 *)in;
+    size_t pos = 0;
+    while(*s && pos + 1 < out_len)
+    {
+        u32 c;
+        if(*s < 0x80)
+            c = *s++;
+        else if((*s & 0xE0) == 0xC0 && s[1])
+        {
+            c = ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+            s += 2;
+        }
+        else if((*s & 0xF0) == 0xE0 && s[1] && s[2])
+        {
+            c = ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+            s += 3;
+        }
+        else if((*s & 0xF8) == 0xF0 && s[1] && s[2] && s[3])
+        {
+            c = ((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+            s += 4;
+        }
+        else
+        {
+            c = '?';
+            s++;
+        }
+
+        if(c >= 0x10000)
+        {
+            if(pos + 2 >= out_len)
+                break;
+            c -= 0x10000;
+            out[pos++] = 0xD800 | (c >> 10);
+            out[pos++] = 0xDC00 | (c & 0x3FF);
+        }
+        else
+        {
+            out[pos++] = c;
+        }
+    }
+    out[pos] = 0;
+}
+
+// host builds don't link libctru, which is where this normally comes from
+FS_Path fsMakePath(FS_PathType type, const void * path)
+{
+    FS_Path p = {type, 0, path};
+    switch(type)
+    {
+        case PATH_ASCII:
+            p.size = strlen(path) + 1;
+            break;
+        case PATH_UTF16:
+        {
+            const u16 * str = path;
+            while(*str++) p.size++;
+            p.size = (p.size + 1) * 2;
+            break;
+        }
+        case PATH_EMPTY:
+            p.size = 1;
+            p.data = "";
+            break;
+        default:
+            break;
+    }
+    return p;
+}
+
+static bool host_path(char * out, size_t out_size, FS_Archive archive, FS_Path path)
+{
+    if(archive == 0 || archive > VFS_MAX_ARCHIVES || archive_roots[archive - 1] == NULL)
+        return false;
+
+    const int root_len = snprintf(out, out_size, "%s", archive_roots[archive - 1]);
+    if(root_len < 0 || (size_t)root_len >= out_size)
+        return false;
+
+    switch(path.type)
+    {
+        case PATH_EMPTY:
+            return true;
+        case PATH_ASCII:
+            return (size_t)snprintf(out + root_len, out_size - root_len, "%s", (const char *)path.data) < out_size - root_len;
+        case PATH_UTF16:
+            utf16_to_host(out + root_len, out_size - root_len, path.data, path.size / sizeof(u16));
+            return true;
+        default:
+            return false;
+    }
+}
+
+Result vfs_open_archive(FS_Archive * archive, FS_ArchiveID id, FS_Path path)
+{
+    const char * base = getenv("ANEMONE_VFS_ROOT");
+    if(base == NULL)
+        base = "vfs";
+
+    char root[PATH_MAX];
+    if(id == ARCHIVE_SDMC)
+    {
+        snprintf(root, sizeof(root), "%s/sdmc", base);
+    }
+    else if(id == ARCHIVE_EXTDATA && path.type == PATH_BINARY && path.size >= 0x8)
+    {
+        const u32 * const extdata_path = path.data;
+        snprintf(root, sizeof(root), "%s/extdata/%08lx", base, (unsigned long)extdata_path[1]);
+    }
+    else
+    {
+        return VFS_RES_UNSUPPORTED;
+    }
+
+    struct stat st;
+    if(stat(root, &st) != 0)
+        return errno_result(errno);
+    if(!S_ISDIR(st.st_mode))
+        return VFS_RES_NOT_FOUND;
+
+    for(u32 i = 0; i < VFS_MAX_ARCHIVES; ++i)
+    {
+        if(archive_roots[i] != NULL)
+            continue;
+
+        archive_roots[i] = strdup(root);
+        if(archive_roots[i] == NULL)
+            return VFS_RES_FAILURE;
+        *archive = i + 1;
+        return 0;
+    }
+
+    return VFS_RES_FAILURE;
+}
+
+Result vfs_close_archive(FS_Archive archive)
+{
+    if(archive == 0 || archive > VFS_MAX_ARCHIVES || archive_roots[archive - 1] == NULL)
+        return VFS_RES_BAD_HANDLE;
+
+    free(archive_roots[archive - 1]);
+    archive_roots[archive - 1] = NULL;
+    return 0;
+}
+
+static Result backend_open_file(Handle * file, FS_Archive archive, FS_Path path, u32 flags)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    int mode = O_RDONLY;
+    if((flags & FS_OPEN_READ) && (flags & FS_OPEN_WRITE))
+        mode = O_RDWR;
+    else if(flags & FS_OPEN_WRITE)
+        mode = O_WRONLY;
+    if(flags & FS_OPEN_CREATE)
+        mode |= O_CREAT;
+
+    const int fd = open(full_path, mode, 0666);
+    if(fd < 0)
+        return errno_result(errno);
+
+    *file = fd;
+    return 0;
+}
+
+static Result backend_close(Handle file)
+{
+    return close(file) == 0 ? 0 : errno_result(errno);
+}
+
+static Result backend_read(Handle file, u32 * read, u64 offset, void * buf, u32 size)
+{
+    u32 total = 0;
+    while(total < size)
+    {
+        const ssize_t done = pread(file, (u8 *)buf + total, size - total, offset + total);
+        if(done < 0 && errno == EINTR)
+            continue;
+        if(done < 0)
+            return errno_result(errno);
+        if(done == 0)
+            break;
+        total += done;
+    }
+
+    if(read != NULL)
+        *read = total;
+    return 0;
+}
+
+// flushing is left to the kernel, so syncs don't dominate host timings
+static Result backend_write(Handle file, u32 * written, u64 offset, const void * buf, u32 size, u32 flags)
+{
+    (void)flags;
+
+    u32 total = 0;
+    while(total < size)
+    {
+        const ssize_t done = pwrite(file, (const u8 *)buf + total, size - total, offset + total);
+        if(done < 0 && errno == EINTR)
+            continue;
+        if(done <= 0)
+            return errno_result(done < 0 ? errno : ENOSPC);
+        total += done;
+    }
+
+    if(written != NULL)
+        *written = total;
+    return 0;
+}
+
+Result vfs_flush(Handle file)
+{
+    (void)file;
+    return 0;
+}
+
+Result vfs_get_size(Handle file, u64 * size)
+{
+    struct stat st;
+    if(fstat(file, &st) != 0)
+        return errno_result(errno);
+
+    *size = st.st_size;
+    return 0;
+}
+
+Result vfs_set_size(Handle file, u64 size)
+{
+    return ftruncate(file, size) == 0 ? 0 : errno_result(errno);
+}
+
+static Result backend_create_file(FS_Archive archive, FS_Path path, u64 size)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    const int fd = open(full_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if(fd < 0)
+        return errno_result(errno);
+
+    Result res = 0;
+    if(ftruncate(fd, size) != 0)
+        res = errno_result(errno);
+    close(fd);
+    return res;
+}
+
+static Result backend_delete_file(FS_Archive archive, FS_Path path)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    return unlink(full_path) == 0 ? 0 : errno_result(errno);
+}
+
+Result vfs_create_dir(FS_Archive archive, FS_Path path)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    return mkdir(full_path, 0777) == 0 ? 0 : errno_result(errno);
+}
+
+static int remove_tree_entry(const char * path, const struct stat * st, int type, struct FTW * ftw)
+{
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+Result vfs_delete_dir_recursively(FS_Archive archive, FS_Path path)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    return nftw(full_path, remove_tree_entry, 16, FTW_DEPTH | FTW_PHYS) == 0 ? 0 : errno_result(errno);
+}
+
+Result vfs_get_mtime(FS_Archive archive, FS_Path path, u64 * mtime)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    struct stat st;
+    if(stat(full_path, &st) != 0)
+        return errno_result(errno);
+
+    *mtime = (u64)st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000;
+    return 0;
+}
+
+static Result backend_open_dir(Handle * dir, FS_Archive archive, FS_Path path)
+{
+    char full_path[PATH_MAX];
+    if(!host_path(full_path, sizeof(full_path), archive, path))
+        return VFS_RES_NOT_FOUND;
+
+    for(u32 i = 0; i < VFS_MAX_DIRS; ++i)
+    {
+        if(open_dirs[i] != NULL)
+            continue;
+
+        open_dirs[i] = opendir(full_path);
+        if(open_dirs[i] == NULL)
+            return errno_result(errno);
+        *dir = VFS_DIR_HANDLE_BASE + i;
+        return 0;
+    }
+
+    return VFS_RES_FAILURE;
+}
+
+// fills in what fs:USER would for a FAT entry: the 8.3 name upper-cased,
+// which the callers use to check extensions
+static void fill_dir_entry(FS_DirectoryEntry * entry, DIR * dir, const char * name)
+{
+    memset(entry, 0, sizeof(FS_DirectoryEntry));
+    host_to_utf16(entry->name, sizeof(entry->name) / sizeof(u16), name);
+
+    const char * const ext = strrchr(name, '.');
+    const size_t base_len = ext != NULL && ext != name ? (size_t)(ext - name) : strlen(name);
+    for(size_t i = 0; i < base_len && i < sizeof(entry->shortName) - 2; ++i)
+        entry->shortName[i] = toupper((unsigned char)name[i]);
+    if(ext != NULL && ext != name)
+    {
+        for(size_t i = 0; ext[i + 1] && i < sizeof(entry->shortExt) - 1; ++i)
+            entry->shortExt[i] = toupper((unsigned char)ext[i + 1]);
+    }
+    entry->valid = 1;
+
+    struct stat st;
+    if(fstatat(dirfd(dir), name, &st, 0) == 0)
+    {
+        if(S_ISDIR(st.st_mode))
+            entry->attributes |= FS_ATTRIBUTE_DIRECTORY;
+        else
+            entry->fileSize = st.st_size;
+    }
+    if(name[0] == '.')
+        entry->attributes |= FS_ATTRIBUTE_HIDDEN;
+}
+
+static Result backend_read_dir(Handle dir, u32 * read, u32 count, FS_DirectoryEntry * entries)
+{
+    if(dir < VFS_DIR_HANDLE_BASE || dir >= VFS_DIR_HANDLE_BASE + VFS_MAX_DIRS || open_dirs[dir - VFS_DIR_HANDLE_BASE] == NULL)
+        return VFS_RES_BAD_HANDLE;
+
+    DIR * const host_dir = open_dirs[dir - VFS_DIR_HANDLE_BASE];
+    u32 filled = 0;
+    while(filled < count)
+    {
+        errno = 0;
+        const struct dirent * const dir_entry = readdir(host_dir);
+        if(dir_entry == NULL)
+        {
+            if(errno != 0)
+                return errno_result(errno);
+            break;
+        }
+
+        if(!strcmp(dir_entry->d_name, ".") || !strcmp(dir_entry->d_name, ".."))
+            continue;
+
+        fill_dir_entry(&entries[filled++], host_dir, dir_entry->d_name);
+    }
+
+    *read = filled;
+    return 0;
+}
+
+static Result backend_close_dir(Handle dir)
+{
+    if(dir < VFS_DIR_HANDLE_BASE || dir >= VFS_DIR_HANDLE_BASE + VFS_MAX_DIRS || open_dirs[dir - VFS_DIR_HANDLE_BASE] == NULL)
+        return VFS_RES_BAD_HANDLE;
+
+    closedir(open_dirs[dir - VFS_DIR_HANDLE_BASE]);
+    open_dirs[dir - VFS_DIR_HANDLE_BASE] = NULL;
+    return 0;
+}
+
+#endif
+
+// the calls worth accounting for go through here on both backends
+
+Result vfs_open_file(Handle * file, FS_Archive archive, FS_Path path, u32 flags)
+{
+    IOSTATS_START();
+    const Result res = backend_open_file(file, archive, path, flags);
+    IOSTATS_RECORD(IOSTATS_OP_OPEN, archive, 0);
+    if(R_SUCCEEDED(res))
+        iostats_track_handle(*file, archive);
+    return res;
+}
+
+Result vfs_close(Handle file)
+{
+    iostats_untrack_handle(file);
+    return backend_close(file);
+}
+
+Result vfs_read(Handle file, u32 * read, u64 offset, void * buf, u32 size)
+{
+    IOSTATS_START();
+    u32 done = 0;
+    const Result res = backend_read(file, &done, offset, buf, size);
+    IOSTATS_RECORD_HANDLE(IOSTATS_OP_READ, file, done);
+    if(read != NULL)
+        *read = done;
+    return res;
+}
+
+Result vfs_write(Handle file, u32 * written, u64 offset, const void * buf, u32 size, u32 flags)
+{
+    IOSTATS_START();
+    u32 done = 0;
+    const Result res = backend_write(file, &done, offset, buf, size, flags);
+    IOSTATS_RECORD_HANDLE(IOSTATS_OP_WRITE, file, done);
+    if(written != NULL)
+        *written = done;
+    return res;
+}
+
+Result vfs_create_file(FS_Archive archive, FS_Path path, u64 size)
+{
+    IOSTATS_START();
+    const Result res = backend_create_file(archive, path, size);
+    IOSTATS_RECORD(IOSTATS_OP_CREATE, archive, 0);
+    return res;
+}
+
+Result vfs_delete_file(FS_Archive archive, FS_Path path)
+{
+    IOSTATS_START();
+    const Result res = backend_delete_file(archive, path);
+    IOSTATS_RECORD(IOSTATS_OP_DELETE, archive, 0);
+    return res;
+}
+
+Result vfs_read_dir(Handle dir, u32 * read, u32 count, FS_DirectoryEntry * entries)
+{
+    IOSTATS_START();
+    const Result res = backend_read_dir(dir, read, count, entries);
+    IOSTATS_RECORD_HANDLE(IOSTATS_OP_READ_DIR, dir, 0);
+    return res;
+}
+
+Result vfs_open_dir(Handle * dir, FS_Archive archive, FS_Path path)
+{
+    const Result res = backend_open_dir(dir, archive, path);
+    if(R_SUCCEEDED(res))
+        iostats_track_handle(*dir, archive);
+    return res;
+}
+
+Result vfs_close_dir(Handle dir)
+{
+    iostats_untrack_handle(dir);
+    return backend_close_dir(dir);
+}
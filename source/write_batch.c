@@ -0,0 +1,156 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "write_batch.h"
+#include "vfs.h"
+
+void write_batch_begin(Write_Batch_s * batch, Handle handle)
+{
+    memset(batch, 0, sizeof(Write_Batch_s));
+    batch->handle = handle;
+}
+
+// the segments are only allocated once there's a write small enough to stage
+static bool alloc_segments(Write_Batch_s * batch)
+{
+    if(batch->buf != NULL)
+        return true;
+    if(batch->write_through)
+        return false;
+
+    batch->buf = malloc(WRITE_BATCH_SEGMENTS * WRITE_BATCH_SEGMENT_SIZE);
+    if(batch->buf == NULL)
+    {
+        DEBUG("No memory to batch writes, writing through\n");
+        batch->write_through = true;
+        return false;
+    }
+
+    for(u32 i = 0; i < WRITE_BATCH_SEGMENTS; ++i)
+        batch->segments[i].buf = batch->buf + i * WRITE_BATCH_SEGMENT_SIZE;
+    return true;
+}
+
+static void write_out(Write_Batch_s * batch, Write_Batch_Segment_s * segment)
+{
+    if(segment->len == 0)
+        return;
+
+    Result res = vfs_write(batch->handle, NULL, segment->start, segment->buf, segment->len, 0);
+    if(R_FAILED(res) && R_SUCCEEDED(batch->res))
+        batch->res = res;
+    segment->len = 0;
+}
+
+static bool overlaps(const Write_Batch_Segment_s * segment, u64 offset, u32 size)
+{
+    return segment->len != 0 && offset < segment->start + segment->len && segment->start < offset + size;
+}
+
+Result write_batch_write(Write_Batch_s * batch, u64 offset, const void * data, u32 size)
+{
+    if(size == 0)
+        return batch->res;
+
+    // a segment that the write appends to or lands in
+    Write_Batch_Segment_s * target = NULL;
+    if(size < WRITE_BATCH_SEGMENT_SIZE && alloc_segments(batch))
+    {
+        for(u32 i = 0; i < WRITE_BATCH_SEGMENTS; ++i)
+        {
+            Write_Batch_Segment_s * const segment = &batch->segments[i];
+            if(segment->len != 0 && offset >= segment->start && offset <= segment->start + segment->len)
+            {
+                target = segment;
+                break;
+            }
+        }
+    }
+
+    // any other staged data this covers has to go out first, or it would land on top of this later
+    for(u32 i = 0; batch->buf != NULL && i < WRITE_BATCH_SEGMENTS; ++i)
+    {
+        Write_Batch_Segment_s * const segment = &batch->segments[i];
+        if(segment != target && overlaps(segment, offset, size))
+            write_out(batch, segment);
+    }
+
+    if(batch->buf == NULL || size >= WRITE_BATCH_SEGMENT_SIZE)
+    {
+        Result res = vfs_write(batch->handle, NULL, offset, data, size, 0);
+        if(R_FAILED(res) && R_SUCCEEDED(batch->res))
+            batch->res = res;
+        return batch->res;
+    }
+
+    if(target != NULL && offset + size > target->start + WRITE_BATCH_SEGMENT_SIZE)
+    {
+        write_out(batch, target);
+        target->start = offset;
+    }
+
+    if(target == NULL)
+    {
+        // a free segment, or the least recently used one
+        target = &batch->segments[0];
+        for(u32 i = 0; i < WRITE_BATCH_SEGMENTS && target->len != 0; ++i)
+        {
+            Write_Batch_Segment_s * const segment = &batch->segments[i];
+            if(segment->len == 0 || segment->last_use < target->last_use)
+                target = segment;
+        }
+        write_out(batch, target);
+        target->start = offset;
+    }
+
+    const u32 position = offset - target->start;
+    memcpy(target->buf + position, data, size);
+    if(position + size > target->len)
+        target->len = position + size;
+    target->last_use = ++batch->use_counter;
+
+    return batch->res;
+}
+
+Result write_batch_commit(Write_Batch_s * batch)
+{
+    for(u32 i = 0; batch->buf != NULL && i < WRITE_BATCH_SEGMENTS; ++i)
+        write_out(batch, &batch->segments[i]);
+
+    Result res = vfs_flush(batch->handle);
+    if(R_FAILED(res) && R_SUCCEEDED(batch->res))
+        batch->res = res;
+
+    res = batch->res;
+    write_batch_abort(batch);
+    return res;
+}
+
+void write_batch_abort(Write_Batch_s * batch)
+{
+    free(batch->buf);
+    memset(batch, 0, sizeof(Write_Batch_s));
+}
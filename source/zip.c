@@ -0,0 +1,453 @@
+/*
+*   This file is part of Anemone3DS
+*   Copyright (C) 2016-2024 Contributors in CONTRIBUTORS.md
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "zip.h"
+#include "vfs.h"
+
+#include <strings.h>
+#include <zlib.h>
+
+#define ZIP_EOCD_SIGNATURE 0x06054B50
+#define ZIP_CENTRAL_SIGNATURE 0x02014B50
+#define ZIP_LOCAL_SIGNATURE 0x04034B50
+
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CENTRAL_SIZE 46
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_MAX_COMMENT 0xFFFF
+
+#define ZIP_METHOD_STORED 0
+#define ZIP_METHOD_DEFLATE 8
+#define ZIP_FLAG_ENCRYPTED 0x0001
+
+#define ZIP_READ_CHUNK 0x4000
+#define ZIP_COPY_CHUNK 0x40000
+
+static inline u16 read16(const u8 * p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline u32 read32(const u8 * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static Result read_at(Handle handle, u64 offset, void * buf, u32 size)
+{
+    u32 read = 0;
+    Result res = vfs_read(handle, &read, offset, buf, size);
+    if(R_SUCCEEDED(res) && read != size)
+        res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SIZE);
+    return res;
+}
+
+static Result parse_central_directory(Zip_s * zip, const u8 * cd, u32 cd_size, u32 count)
+{
+    u32 names_size = 0;
+    u32 pos = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        if(pos + ZIP_CENTRAL_SIZE > cd_size || read32(cd + pos) != ZIP_CENTRAL_SIGNATURE)
+            return MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SELECTION);
+        names_size += read16(cd + pos + 28) + 1;
+        pos += ZIP_CENTRAL_SIZE + read16(cd + pos + 28) + read16(cd + pos + 30) + read16(cd + pos + 32);
+    }
+    if(pos > cd_size)
+        return MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SELECTION);
+
+    zip->entries = malloc(count * sizeof(Zip_Entry_s));
+    zip->names = malloc(names_size);
+    if((count != 0 && zip->entries == NULL) || zip->names == NULL)
+        return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+    u32 name_pos = 0;
+    pos = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+        const u8 * record = cd + pos;
+        Zip_Entry_s * entry = &zip->entries[i];
+
+        entry->flags = read16(record + 8);
+        entry->method = read16(record + 10);
+        entry->crc = read32(record + 16);
+        entry->compressed_size = read32(record + 20);
+        entry->size = read32(record + 24);
+        entry->name_length = read16(record + 28);
+        entry->local_header_offset = read32(record + 42);
+        entry->name_offset = name_pos;
+
+        memcpy(zip->names + name_pos, record + ZIP_CENTRAL_SIZE, entry->name_length);
+        zip->names[name_pos + entry->name_length] = '\0';
+        name_pos += entry->name_length + 1;
+
+        pos += ZIP_CENTRAL_SIZE + entry->name_length + read16(record + 30) + read16(record + 32);
+    }
+
+    zip->entries_count = count;
+    return 0;
+}
+
+// Reads the central directory once so members can be found without going through the ones before them.
+// Fails on anything that isn't a plain zip (zip64, split archives), leaving those to libarchive
+Result zip_open(Zip_s * zip, FS_Archive archive, FS_Path path)
+{
+    memset(zip, 0, sizeof(Zip_s));
+
+    Result res = 0;
+    if(R_FAILED(res = vfs_open_file(&zip->handle, archive, path, FS_OPEN_READ)))
+        return res;
+
+    u8 * tail = NULL;
+    u8 * cd = NULL;
+
+    u64 file_size = 0;
+    if(R_FAILED(res = vfs_get_size(zip->handle, &file_size)))
+        goto end;
+    if(file_size < ZIP_EOCD_SIZE || file_size > 0xFFFFFFFF)
+    {
+        res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SIZE);
+        goto end;
+    }
+
+    // the end of central directory record is followed by a comment of up to 64KiB
+    const u32 tail_size = file_size < ZIP_EOCD_SIZE + ZIP_MAX_COMMENT ? file_size : ZIP_EOCD_SIZE + ZIP_MAX_COMMENT;
+    tail = malloc(tail_size);
+    if(tail == NULL)
+    {
+        res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+        goto end;
+    }
+    if(R_FAILED(res = read_at(zip->handle, file_size - tail_size, tail, tail_size)))
+        goto end;
+
+    const u8 * eocd = NULL;
+    for(s32 i = tail_size - ZIP_EOCD_SIZE; i >= 0; i--)
+    {
+        if(read32(tail + i) == ZIP_EOCD_SIGNATURE)
+        {
+            eocd = tail + i;
+            break;
+        }
+    }
+
+    // multiple disks and zip64 (which marks the fields it overrides with all ones) aren't handled here
+    if(eocd == NULL || read16(eocd + 4) != 0 || read16(eocd + 6) != 0
+        || read16(eocd + 8) != read16(eocd + 10) || read16(eocd + 10) == 0xFFFF
+        || read32(eocd + 12) == 0xFFFFFFFF || read32(eocd + 16) == 0xFFFFFFFF)
+    {
+        DEBUG("No usable end of central directory record\n");
+        res = MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_APPLICATION, RD_NOT_IMPLEMENTED);
+        goto end;
+    }
+
+    const u32 count = read16(eocd + 10);
+    const u32 cd_size = read32(eocd + 12);
+    const u32 cd_offset = read32(eocd + 16);
+    if((u64)cd_offset + cd_size > file_size)
+    {
+        res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SIZE);
+        goto end;
+    }
+
+    cd = malloc(cd_size);
+    if(cd_size != 0 && cd == NULL)
+    {
+        res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+        goto end;
+    }
+    if(R_FAILED(res = read_at(zip->handle, cd_offset, cd, cd_size)))
+        goto end;
+
+    res = parse_central_directory(zip, cd, cd_size, count);
+
+end:
+    free(cd);
+    free(tail);
+    if(R_FAILED(res))
+        zip_close(zip);
+    return res;
+}
+
+void zip_close(Zip_s * zip)
+{
+    if(zip->handle)
+        vfs_close(zip->handle);
+    free(zip->entries);
+    free(zip->names);
+    memset(zip, 0, sizeof(Zip_s));
+}
+
+// Same matching as libarchive was used with: the full path in the zip, ignoring case
+const Zip_Entry_s * zip_find(const Zip_s * zip, const char * name)
+{
+    for(u32 i = 0; i < zip->entries_count; i++)
+    {
+        const Zip_Entry_s * entry = &zip->entries[i];
+        if(!strcasecmp(zip->names + entry->name_offset, name))
+            return entry;
+    }
+
+    return NULL;
+}
+
+bool zip_entry_supported(const Zip_Entry_s * entry)
+{
+    if(entry->flags & ZIP_FLAG_ENCRYPTED)
+        return false;
+    if(entry->method == ZIP_METHOD_STORED)
+        return entry->compressed_size == entry->size;
+    return entry->method == ZIP_METHOD_DEFLATE;
+}
+
+// the local extra field doesn't have to match the central directory one, so the data offset comes from the local header
+static u32 get_data_offset(const Zip_s * zip, const Zip_Entry_s * entry)
+{
+    u8 local[ZIP_LOCAL_SIZE];
+    if(R_FAILED(read_at(zip->handle, entry->local_header_offset, local, ZIP_LOCAL_SIZE)) || read32(local) != ZIP_LOCAL_SIGNATURE)
+    {
+        DEBUG("Invalid local header\n");
+        return 0;
+    }
+
+    return entry->local_header_offset + ZIP_LOCAL_SIZE + read16(local + 26) + read16(local + 28);
+}
+
+// Inflates into out when it's given, otherwise into a chunk that's written to dest each time it fills up
+static bool inflate_entry(Handle handle, u32 offset, const Zip_Entry_s * entry, u8 * out, Handle dest, u64 dest_offset, u32 * crc)
+{
+    u8 * chunk = malloc(ZIP_READ_CHUNK);
+    u8 * out_chunk = out == NULL ? malloc(ZIP_COPY_CHUNK) : NULL;
+    if(chunk == NULL || (out == NULL && out_chunk == NULL))
+    {
+        free(out_chunk);
+        free(chunk);
+        return false;
+    }
+
+    z_stream stream = {0};
+    if(inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    {
+        free(out_chunk);
+        free(chunk);
+        return false;
+    }
+
+    stream.next_out = out != NULL ? out : out_chunk;
+    stream.avail_out = out != NULL ? entry->size : ZIP_COPY_CHUNK;
+
+    int ret = Z_OK;
+    u32 consumed = 0;
+    bool ok = true;
+    while(ok && ret == Z_OK)
+    {
+        if(stream.avail_in == 0)
+        {
+            if(consumed == entry->compressed_size)
+                break;
+
+            const u32 len = min(entry->compressed_size - consumed, ZIP_READ_CHUNK);
+            if(R_FAILED(read_at(handle, offset + consumed, chunk, len)))
+                break;
+            consumed += len;
+
+            stream.next_in = chunk;
+            stream.avail_in = len;
+        }
+
+        ret = inflate(&stream, Z_NO_FLUSH);
+
+        if(out == NULL && (stream.avail_out == 0 || ret == Z_STREAM_END))
+        {
+            const u32 len = ZIP_COPY_CHUNK - stream.avail_out;
+            *crc = crc32(*crc, out_chunk, len);
+            ok = R_SUCCEEDED(vfs_write(dest, NULL, dest_offset, out_chunk, len, ret == Z_STREAM_END ? FS_WRITE_FLUSH : 0));
+            dest_offset += len;
+
+            stream.next_out = out_chunk;
+            stream.avail_out = ZIP_COPY_CHUNK;
+        }
+    }
+
+    ok = ok && ret == Z_STREAM_END && stream.total_out == entry->size;
+    inflateEnd(&stream);
+    free(out_chunk);
+    free(chunk);
+    return ok;
+}
+
+// Reads and decompresses a single member into out, which has to fit entry->size bytes.
+// Stored members are read straight into it
+bool zip_read_into(const Zip_s * zip, const Zip_Entry_s * entry, u8 * out)
+{
+    if(!zip_entry_supported(entry))
+        return false;
+
+    const u32 data_offset = get_data_offset(zip, entry);
+    if(data_offset == 0)
+        return false;
+
+    bool ok;
+    if(entry->method == ZIP_METHOD_STORED)
+        ok = R_SUCCEEDED(read_at(zip->handle, data_offset, out, entry->size));
+    else
+        ok = inflate_entry(zip->handle, data_offset, entry, out, 0, 0, NULL);
+
+    if(ok && crc32(0, out, entry->size) != entry->crc)
+    {
+        DEBUG("CRC mismatch\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+// Reads and decompresses a single member, returns its size or 0 on failure
+u32 zip_read(const Zip_s * zip, const Zip_Entry_s * entry, char ** buf)
+{
+    *buf = NULL;
+    if(!zip_entry_supported(entry) || entry->size == 0)
+        return 0;
+
+    u8 * out = malloc(entry->size);
+    if(out == NULL)
+    {
+        DEBUG("Error allocating buffer - out of memory??\n");
+        return 0;
+    }
+
+    if(!zip_read_into(zip, entry, out))
+    {
+        free(out);
+        return 0;
+    }
+
+    *buf = (char *)out;
+    return entry->size;
+}
+
+// Reads a deflated member as it is in the zip, so it can be decompressed later with zip_inflate without the file.
+// Returns the compressed size, or 0 on failure and for members that aren't deflated
+u32 zip_read_compressed(const Zip_s * zip, const Zip_Entry_s * entry, char ** buf)
+{
+    *buf = NULL;
+    if(!zip_entry_supported(entry) || entry->method != ZIP_METHOD_DEFLATE || entry->compressed_size == 0)
+        return 0;
+
+    const u32 data_offset = get_data_offset(zip, entry);
+    if(data_offset == 0)
+        return 0;
+
+    u8 * compressed = malloc(entry->compressed_size);
+    if(compressed == NULL)
+    {
+        DEBUG("Error allocating buffer - out of memory??\n");
+        return 0;
+    }
+
+    if(R_FAILED(read_at(zip->handle, data_offset, compressed, entry->compressed_size)))
+    {
+        free(compressed);
+        return 0;
+    }
+
+    *buf = (char *)compressed;
+    return entry->compressed_size;
+}
+
+// Decompresses what zip_read_compressed returned for entry into out, which has to fit entry->size bytes
+bool zip_inflate(const Zip_Entry_s * entry, const u8 * compressed, u8 * out)
+{
+    z_stream stream = {0};
+    if(inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+
+    stream.next_in = (u8 *)compressed;
+    stream.avail_in = entry->compressed_size;
+    stream.next_out = out;
+    stream.avail_out = entry->size;
+
+    bool ok = inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.total_out == entry->size;
+    inflateEnd(&stream);
+
+    if(ok && crc32(0, out, entry->size) != entry->crc)
+    {
+        DEBUG("CRC mismatch\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+// Writes a single member to dest at dest_offset without ever having all of it in memory.
+// Stored members are read in big chunks aligned on their position in the zip
+bool zip_copy_to_file(const Zip_s * zip, const Zip_Entry_s * entry, Handle dest, u64 dest_offset)
+{
+    if(!zip_entry_supported(entry))
+        return false;
+
+    const u32 data_offset = get_data_offset(zip, entry);
+    if(data_offset == 0)
+        return false;
+
+    u32 crc = 0;
+    bool ok = true;
+    if(entry->method == ZIP_METHOD_STORED)
+    {
+        u8 * chunk = malloc(ZIP_COPY_CHUNK);
+        if(chunk == NULL)
+            return false;
+
+        u32 copied = 0;
+        while(ok && copied < entry->size)
+        {
+            const u32 aligned_end = ((data_offset + copied) & ~(ZIP_COPY_CHUNK - 1)) + ZIP_COPY_CHUNK;
+            const u32 len = min(entry->size - copied, aligned_end - (data_offset + copied));
+            ok = R_SUCCEEDED(read_at(zip->handle, data_offset + copied, chunk, len));
+            if(ok)
+            {
+                crc = crc32(crc, chunk, len);
+                copied += len;
+                ok = R_SUCCEEDED(vfs_write(dest, NULL, dest_offset, chunk, len, copied == entry->size ? FS_WRITE_FLUSH : 0));
+                dest_offset += len;
+            }
+        }
+
+        free(chunk);
+    }
+    else
+    {
+        ok = inflate_entry(zip->handle, data_offset, entry, NULL, dest, dest_offset, &crc);
+    }
+
+    if(ok && crc != entry->crc)
+    {
+        DEBUG("CRC mismatch\n");
+        ok = false;
+    }
+
+    return ok;
+}